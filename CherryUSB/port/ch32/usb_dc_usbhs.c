@@ -1,5 +1,7 @@
 #include "usbd_core.h"
 #include "usb_ch32_usbhs_reg.h"
+#include "ry_prof.h"
+#include "ry_ramfunc.h"
 
 #ifndef USBD_IRQHandler
 #define USBD_IRQHandler USBHS_IRQHandler //use actual usb irq name instead
@@ -38,7 +40,7 @@ struct ch32_usbhs_udc {
     struct ch32_usbhs_ep_state out_ep[USB_NUM_BIDIR_ENDPOINTS]; /*!< OUT endpoint parameters */
 } g_ch32_usbhs_udc;
 
-void USBHS_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+void USBHS_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast"))) RY_RAMFUNC;
 
 volatile uint8_t mps_over_flag = 0;
 volatile bool ep0_rx_data_toggle;
@@ -165,7 +167,7 @@ int usbd_ep_is_stalled(const uint8_t ep, uint8_t *stalled)
     return 0;
 }
 
-int usbd_ep_start_write(const uint8_t ep, const uint8_t *data, uint32_t data_len)
+RY_RAMFUNC int usbd_ep_start_write(const uint8_t ep, const uint8_t *data, uint32_t data_len)
 {
     uint8_t ep_idx = USB_EP_GET_IDX(ep);
     uint32_t tmp;
@@ -211,7 +213,7 @@ int usbd_ep_start_write(const uint8_t ep, const uint8_t *data, uint32_t data_len
     return 0;
 }
 
-int usbd_ep_start_read(const uint8_t ep, uint8_t *data, uint32_t data_len)
+RY_RAMFUNC int usbd_ep_start_read(const uint8_t ep, uint8_t *data, uint32_t data_len)
 {
     uint8_t ep_idx = USB_EP_GET_IDX(ep);
 
@@ -249,6 +251,7 @@ void USBD_IRQHandler(void)
 {
     uint32_t ep_idx, token, write_count, read_count;
     uint8_t intflag = 0;
+    RY_PROF_BEGIN(RY_PROF_USB_IRQ);
 
     intflag = USBHS_DEVICE->INT_FG;//1.жϱ־Ĵȡжͣ//Ӽ⣩
 
@@ -294,28 +297,26 @@ void USBD_IRQHandler(void)
                 }
             } else//2.1.2 Ƕ˵0
              {
-                USB_SET_TX_CTRL(ep_idx, (USB_GET_TX_CTRL(ep_idx) & ~(USBHS_EP_T_RES_MASK | USBHS_EP_T_TOG_MASK)) | USBHS_EP_T_RES_NAK | USBHS_EP_T_TOG_0);
-
-                if (g_ch32_usbhs_udc.in_ep[ep_idx].xfer_len > g_ch32_usbhs_udc.in_ep[ep_idx].ep_mps) {
-                    g_ch32_usbhs_udc.in_ep[ep_idx].xfer_buf += g_ch32_usbhs_udc.in_ep[ep_idx].ep_mps;
-                    g_ch32_usbhs_udc.in_ep[ep_idx].xfer_len -= g_ch32_usbhs_udc.in_ep[ep_idx].ep_mps;
-                    g_ch32_usbhs_udc.in_ep[ep_idx].actual_xfer_len += g_ch32_usbhs_udc.in_ep[ep_idx].ep_mps;
-                    epx_tx_data_toggle[ep_idx - 1] ^= 1;
-
-                    write_count = MIN(g_ch32_usbhs_udc.in_ep[ep_idx].xfer_len, g_ch32_usbhs_udc.in_ep[ep_idx].ep_mps);
+                //USBHS_INT_BUSY_ENжϱ־ǰظNAK
+                //мİдNAKֱӸ³ȡDMAtoggle
+                struct ch32_usbhs_ep_state *in_ep = &g_ch32_usbhs_udc.in_ep[ep_idx];
+                uint32_t tmp = USB_GET_TX_CTRL(ep_idx) & ~(USBHS_EP_T_RES_MASK | USBHS_EP_T_TOG_MASK);
+
+                epx_tx_data_toggle[ep_idx - 1] ^= 1;
+                if (in_ep->xfer_len > in_ep->ep_mps) {
+                    in_ep->xfer_buf += in_ep->ep_mps;
+                    in_ep->xfer_len -= in_ep->ep_mps;
+                    in_ep->actual_xfer_len += in_ep->ep_mps;
+
+                    write_count = MIN(in_ep->xfer_len, in_ep->ep_mps);
                     USB_SET_TX_LEN(ep_idx, write_count);
-                    USB_SET_TX_DMA(ep_idx, (uint32_t)g_ch32_usbhs_udc.in_ep[ep_idx].xfer_buf);
-
-                    uint32_t tmp = USB_GET_TX_CTRL(ep_idx);
-                    tmp &= ~(USBHS_EP_T_RES_MASK | USBHS_EP_T_TOG_MASK);
-                    tmp |= USBHS_EP_T_RES_ACK;
-                    tmp |= (epx_tx_data_toggle[ep_idx - 1] ? USBHS_EP_T_TOG_1 : USBHS_EP_T_TOG_0);
-                    USB_SET_TX_CTRL(ep_idx, tmp);
+                    USB_SET_TX_DMA(ep_idx, (uint32_t)in_ep->xfer_buf);
+                    USB_SET_TX_CTRL(ep_idx, tmp | USBHS_EP_T_RES_ACK | (epx_tx_data_toggle[ep_idx - 1] ? USBHS_EP_T_TOG_1 : USBHS_EP_T_TOG_0));
                 } else {
-                    g_ch32_usbhs_udc.in_ep[ep_idx].actual_xfer_len += g_ch32_usbhs_udc.in_ep[ep_idx].xfer_len;
-                    g_ch32_usbhs_udc.in_ep[ep_idx].xfer_len = 0;
-                    epx_tx_data_toggle[ep_idx - 1] ^= 1;
-                    usbd_event_ep_in_complete_handler(ep_idx | 0x80, g_ch32_usbhs_udc.in_ep[ep_idx].actual_xfer_len);
+                    USB_SET_TX_CTRL(ep_idx, tmp | USBHS_EP_T_RES_NAK);
+                    in_ep->actual_xfer_len += in_ep->xfer_len;
+                    in_ep->xfer_len = 0;
+                    usbd_event_ep_in_complete_handler(ep_idx | 0x80, in_ep->actual_xfer_len);
                 }
             }
         } else if (token == PID_OUT) //2.2 OUT ƴݣ
@@ -339,18 +340,19 @@ void USBD_IRQHandler(void)
                 }
             } else {
                 if (USBHS_DEVICE->INT_ST & USBHS_DEV_UIS_TOG_OK) {
-                    USB_SET_RX_CTRL(ep_idx, (USB_GET_RX_CTRL(ep_idx) & ~USBHS_EP_R_RES_MASK) | USBHS_EP_R_RES_NAK);
-                    read_count = USBHS_DEVICE->RX_LEN;
+                    //ͬINмİֻDMAַRESACKɲNAKصһ
+                    struct ch32_usbhs_ep_state *out_ep = &g_ch32_usbhs_udc.out_ep[ep_idx];
 
-                    g_ch32_usbhs_udc.out_ep[ep_idx].xfer_buf += read_count;
-                    g_ch32_usbhs_udc.out_ep[ep_idx].actual_xfer_len += read_count;
-                    g_ch32_usbhs_udc.out_ep[ep_idx].xfer_len -= read_count;
+                    read_count = USBHS_DEVICE->RX_LEN;
+                    out_ep->xfer_buf += read_count;
+                    out_ep->actual_xfer_len += read_count;
+                    out_ep->xfer_len -= read_count;
 
-                    if ((read_count < g_ch32_usbhs_udc.out_ep[ep_idx].ep_mps) || (g_ch32_usbhs_udc.out_ep[ep_idx].xfer_len == 0)) {
-                        usbd_event_ep_out_complete_handler(ep_idx, g_ch32_usbhs_udc.out_ep[ep_idx].actual_xfer_len);
+                    if ((read_count < out_ep->ep_mps) || (out_ep->xfer_len == 0)) {
+                        USB_SET_RX_CTRL(ep_idx, (USB_GET_RX_CTRL(ep_idx) & ~USBHS_EP_R_RES_MASK) | USBHS_EP_R_RES_NAK);
+                        usbd_event_ep_out_complete_handler(ep_idx, out_ep->actual_xfer_len);
                     } else {
-                        USB_SET_RX_DMA(ep_idx, (uint32_t)g_ch32_usbhs_udc.out_ep[ep_idx].xfer_buf);
-                        USB_SET_RX_CTRL(ep_idx, (USB_GET_RX_CTRL(ep_idx) & ~USBHS_EP_R_RES_MASK) | USBHS_EP_R_RES_ACK);
+                        USB_SET_RX_DMA(ep_idx, (uint32_t)out_ep->xfer_buf);
                     }
                 }
             }
@@ -384,4 +386,5 @@ void USBD_IRQHandler(void)
         USBHS_DEVICE->UEP0_RX_CTRL = USBHS_EP_R_RES_ACK;// EP0 տƼĴΪ ACK ״̬
         USBHS_DEVICE->INT_FG = USBHS_DETECT_FLAG;// USB жϱ־ǰжϴ
     }
+    RY_PROF_END(RY_PROF_USB_IRQ);
 }
@@ -156,6 +156,36 @@ __attribute__( ( always_inline ) ) RV_STATIC_INLINE void __NOP()
   __asm volatile ("nop");
 }
 
+/*********************************************************************
+ * @fn      __get_MCYCLE
+ *
+ * @brief   Return the Machine Cycle Counter Register (low 32 bits)
+ *
+ * @return  mcycle value
+ */
+__attribute__( ( always_inline ) ) RV_STATIC_INLINE uint32_t __get_MCYCLE(void)
+{
+  uint32_t result;
+
+  __asm volatile ("csrr %0, mcycle" : "=r" (result));
+  return (result);
+}
+
+/*********************************************************************
+ * @fn      __get_MINSTRET
+ *
+ * @brief   Return the Machine Instructions-Retired Counter Register (low 32 bits)
+ *
+ * @return  minstret value
+ */
+__attribute__( ( always_inline ) ) RV_STATIC_INLINE uint32_t __get_MINSTRET(void)
+{
+  uint32_t result;
+
+  __asm volatile ("csrr %0, minstret" : "=r" (result));
+  return (result);
+}
+
 /*********************************************************************
  * @fn      NVIC_EnableIRQ
  *
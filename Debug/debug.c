@@ -14,6 +14,7 @@
 
 static uint8_t p_us = 0;
 static uint16_t p_ms = 0;
+static uint32_t p_baudrate = 0;
 
 /*********************************************************************
  * @fn      Delay_Init
@@ -116,6 +117,7 @@ void USART_Printf_Init (uint32_t baudrate) {
 
 #endif
 
+    p_baudrate = baudrate;
     USART_InitStructure.USART_BaudRate = baudrate;
     USART_InitStructure.USART_WordLength = USART_WordLength_8b;
     USART_InitStructure.USART_StopBits = USART_StopBits_1;
@@ -138,6 +140,26 @@ void USART_Printf_Init (uint32_t baudrate) {
 #endif
 }
 
+/*********************************************************************
+ * @fn      USART_Printf_Update
+ *
+ * @brief   Recalculate the baud rate after the system clock changed.
+ *          Wait for the last byte to be sent before calling.
+ *
+ * @return  None
+ */
+void USART_Printf_Update (void) {
+    USART_InitTypeDef USART_InitStructure;
+
+    USART_InitStructure.USART_BaudRate = p_baudrate;
+    USART_InitStructure.USART_WordLength = USART_WordLength_8b;
+    USART_InitStructure.USART_StopBits = USART_StopBits_1;
+    USART_InitStructure.USART_Parity = USART_Parity_No;
+    USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    USART_InitStructure.USART_Mode = USART_Mode_Tx;
+    USART_Init (DEBUG_USART, &USART_InitStructure);
+}
+
 /*********************************************************************
  * @fn      _write
  *
@@ -153,6 +175,8 @@ __attribute__ ((used)) int _write (int fd, char *buf, int size) {
 #ifdef RY_NO_DEBUG
     return 1;
 #endif
+    while (DEBUG_DMA_TX_CH->CNTR != 0)  // wait for ry_log DMA output
+        ;
     for (i = 0; i < size; i++) {
 #if (DEBUG == DEBUG_UART1)
         while (USART_GetFlagStatus (USART1, USART_FLAG_TC) == RESET)
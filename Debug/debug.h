@@ -32,10 +32,23 @@
 
 //#define RY_NO_DEBUG  //еϢ
 
+/* DEBUG UART TX DMAry_log̨ͣprintfǰȴDMA */
+#if (DEBUG == DEBUG_UART1)
+#define DEBUG_USART         USART1
+#define DEBUG_DMA_TX_CH     DMA1_Channel4
+#elif (DEBUG == DEBUG_UART2)
+#define DEBUG_USART         USART2
+#define DEBUG_DMA_TX_CH     DMA1_Channel7
+#elif (DEBUG == DEBUG_UART3)
+#define DEBUG_USART         USART3
+#define DEBUG_DMA_TX_CH     DMA1_Channel2
+#endif
+
 void Delay_Init(void);
 void Delay_Us (uint32_t n);
 void Delay_Ms (uint32_t n);
 void USART_Printf_Init(uint32_t baudrate);
+void USART_Printf_Update(void);
 
 #ifdef __cplusplus
 }
@@ -6,6 +6,19 @@
  */
 
 #include "hid_custom.h"
+#include "user_fatfs.h"
+#include "iap.h"
+#include "ry_log.h"
+#include "ry_prof.h"
+#include "bsp_spi_flash.h"
+#include "ry_lz.h"
+#include "ry_delta.h"
+#include "ry_journal.h"
+#include "ry_crc.h"
+#include "ry_boot.h"
+#include "ry_clock.h"
+#include "ry_event.h"
+#include "ry_ramfunc.h"
 
 /*!< hidraw in endpoint */
 #define HIDRAW_IN_EP 0x81
@@ -25,6 +38,15 @@
 #define HIDRAW_OUT_EP_SIZE 64
 #define HIDRAW_OUT_EP_INTERVAL 10
 #endif
+/*!< vendor(WinUSB) bulk endpointHIDʹͬV2Э֡ */
+#define VENDOR_IN_EP 0x83
+#define VENDOR_OUT_EP 0x03
+#ifdef CONFIG_USB_HS
+#define VENDOR_EP_SIZE 512
+#else
+#define VENDOR_EP_SIZE 64
+#endif
+#define USBD_WINUSB_VENDOR_CODE 0x20
 
 #define USBD_VID 0x0D28
 #define USBD_PID 0x0204
@@ -32,17 +54,17 @@
 #define USBD_LANGID_STRING 1033
 
 /*!< config descriptor size */
-#define USB_HID_CONFIG_DESC_SIZ (9 + 9 + 9 + 7 + 7)
+#define USB_HID_CONFIG_DESC_SIZ (9 + 9 + 9 + 7 + 7 + 9 + 7 + 7)
 
 /*!< custom hid report descriptor size */
-#define HID_CUSTOM_REPORT_DESC_SIZE 38
+#define HID_CUSTOM_REPORT_DESC_SIZE 66
 
 #ifdef CONFIG_USBDEV_ADVANCE_DESC
 static const uint8_t device_descriptor[] = {
-    USB_DEVICE_DESCRIPTOR_INIT (USB_2_0, 0x00, 0x00, 0x00, USBD_VID, USBD_PID, 0x0002, 0x01)};
+    USB_DEVICE_DESCRIPTOR_INIT (USB_2_1, 0x00, 0x00, 0x00, USBD_VID, USBD_PID, 0x0002, 0x01)};
 
 static const uint8_t config_descriptor[] = {
-    USB_CONFIG_DESCRIPTOR_INIT (USB_HID_CONFIG_DESC_SIZ, 0x01, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
+    USB_CONFIG_DESCRIPTOR_INIT (USB_HID_CONFIG_DESC_SIZ, 0x02, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
     /************** Descriptor of Custom interface *****************/
     0x09,                          /* bLength: Interface Descriptor size */
     USB_DESCRIPTOR_TYPE_INTERFACE, /* bDescriptorType: Interface descriptor type */
@@ -77,7 +99,30 @@ static const uint8_t config_descriptor[] = {
     0x03,                         /* bmAttributes: Interrupt endpoint */
     WBVAL (HIDRAW_OUT_EP_SIZE),   /* wMaxPacketSize: 4 Byte max */
     HIDRAW_OUT_EP_INTERVAL,       /* bInterval: Polling Interval */
-    /* 73 */
+    /************** Descriptor of Vendor(WinUSB) interface *****************/
+    0x09,                          /* bLength: Interface Descriptor size */
+    USB_DESCRIPTOR_TYPE_INTERFACE, /* bDescriptorType: Interface descriptor type */
+    0x01,                          /* bInterfaceNumber: Number of Interface */
+    0x00,                          /* bAlternateSetting: Alternate setting */
+    0x02,                          /* bNumEndpoints */
+    0xFF,                          /* bInterfaceClass: Vendor Specific */
+    0x00,                          /* bInterfaceSubClass */
+    0x00,                          /* nInterfaceProtocol */
+    0,                             /* iInterface: Index of string descriptor */
+    /******************** Descriptor of Vendor in endpoint ********************/
+    0x07,                         /* bLength: Endpoint Descriptor size */
+    USB_DESCRIPTOR_TYPE_ENDPOINT, /* bDescriptorType: */
+    VENDOR_IN_EP,                 /* bEndpointAddress: Endpoint Address (IN) */
+    0x02,                         /* bmAttributes: Bulk endpoint */
+    WBVAL (VENDOR_EP_SIZE),       /* wMaxPacketSize */
+    0x00,                         /* bInterval */
+    /******************** Descriptor of Vendor out endpoint ********************/
+    0x07,                         /* bLength: Endpoint Descriptor size */
+    USB_DESCRIPTOR_TYPE_ENDPOINT, /* bDescriptorType: */
+    VENDOR_OUT_EP,                /* bEndpointAddress: Endpoint Address (OUT) */
+    0x02,                         /* bmAttributes: Bulk endpoint */
+    WBVAL (VENDOR_EP_SIZE),       /* wMaxPacketSize */
+    0x00,                         /* bInterval */
 };
 
 static const uint8_t device_quality_descriptor[] = {
@@ -86,7 +131,7 @@ static const uint8_t device_quality_descriptor[] = {
     ///////////////////////////////////////
     0x0a,
     USB_DESCRIPTOR_TYPE_DEVICE_QUALIFIER,
-    0x00,
+    0x10,
     0x02,
     0x00,
     0x00,
@@ -130,8 +175,8 @@ const struct usb_descriptor hid_descriptor = {
 #else
 /*!< global descriptor */
 static const uint8_t hid_descriptor[] = {
-    USB_DEVICE_DESCRIPTOR_INIT (USB_2_0, 0x00, 0x00, 0x00, USBD_VID, USBD_PID, 0x0002, 0x01),
-    USB_CONFIG_DESCRIPTOR_INIT (USB_HID_CONFIG_DESC_SIZ, 0x01, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
+    USB_DEVICE_DESCRIPTOR_INIT (USB_2_1, 0x00, 0x00, 0x00, USBD_VID, USBD_PID, 0x0002, 0x01),
+    USB_CONFIG_DESCRIPTOR_INIT (USB_HID_CONFIG_DESC_SIZ, 0x02, 0x01, USB_CONFIG_BUS_POWERED, USBD_MAX_POWER),
     /************** Descriptor of Custom interface *****************/
     0x09,                          /* bLength: Interface Descriptor size */
     USB_DESCRIPTOR_TYPE_INTERFACE, /* bDescriptorType: Interface descriptor type */
@@ -166,7 +211,30 @@ static const uint8_t hid_descriptor[] = {
     0x03,                         /* bmAttributes: Interrupt endpoint */
     WBVAL (HIDRAW_OUT_EP_SIZE),   /* wMaxPacketSize: 4 Byte max */
     HIDRAW_OUT_EP_INTERVAL,       /* bInterval: Polling Interval */
-    /* 73 */
+    /************** Descriptor of Vendor(WinUSB) interface *****************/
+    0x09,                          /* bLength: Interface Descriptor size */
+    USB_DESCRIPTOR_TYPE_INTERFACE, /* bDescriptorType: Interface descriptor type */
+    0x01,                          /* bInterfaceNumber: Number of Interface */
+    0x00,                          /* bAlternateSetting: Alternate setting */
+    0x02,                          /* bNumEndpoints */
+    0xFF,                          /* bInterfaceClass: Vendor Specific */
+    0x00,                          /* bInterfaceSubClass */
+    0x00,                          /* nInterfaceProtocol */
+    0,                             /* iInterface: Index of string descriptor */
+    /******************** Descriptor of Vendor in endpoint ********************/
+    0x07,                         /* bLength: Endpoint Descriptor size */
+    USB_DESCRIPTOR_TYPE_ENDPOINT, /* bDescriptorType: */
+    VENDOR_IN_EP,                 /* bEndpointAddress: Endpoint Address (IN) */
+    0x02,                         /* bmAttributes: Bulk endpoint */
+    WBVAL (VENDOR_EP_SIZE),       /* wMaxPacketSize */
+    0x00,                         /* bInterval */
+    /******************** Descriptor of Vendor out endpoint ********************/
+    0x07,                         /* bLength: Endpoint Descriptor size */
+    USB_DESCRIPTOR_TYPE_ENDPOINT, /* bDescriptorType: */
+    VENDOR_OUT_EP,                /* bEndpointAddress: Endpoint Address (OUT) */
+    0x02,                         /* bmAttributes: Bulk endpoint */
+    WBVAL (VENDOR_EP_SIZE),       /* wMaxPacketSize */
+    0x00,                         /* bInterval */
     /*
      * string0 descriptor
      */
@@ -229,7 +297,7 @@ static const uint8_t hid_descriptor[] = {
      */
     0x0a,
     USB_DESCRIPTOR_TYPE_DEVICE_QUALIFIER,
-    0x00,
+    0x10,
     0x02,
     0x00,
     0x00,
@@ -256,6 +324,14 @@ static const uint8_t hid_custom_report_desc[HID_CUSTOM_REPORT_DESC_SIZE] = {
     0x96, 0xff, 0x03, /*   REPORT_COUNT (63) */
     0x81, 0x02,       /*   INPUT (Data,Var,Abs) */
     /* <___________________________________________________> */
+    0x85, 0x03,       /*   REPORT ID (0x03) */
+    0x09, 0x04,       /*   USAGE (Vendor Usage 1) */
+    0x15, 0x00,       /*   LOGICAL_MINIMUM (0) */
+    0x25, 0xff,       /*   LOGICAL_MAXIMUM (255) */
+    0x75, 0x08,       /*   REPORT_SIZE (8) */
+    0x95, 0x0f,       /*   REPORT_COUNT (15) */
+    0x81, 0x02,       /*   INPUT (Data,Var,Abs) */
+    /* <___________________________________________________> */
     0x85, 0x01,       /*   REPORT ID (0x01) */
     0x09, 0x03,       /*   USAGE (Vendor Usage 1) */
     0x15, 0x00,       /*   LOGICAL_MINIMUM (0) */
@@ -263,6 +339,14 @@ static const uint8_t hid_custom_report_desc[HID_CUSTOM_REPORT_DESC_SIZE] = {
     0x75, 0x08,       /*   REPORT_SIZE (8) */
     0x96, 0xff, 0x03, /*   REPORT_COUNT (63) */
     0x91, 0x02,       /*   OUTPUT (Data,Var,Abs) */
+    /* <___________________________________________________> */
+    0x85, 0x04,                /*   REPORT ID (0x04) */
+    0x09, 0x05,                /*   USAGE (Vendor Usage 1) */
+    0x15, 0x00,                /*   LOGICAL_MINIMUM (0) */
+    0x25, 0xff,                /*   LOGICAL_MAXIMUM (255) */
+    0x75, 0x08,                /*   REPORT_SIZE (8) */
+    0x95, RY_PROF_REPORT_SIZE, /*   REPORT_COUNT (96) */
+    0xb1, 0x02,                /*   FEATURE (Data,Var,Abs) */
     /* USER CODE END 0 */
     0xC0 /*     END_COLLECTION	             */
 #else
@@ -278,6 +362,14 @@ static const uint8_t hid_custom_report_desc[HID_CUSTOM_REPORT_DESC_SIZE] = {
     0x75, 0x08,       /*   REPORT_SIZE (8) */
     0x81, 0x02,       /*   INPUT (Data,Var,Abs) */
     /* <___________________________________________________> */
+    0x85, 0x03,       /*   REPORT ID (0x03) */
+    0x09, 0x02,       /*   USAGE (Vendor Usage 1) */
+    0x15, 0x00,       /*   LOGICAL_MINIMUM (0) */
+    0x25, 0xff,       /*   LOGICAL_MAXIMUM (255) */
+    0x95, 0x0f,       /*   REPORT_COUNT (15) */
+    0x75, 0x08,       /*   REPORT_SIZE (8) */
+    0x81, 0x02,       /*   INPUT (Data,Var,Abs) */
+    /* <___________________________________________________> */
     0x85, 0x01,       /*   REPORT ID (0x01) */
     0x09, 0x01,       /*   USAGE (Vendor Usage 1) */
     0x15, 0x00,       /*   LOGICAL_MINIMUM (0) */
@@ -285,20 +377,134 @@ static const uint8_t hid_custom_report_desc[HID_CUSTOM_REPORT_DESC_SIZE] = {
     0x95, 0x40 - 1,   /*   REPORT_COUNT (63) */
     0x75, 0x08,       /*   REPORT_SIZE (8) */
     0x91, 0x02,       /*   OUTPUT (Data,Var,Abs) */
+    /* <___________________________________________________> */
+    0x85, 0x04,                /*   REPORT ID (0x04) */
+    0x09, 0x05,                /*   USAGE (Vendor Usage 1) */
+    0x15, 0x00,                /*   LOGICAL_MINIMUM (0) */
+    0x25, 0xff,                /*   LOGICAL_MAXIMUM (255) */
+    0x75, 0x08,                /*   REPORT_SIZE (8) */
+    0x95, RY_PROF_REPORT_SIZE, /*   REPORT_COUNT (96) */
+    0xb1, 0x02,                /*   FEATURE (Data,Var,Abs) */
     /* USER CODE END 0 */
     0xC0 /*     END_COLLECTION	             */
 #endif
 };
 
-USB_NOCACHE_RAM_SECTION USB_MEM_ALIGNX uint8_t read_buffer[HIDRAW_OUT_EP_SIZE];
+/*!< MS OS 2.0 descriptorvendorӿ(1)WinUSB谲װ */
+#define USBD_WINUSB_DESC_SET_LEN 178
+#define USBD_BOS_DESC_LEN        33
+
+static const uint8_t winusb_desc_set[USBD_WINUSB_DESC_SET_LEN] = {
+    /* Microsoft OS 2.0 descriptor set header */
+    WBVAL (WINUSB_DESCRIPTOR_SET_HEADER_SIZE), WBVAL (WINUSB_SET_HEADER_DESCRIPTOR_TYPE),
+    0x00, 0x00, 0x03, 0x06, /* dwWindowsVersion: Windows 8.1 */
+    WBVAL (USBD_WINUSB_DESC_SET_LEN),
+    /* configuration subset header */
+    WBVAL (8), WBVAL (WINUSB_SUBSET_HEADER_CONFIGURATION_TYPE),
+    0x00, /* bConfigurationValue: configuration index */
+    0x00, /* bReserved */
+    WBVAL ((USBD_WINUSB_DESC_SET_LEN - WINUSB_DESCRIPTOR_SET_HEADER_SIZE)),
+    /* function subset header */
+    WBVAL (WINUSB_FUNCTION_SUBSET_HEADER_SIZE), WBVAL (WINUSB_SUBSET_HEADER_FUNCTION_TYPE),
+    0x01, /* bFirstInterface: vendor interface */
+    0x00, /* bReserved */
+    WBVAL ((USBD_WINUSB_DESC_SET_LEN - WINUSB_DESCRIPTOR_SET_HEADER_SIZE - 8)),
+    /* compatible ID */
+    WBVAL (WINUSB_FEATURE_COMPATIBLE_ID_SIZE), WBVAL (WINUSB_FEATURE_COMPATIBLE_ID_TYPE),
+    'W', 'I', 'N', 'U', 'S', 'B', 0x00, 0x00, /* CompatibleID */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* SubCompatibleID */
+    /* registry property: DeviceInterfaceGUIDs */
+    WBVAL (132), WBVAL (WINUSB_FEATURE_REG_PROPERTY_TYPE),
+    WBVAL (WINUSB_PROP_DATA_TYPE_REG_MULTI_SZ),
+    WBVAL (42), /* wPropertyNameLength */
+    'D', 0x00, 'e', 0x00, 'v', 0x00, 'i', 0x00, 'c', 0x00, 'e', 0x00, 'I', 0x00, 'n', 0x00,
+    't', 0x00, 'e', 0x00, 'r', 0x00, 'f', 0x00, 'a', 0x00, 'c', 0x00, 'e', 0x00, 'G', 0x00,
+    'U', 0x00, 'I', 0x00, 'D', 0x00, 's', 0x00,
+    0x00, 0x00,
+    WBVAL (80), /* wPropertyDataLength */
+    '{', 0x00, '3', 0x00, 'D', 0x00, '6', 0x00, 'B', 0x00, '7', 0x00, 'F', 0x00, '2', 0x00,
+    '1', 0x00, '-', 0x00, '5', 0x00, 'A', 0x00, '4', 0x00, 'C', 0x00, '-', 0x00, '4', 0x00,
+    'E', 0x00, '8', 0x00, 'B', 0x00, '-', 0x00, '9', 0x00, 'C', 0x00, '1', 0x00, 'D', 0x00,
+    '-', 0x00, '7', 0x00, 'E', 0x00, '2', 0x00, 'F', 0x00, '0', 0x00, 'A', 0x00, '9', 0x00,
+    'B', 0x00, '4', 0x00, 'C', 0x00, '5', 0x00, '6', 0x00, '}', 0x00,
+    0x00, 0x00, 0x00, 0x00};
+
+static const uint8_t bos_desc[USBD_BOS_DESC_LEN] = {
+    /* BOS descriptor */
+    0x05, USB_DESCRIPTOR_TYPE_BINARY_OBJECT_STORE, WBVAL (USBD_BOS_DESC_LEN), 0x01,
+    /* platform capability: MS OS 2.0 {D8DD60DF-4589-4CC7-9CD2-659D9E648A9F} */
+    0x1C, USB_DESCRIPTOR_TYPE_DEVICE_CAPABILITY, USB_DEVICE_CAPABILITY_PLATFORM, 0x00,
+    0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C,
+    0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F,
+    0x00, 0x00, 0x03, 0x06, /* dwWindowsVersion: Windows 8.1 */
+    WBVAL (USBD_WINUSB_DESC_SET_LEN),
+    USBD_WINUSB_VENDOR_CODE,
+    0x00 /* bAltEnumCode */
+};
+
+static struct usb_msosv2_descriptor msosv2_desc = {
+    .compat_id = (uint8_t *)winusb_desc_set,
+    .compat_id_len = USBD_WINUSB_DESC_SET_LEN,
+    .vendor_code = USBD_WINUSB_VENDOR_CODE};
+
+static struct usb_bos_descriptor bos_descriptor = {
+    .string = (uint8_t *)bos_desc,
+    .string_len = USBD_BOS_DESC_LEN};
+
+/*!< OUT ջλ壺صֱʹһл壬NʱN+1 */
+#define HID_RX_DEPTH 4  // Ϊ2
+#define HID_ACK_REPORT_SIZE 16
+
+USB_NOCACHE_RAM_SECTION USB_MEM_ALIGNX uint8_t read_buffer[HID_RX_DEPTH][HIDRAW_OUT_EP_SIZE];
 USB_NOCACHE_RAM_SECTION USB_MEM_ALIGNX uint8_t send_buffer[HIDRAW_IN_EP_SIZE];
+/* vendor bulkÿ̶֡HIDRAW_OUT_EP_SIZEֽڣ㲹룩ݸʽHID V2ͬ */
+USB_NOCACHE_RAM_SECTION USB_MEM_ALIGNX uint8_t vendor_read_buffer[HID_RX_DEPTH][HIDRAW_OUT_EP_SIZE];
+USB_NOCACHE_RAM_SECTION USB_MEM_ALIGNX uint8_t vendor_send_buffer[HID_ACK_REPORT_SIZE];
+static uint8_t *packet_buffer;  // еݰָread_bufferеһ
 
 #define HID_STATE_IDLE 0
 #define HID_STATE_BUSY 1
 
-/*!< hid state ! Data can be sent only when state is idle  */
-static volatile uint8_t custom_state;
-static volatile uint8_t custom_out_flag;  // 1:յݣ0:ûյ
+typedef struct {
+    uint8_t (*buffer)[HIDRAW_OUT_EP_SIZE];
+    uint8_t *send_buffer;
+    uint8_t out_ep;
+    uint8_t in_ep;
+    volatile uint8_t head;   // ѽհصе
+    volatile uint8_t tail;   // Ѵѭе
+    volatile uint8_t armed;  // 1:OUT˵ʹܣ0:ͣ
+    volatile uint8_t state;  // IN˵״̬ ! Data can be sent only when state is idle
+} usbd_rx_ring;
+
+static usbd_rx_ring hid_rx = {read_buffer, send_buffer, HIDRAW_OUT_EP, HIDRAW_IN_EP};
+static usbd_rx_ring vendor_rx = {vendor_read_buffer, vendor_send_buffer, VENDOR_OUT_EP, VENDOR_IN_EP};
+
+static void usbd_rx_ring_start (usbd_rx_ring *ring) {
+    ring->head = 0;
+    ring->tail = 0;
+    ring->armed = 1;
+    ring->state = HID_STATE_IDLE;
+    usbd_ep_start_read (ring->out_ep, ring->buffer[0], HIDRAW_OUT_EP_SIZE);
+}
+
+/* OUTɻصеãδʱһϼ */
+RY_RAMFUNC static void usbd_rx_ring_push (usbd_rx_ring *ring) {
+    ring->head++;
+    if ((uint8_t)(ring->head - ring->tail) < HID_RX_DEPTH) {
+        usbd_ep_start_read (ring->out_ep, ring->buffer[ring->head & (HID_RX_DEPTH - 1)], HIDRAW_OUT_EP_SIZE);
+    } else {
+        ring->armed = 0;  // ѭһʹ
+    }
+}
+
+/* ѭһ */
+static void usbd_rx_ring_pop (usbd_rx_ring *ring) {
+    ring->tail++;
+    if (!ring->armed) {  // ˵δʹʱصᷢж
+        ring->armed = 1;
+        usbd_ep_start_read (ring->out_ep, ring->buffer[ring->head & (HID_RX_DEPTH - 1)], HIDRAW_OUT_EP_SIZE);
+    }
+}
 
 void usbd_event_handler (uint8_t event) {
     switch (event) {
@@ -314,7 +520,9 @@ void usbd_event_handler (uint8_t event) {
         break;
     case USBD_EVENT_CONFIGURED:
         /* setup first out ep read transfer */
-        usbd_ep_start_read (HIDRAW_OUT_EP, read_buffer, HIDRAW_OUT_EP_SIZE);
+        usbd_rx_ring_start (&hid_rx);
+        usbd_rx_ring_start (&vendor_rx);
+        ry_event_post (RY_EVENT_USB_CONFIGURED);
         break;
     case USBD_EVENT_SET_REMOTE_WAKEUP:
         break;
@@ -326,16 +534,18 @@ void usbd_event_handler (uint8_t event) {
     }
 }
 
-static void usbd_hid_custom_in_callback (uint8_t ep, uint32_t nbytes) {
+RY_RAMFUNC static void usbd_hid_custom_in_callback (uint8_t ep, uint32_t nbytes) {
     (void)ep;
-    USB_LOG_RAW ("actual in len:%d\r\n", (unsigned int)nbytes);
-    custom_state = HID_STATE_IDLE;
+    RY_ISR_LOG_D ("actual in len:%u\r\n", nbytes, 0);
+    hid_rx.state = HID_STATE_IDLE;
+    ry_event_post (RY_EVENT_USB_IN);
 }
 
-static void usbd_hid_custom_out_callback (uint8_t ep, uint32_t nbytes) {
-    USB_LOG_RAW ("actual out len:%d\r\n", (unsigned int)nbytes);
-    // set flag
-    custom_out_flag = 1;
+RY_RAMFUNC static void usbd_hid_custom_out_callback (uint8_t ep, uint32_t nbytes) {
+    RY_ISR_LOG_D ("actual out len:%u\r\n", nbytes, 0);
+    (void)ep;
+    usbd_rx_ring_push (&hid_rx);
+    ry_event_post (RY_EVENT_USB_OUT);
     //  for(uint32_t i=0;i<1024;i++)
     //  {
     //      USB_LOG_RAW("%02x ", read_buffer[i]);
@@ -353,6 +563,20 @@ static void usbd_hid_custom_out_callback (uint8_t ep, uint32_t nbytes) {
     // 7.豸յ
 }
 
+RY_RAMFUNC static void usbd_vendor_in_callback (uint8_t ep, uint32_t nbytes) {
+    (void)ep;
+    (void)nbytes;
+    vendor_rx.state = HID_STATE_IDLE;
+    ry_event_post (RY_EVENT_USB_IN);
+}
+
+RY_RAMFUNC static void usbd_vendor_out_callback (uint8_t ep, uint32_t nbytes) {
+    (void)ep;
+    (void)nbytes;
+    usbd_rx_ring_push (&vendor_rx);
+    ry_event_post (RY_EVENT_USB_OUT);
+}
+
 static struct usbd_endpoint custom_in_ep = {
     .ep_cb = usbd_hid_custom_in_callback,
     .ep_addr = HIDRAW_IN_EP};
@@ -361,6 +585,14 @@ static struct usbd_endpoint custom_out_ep = {
     .ep_cb = usbd_hid_custom_out_callback,
     .ep_addr = HIDRAW_OUT_EP};
 
+static struct usbd_endpoint vendor_in_ep = {
+    .ep_cb = usbd_vendor_in_callback,
+    .ep_addr = VENDOR_IN_EP};
+
+static struct usbd_endpoint vendor_out_ep = {
+    .ep_cb = usbd_vendor_out_callback,
+    .ep_addr = VENDOR_OUT_EP};
+
 /* function ------------------------------------------------------------------*/
 /**
  * @brief            hid custom init
@@ -369,17 +601,29 @@ static struct usbd_endpoint custom_out_ep = {
  * @retval           none
  */
 struct usbd_interface intf0;
+struct usbd_interface intf1;
+
+static void hid_usb_out_event (void);
+static void hid_usb_in_event (void);
 
 void hid_custom_init (uint8_t busid, uintptr_t reg_base) {
 #ifdef CONFIG_USBDEV_ADVANCE_DESC
     usbd_desc_register (busid, &hid_descriptor);
 #else
     usbd_desc_register (hid_descriptor);
+    usbd_msosv2_desc_register (&msosv2_desc);
+    usbd_bos_desc_register (&bos_descriptor);
 #endif
     usbd_add_interface (usbd_hid_init_intf (busid, &intf0, hid_custom_report_desc, HID_CUSTOM_REPORT_DESC_SIZE));
     usbd_add_endpoint (&custom_in_ep);
     usbd_add_endpoint (&custom_out_ep);
+    /* vendor bulkӿڣ֧WinUSBʱԿʹHID */
+    usbd_add_interface (&intf1);
+    usbd_add_endpoint (&vendor_in_ep);
+    usbd_add_endpoint (&vendor_out_ep);
 
+    ry_event_register (RY_EVENT_USB_OUT, hid_usb_out_event);
+    ry_event_register (RY_EVENT_USB_IN, hid_usb_in_event);
     usbd_initialize();
 }
 
@@ -387,12 +631,16 @@ typedef enum {
     FIRMWARE_UPGRADE = 0xAABB,
     SETUP_UPGRADE = 0xCCDD,
     LOAD_UPGRADE = 0xEEFF,
+    DELTA_UPGRADE = 0xAACC,
     UNKNOW_TYPE
 } HID_DATA_TYPE;
 
-void firmware_upgrade_handle (void);
-void setup_upgrade_handle (void);
-void load_uprade_handle (void);
+static uint8_t firmware_upgrade_handle (const uint8_t *data, uint16_t len, uint8_t first, uint8_t last);
+static uint8_t setup_upgrade_handle (const uint8_t *data, uint16_t len, uint8_t first, uint8_t last);
+static uint8_t load_uprade_handle (const uint8_t *data, uint16_t len, uint8_t first, uint8_t last);
+static uint8_t delta_upgrade_handle (const uint8_t *data, uint16_t len, uint8_t first, uint8_t last);
+
+#define HID_PAYLOAD_MAX 1019  // read_buffer[5-1023]
 
 //--------------------------ݴ------------------------------------
 // жϣ̼(firmware.bin)ø(setup.ry)bin(load.bin)
@@ -411,37 +659,589 @@ void load_uprade_handle (void);
 // ݳȽݴ洢ļfirmware.binsetup.ryload.bin
 // firmware.binɣ̣ɺɾļ
 //--------------------------------------------------------------------
-void hid_data_process (void) {
-    USB_LOG_RAW ("hid_ry_hid_handle\r\n");
-    USB_LOG_RAW ("%s", read_buffer);
 
-    HID_DATA_TYPE hid_data_type = UNKNOW_TYPE;
-    hid_data_type = (read_buffer[1] << 8) + read_buffer[2];
-    switch (hid_data_type) {
+//--------------------------V2Э-------------------------------------
+// read_buffer[1-2]ΪHID_PROTO_V2(0x5202)ʱV2Э鴦ఴV1
+// read_buffer[3-4]:ͣͬV1(0xAABB/0xCCDD/0xEEFF)
+//                 0xAACC:Ϊry_delta.hʽĲ
+// read_buffer[5]:־bit0:SOF(һΪ)bit1:EOF(һ)
+//                bit2:LZ(ֻSOFЧδݰry_lz.hĸʽѹ)
+//                bit3:RESUME(ֻSOFЧ)
+//                bit4:CRC(ֻSOFЧЧǰ4ByteΪվCRC32У)
+//                bit5:SIZE(ֻSOFЧ4Byteվ񳤶ȣСˣԤ)
+// read_buffer[6-7]:ţÿ1
+// read_buffer[8-9]:Чݳ(0-1014Byte)Ƿһ޹
+// read_buffer[10-1023]:Ч
+//---------------------------------------------------------------------
+// 豸ֻ16ByteıID 0x03ظ(ACK)ÿظ1024Byte
+// send_buffer[0]:0x03
+// send_buffer[1]:Э汾(2)
+// send_buffer[2]:״̬HID_ACK_xxx
+// send_buffer[3]:ڣɷ͵δȷϰ
+// send_buffer[4-5]:һţ֮ǰİѴۼȷϣ
+// send_buffer[6-9]:δѽֽ
+//---------------------------------------------------------------------
+// 1.ŲʱظNAKNAKеطN
+// 2.յظѴʱٴλظACK
+// 3.ÿHID_ACK_EVERYջСEOFʱظһΣ
+//   IN˵æʱACKϲΪһ
+// 4.EOFɺظHID_ACK_DONEʱظHID_ACK_ERRORδ
+//---------------------------------------------------------------------
+// ̼//أLZͬʱʹã
+// 1.SOFRESUMEЧֻ4ByteIDСˣļCRC32ļ
+// 2.־еͺIDһʱѳ־ûλü0ʼ
+//   豸ظACKsend_buffer[6-9]Ϊ㣬Ӹλ÷ͺ
+// 3.ÿHID_RESUME_COMMITֽڳ־ûһΣļf_sync̼ݴ۰룩
+//   ʼĴʱ
+//---------------------------------------------------------------------
+// У飺
+// 1.CRC32ry_crc.h㣬дľ񣨽ѹ/֮󣩣С
+// 2.EOFɺFLASHؼ㣨̼װǰݴۣ/أļ
+//   һʱظHID_ACK_ERRORװ̼ɾļ
+// 3.RESUMEͬʱʹʱSOFЧΪCRC32ǰIDں
+// 4.ÿݵUSBCRC16V2İű֤ٵУ
+//---------------------------------------------------------------------
+// Ԥ䣨/أ
+// 1.ΪѹдļĳȣSOFЧλCRC32֮󡢾ID֮ǰ
+// 2.һļʱزԤ֮д벻
+//   û㹻ռʱԭʽط䣬ʵʳȽ϶ʱEOFض
+// 3.ʱļѴڣԤ䣻̼ͲԴ˳
+//---------------------------------------------------------------------
+#define HID_PROTO_V2         0x5202
+#define HID_PROTO_VERSION    2
+#define HID_V2_FLAG_SOF      0x01
+#define HID_V2_FLAG_EOF      0x02
+#define HID_V2_FLAG_LZ       0x04
+#define HID_V2_FLAG_RESUME   0x08
+#define HID_V2_FLAG_CRC      0x10
+#define HID_V2_FLAG_SIZE     0x20
+#define HID_RESUME_COMMIT    RY_SLOT_BLOCK  // ̼ݴֻܴӿ߽
+#define HID_V2_PAYLOAD_MAX   1014  // read_buffer[10-1023]
+
+#define HID_ACK_REPORT_ID    0x03
+#define HID_ACK_WINDOW       8
+#define HID_ACK_EVERY        (HID_ACK_WINDOW / 2)
+
+#define HID_ACK_OK           0x00  // ۼȷ
+#define HID_ACK_NAK          0x01  // Ųnext_seqط
+#define HID_ACK_STATE        0x02  // ûSOFʼĴ䣬Ͳһ
+#define HID_ACK_ERROR        0x03  // дʧܣ
+#define HID_ACK_DONE         0x04  // EOFѴ
+
+static struct {
+    usbd_rx_ring *ring;  // δʹõĽӿڣACKӶӦIN˵ظ
+    HID_DATA_TYPE type;
+    uint32_t bytes;      // ѽֽ
+    uint16_t next_seq;   // һ
+    uint16_t acked_seq;  // һACKеnext_seq
+    uint8_t status;      // ͵״̬
+    uint8_t pending;     // 1:д͵ACK
+    uint8_t active;      // 1:
+    uint8_t lz;          // 1:ݾѹѹд
+    uint8_t resume;      // 1:ȼ¼ry_journal
+    uint32_t id;         // ľID
+    uint8_t verify;      // 1:EOFУCRC32
+    uint32_t crc;        // CRC32
+    uint32_t size;       // ļȣ0:δ֪
+} hid_session;
+
+static void hid_ack_post (uint8_t status) {
+    // DONE/ERRORδǰ״̬ǣ״̬µۼȷ
+    if (!hid_session.pending || (hid_session.status < HID_ACK_ERROR)) {
+        hid_session.status = status;
+    }
+    hid_session.pending = 1;
+}
+
+static void hid_ack_flush (void) {
+    usbd_rx_ring *ring = hid_session.ring;
+    uint8_t *send_buffer;
+
+    if (!hid_session.pending || (ring->state != HID_STATE_IDLE)) {
+        return;
+    }
+    send_buffer = ring->send_buffer;
+    memset (send_buffer, 0, HID_ACK_REPORT_SIZE);
+    send_buffer[0] = HID_ACK_REPORT_ID;
+    send_buffer[1] = HID_PROTO_VERSION;
+    send_buffer[2] = hid_session.status;
+    send_buffer[3] = HID_ACK_WINDOW;
+    send_buffer[4] = hid_session.next_seq >> 8;
+    send_buffer[5] = hid_session.next_seq;
+    send_buffer[6] = hid_session.bytes >> 24;
+    send_buffer[7] = hid_session.bytes >> 16;
+    send_buffer[8] = hid_session.bytes >> 8;
+    send_buffer[9] = hid_session.bytes;
+
+    hid_session.acked_seq = hid_session.next_seq;
+    hid_session.pending = 0;
+    ring->state = HID_STATE_BUSY;
+    usbd_ep_start_write (ring->in_ep, send_buffer, HID_ACK_REPORT_SIZE);
+}
+
+/*!< ÿδͳƣʱΪŻǰԱȵĻ׼ */
+static struct {
+    uint64_t cycles;             // ʱۼӣ32λmcycle
+    uint32_t last_cycle;
+    uint32_t bytes;
+    uint32_t raw_bytes;          // ѹֽ
+    Flash_StatsTypeDef spi;      // ʼʱSPI FLASHͳ
+    uint8_t active;
+} hid_upgrade_stat;
+
+static void hid_upgrade_report (uint8_t err) {
+    uint32_t us = hid_upgrade_stat.cycles / (SystemCoreClock / 1000000);
+
+    RY_LOG_I4 ("upgrade result:%u bytes:%u/%u time:%uus\r\n", err, hid_upgrade_stat.bytes, hid_upgrade_stat.raw_bytes, us);
+    RY_LOG_I4 ("speed:%uKB/s spi read:%u program:%u erase:%u\r\n",
+               us ? (uint32_t)((uint64_t)hid_upgrade_stat.bytes * 1000 / 1024 * 1000 / us) : 0,
+               Flash_Stats.read_bytes - hid_upgrade_stat.spi.read_bytes,
+               Flash_Stats.program_bytes - hid_upgrade_stat.spi.program_bytes,
+               Flash_Stats.erase_cmds - hid_upgrade_stat.spi.erase_cmds);
+    RY_LOG_I ("ram static:%u stack:%u\r\n", ry_prof_static_ram(), ry_prof_stack_peak());
+}
+
+static uint8_t hid_upgrade_handle (HID_DATA_TYPE type, const uint8_t *data, uint16_t len, uint8_t first, uint8_t last) {
+    uint8_t err;
+
+    hid_upgrade_stat.raw_bytes += len;
+    switch (type) {
     case FIRMWARE_UPGRADE:
-        firmware_upgrade_handle();
+        err = firmware_upgrade_handle (data, len, first, last);
         break;
     case SETUP_UPGRADE:
-        setup_upgrade_handle();
+        err = setup_upgrade_handle (data, len, first, last);
         break;
     case LOAD_UPGRADE:
-        load_uprade_handle();
+        err = load_uprade_handle (data, len, first, last);
+        break;
+    case DELTA_UPGRADE:
+        err = delta_upgrade_handle (data, len, first, last);
         break;
     default:
+        err = 1;
         break;
     }
+    return err;
+}
+
+/*!< ѹĽͬʱΪѹ */
+static ry_lz_t hid_lz;
+static struct {
+    HID_DATA_TYPE type;
+    uint8_t first;       // һǱδĵһ
+} hid_lz_out;
+
+static uint8_t hid_lz_sink (const uint8_t *data, uint16_t len, void *ctx) {
+    uint8_t first = hid_lz_out.first;
+
+    (void)ctx;
+    hid_lz_out.first = 0;
+    return hid_upgrade_handle (hid_lz_out.type, data, len, first, 0);
+}
+
+static uint8_t hid_upgrade_dispatch (HID_DATA_TYPE type, const uint8_t *data, uint16_t len, uint8_t first, uint8_t last, uint8_t lz) {
+    uint32_t now;
+    uint8_t err;
+
+    if (first || !hid_upgrade_stat.active) {
+        ry_clock_set (RY_CLOCK_BOOST);  // 144MHzͳƴлʼ
+        hid_upgrade_stat.cycles = 0;
+        hid_upgrade_stat.last_cycle = __get_MCYCLE();
+        hid_upgrade_stat.bytes = 0;
+        hid_upgrade_stat.raw_bytes = 0;
+        hid_upgrade_stat.spi = Flash_Stats;
+        hid_upgrade_stat.active = 1;
+    }
+
+    if (lz) {
+        if (first) {
+            ry_lz_init (&hid_lz);
+            hid_lz_out.type = type;
+            hid_lz_out.first = 1;
+        }
+        err = ry_lz_decode (&hid_lz, data, len, hid_lz_sink, NULL);
+        if (!err && last) {
+            // decodeȫֻδ
+            err = hid_upgrade_handle (type, NULL, 0, hid_lz_out.first, 1) || !ry_lz_done (&hid_lz);
+        }
+        if (err) {
+            // ݴʱûյ־رļ/ݴۣѽĲӰ죩
+            fatfs_file_abort();
+            ry_boot_stage_finish();
+        }
+    } else {
+        err = hid_upgrade_handle (type, data, len, first, last);
+    }
+
+    now = __get_MCYCLE();
+    hid_upgrade_stat.cycles += now - hid_upgrade_stat.last_cycle;
+    hid_upgrade_stat.last_cycle = now;
+    hid_upgrade_stat.bytes += len;
+    if (last || err) {
+        hid_upgrade_stat.active = 0;
+        hid_upgrade_report (err);  // ʱSystemCoreClockʱ
+        ry_clock_set (RY_CLOCK_NORMAL);
+    }
+    return err;
+}
+
+/* fatfs_file_receive()ָжǷͬһļļֻﶨ */
+static const TCHAR *hid_upgrade_path (HID_DATA_TYPE type) {
+    static const TCHAR setup_path[] = "0:setup.ry";
+    static const TCHAR load_path[] = "0:load.bin";
+
+    return (type == SETUP_UPGRADE) ? setup_path : load_path;
+}
+
+/**
+ * @brief  ʼĴ䣬־ƥʱѳ־ûλü
+ * @retval 0:ɹhid_session.bytesΪ
+ */
+static uint8_t hid_resume_begin (HID_DATA_TYPE type, const uint8_t *data, uint16_t len) {
+    const ry_journal_t *journal = ry_journal_get();
+    uint32_t offset = 0;
+
+    if ((len != 4) || hid_session.lz ||
+        ((type != FIRMWARE_UPGRADE) && (type != SETUP_UPGRADE) && (type != LOAD_UPGRADE))) {
+        return 1;
+    }
+    hid_session.id = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+    if ((journal->type == type) && (journal->id == hid_session.id)) {
+        offset = journal->offset;
+    }
+
+    if (type == FIRMWARE_UPGRADE) {
+        if (ry_boot_stage_begin (offset) != HAL_OK) {
+            offset = 0;
+            ry_boot_stage_begin (0);
+        }
+    } else if (fatfs_file_resume (hid_upgrade_path (type), offset) != FR_OK) {
+        offset = 0;
+        if (fatfs_file_resume (hid_upgrade_path (type), 0) != FR_OK) {
+            return 1;
+        }
+    }
+    RY_LOG_I ("resume id:%x offset:%u\r\n", hid_session.id, offset);
+    hid_session.bytes = offset;
+    return ry_journal_commit (type, hid_session.id, offset) != HAL_OK;
+}
+
+/**
+ * @brief  дÿHID_RESUME_COMMITֽڳ־û¼
+ */
+static void hid_resume_commit (void) {
+    uint32_t offset = hid_session.bytes & ~(HID_RESUME_COMMIT - 1);
+
+    if (offset == ry_journal_get()->offset) {
+        return;
+    }
+    // ݴҳ̣߽֮ǰݶд
+    if ((hid_session.type != FIRMWARE_UPGRADE) && (fatfs_file_sync() != FR_OK)) {
+        return;
+    }
+    ry_journal_commit (hid_session.type, hid_session.id, offset);
+}
+
+/**
+ * @brief  дľSOFеCRC32Ƚ
+ * @retval 0:һ
+ */
+static uint8_t hid_upgrade_verify (HID_DATA_TYPE type) {
+    uint32_t crc = ~hid_session.crc;
+
+    if ((type == FIRMWARE_UPGRADE) || (type == DELTA_UPGRADE)) {
+        return 0;  // װǰݴУ飨firmware_activate
+    }
+    if ((fatfs_file_crc (hid_upgrade_path (type), &crc) != FR_OK) || (crc != hid_session.crc)) {
+        f_unlink (hid_upgrade_path (type));
+    }
+    if (crc != hid_session.crc) {
+        RY_LOG_E ("crc error:%x expect:%x\r\n", crc, hid_session.crc);
+        return 1;
+    }
+    return 0;
+}
+
+static void hid_v2_process (void) {
+    HID_DATA_TYPE type = (packet_buffer[3] << 8) + packet_buffer[4];
+    uint8_t flags = packet_buffer[5];
+    uint16_t seq = (packet_buffer[6] << 8) + packet_buffer[7];
+    uint16_t len = (packet_buffer[8] << 8) + packet_buffer[9];
+    const uint8_t *data = &packet_buffer[10];
+    uint16_t diff;
+
+    if (len > HID_V2_PAYLOAD_MAX) {
+        len = HID_V2_PAYLOAD_MAX;
+    }
+    if (flags & HID_V2_FLAG_SOF) {
+        hid_session.type = type;
+        hid_session.bytes = 0;
+        hid_session.next_seq = seq;
+        hid_session.acked_seq = seq;
+        hid_session.active = 1;
+        hid_session.lz = (flags & HID_V2_FLAG_LZ) != 0;
+        hid_session.resume = (flags & HID_V2_FLAG_RESUME) != 0;
+        hid_session.verify = (flags & HID_V2_FLAG_CRC) != 0;
+        if (hid_session.verify) {
+            if (len < 4) {
+                hid_session.active = 0;
+                hid_ack_post (HID_ACK_STATE);
+                return;
+            }
+            hid_session.crc = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+            data += 4;
+            len -= 4;
+        }
+        hid_session.size = 0;
+        if (flags & HID_V2_FLAG_SIZE) {
+            if (len < 4) {
+                hid_session.active = 0;
+                hid_ack_post (HID_ACK_STATE);
+                return;
+            }
+            hid_session.size = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+            data += 4;
+            len -= 4;
+        }
+        if (hid_session.resume) {
+            hid_session.next_seq++;
+            if (hid_resume_begin (type, data, len)) {
+                hid_session.active = 0;
+                hid_session.resume = 0;
+                hid_ack_post (HID_ACK_STATE);
+            } else {
+                hid_ack_post (HID_ACK_OK);  // ظ
+            }
+            return;
+        }
+        if (ry_journal_get()->type) {
+            ry_journal_commit (0, 0, 0);  // ļǣ֮ǰĽʧЧ
+        }
+    }
+    if (!hid_session.active || (type != hid_session.type)) {
+        hid_ack_post (HID_ACK_STATE);
+        return;
+    }
+
+    diff = seq - hid_session.next_seq;
+    if (diff != 0) {
+        // diffλΪ1ظмаʧ
+        hid_ack_post ((diff & 0x8000) ? HID_ACK_OK : HID_ACK_NAK);
+        return;
+    }
+
+    hid_session.next_seq++;
+    hid_session.bytes += len;
+    if (hid_upgrade_dispatch (type, data, len, flags & HID_V2_FLAG_SOF, flags & HID_V2_FLAG_EOF, hid_session.lz)) {
+        hid_session.active = 0;
+        hid_ack_post (HID_ACK_ERROR);
+    } else if (flags & HID_V2_FLAG_EOF) {
+        hid_session.active = 0;
+        hid_ack_post ((hid_session.verify && hid_upgrade_verify (type)) ? HID_ACK_ERROR : HID_ACK_DONE);
+    } else {
+        if (hid_session.resume) {
+            hid_resume_commit();
+        }
+        if ((uint16_t)(hid_session.next_seq - hid_session.acked_seq) >= HID_ACK_EVERY) {
+            hid_ack_post (HID_ACK_OK);
+        }
+    }
+    if (hid_session.resume && !hid_session.active) {
+        hid_session.resume = 0;
+        ry_journal_commit (0, 0, 0);  // ɻ
+    }
+}
+
+/*!< V1ÿظһΣIN˵æһλظV2ACKδ꣩ʱƳٵɺ */
+static uint8_t hid_v1_reply_pending;
+
+static void hid_v1_reply_flush (void) {
+    if (!hid_v1_reply_pending || (hid_rx.state != HID_STATE_IDLE)) {
+        return;
+    }
+    for (int i = 0; i < 1024; i++) {
+        send_buffer[i] = i & 0xff;
+    }
+    send_buffer[0] = 0x02; /* IN: report id */
+    hid_v1_reply_pending = 0;
+    hid_rx.state = HID_STATE_BUSY;
+    usbd_ep_start_write (HIDRAW_IN_EP, send_buffer, HIDRAW_IN_EP_SIZE);
+}
+
+static void hid_v1_process (void) {
+    HID_DATA_TYPE hid_data_type = (packet_buffer[1] << 8) + packet_buffer[2];
+    uint16_t len = (packet_buffer[3] << 8) + packet_buffer[4];
+
+    hid_session.verify = 0;  // V1ûCRCͳ
+    hid_session.size = 0;
+
+    hid_v1_reply_pending = 1;
+    hid_v1_reply_flush();
+
+    if (len > HID_PAYLOAD_MAX) {
+        len = HID_PAYLOAD_MAX;
+    }
+    if (ry_journal_get()->type) {
+        ry_journal_commit (0, 0, 0);  // V1ļ
+    }
+    hid_upgrade_dispatch (hid_data_type, &packet_buffer[5], len, 0, len < HID_PAYLOAD_MAX, 0);
+}
+
+void hid_data_process (usbd_rx_ring *ring) {
+    RY_PROF_BEGIN (RY_PROF_HID_PROCESS);
+
+    if (((packet_buffer[1] << 8) + packet_buffer[2]) == HID_PROTO_V2) {
+        hid_session.ring = ring;
+        hid_v2_process();
+    } else if (ring == &hid_rx) {
+        hid_v1_process();  // vendorӿֻ֧V2
+    }
+    RY_PROF_END (RY_PROF_HID_PROCESS);
+}
+
+/* feature0x04ȡʱͳƣд */
+#define HID_PROF_REPORT_ID 0x04
+
+void usbd_hid_get_report (uint8_t busid, uint8_t intf, uint8_t report_id, uint8_t report_type, uint8_t **data, uint32_t *len) {
+    (void)busid;
+    (void)intf;
+    if ((report_id == HID_PROF_REPORT_ID) && (report_type == HID_REPORT_FEATURE)) {
+        (*data)[0] = HID_PROF_REPORT_ID;
+        *len = 1 + ry_prof_report (&(*data)[1]);
+    } else {
+        (*data)[0] = 0;
+        *len = 1;
+    }
+}
+
+void usbd_hid_set_report (uint8_t busid, uint8_t intf, uint8_t report_id, uint8_t report_type, uint8_t *report, uint32_t report_len) {
+    (void)busid;
+    (void)intf;
+    (void)report;
+    (void)report_len;
+    if ((report_id == HID_PROF_REPORT_ID) && (report_type == HID_REPORT_FEATURE)) {
+        ry_prof_reset();
+    }
+}
+
+/**
+ * @brief  ݴе¹̼УװAPPry_boot.hʧʱAPPѻع
+ */
+static uint8_t firmware_activate (uint32_t size) {
+    const IAP_StatsTypeDef *stats = IAP_Stream_Stats();
+    uint8_t err;
+
+    err = ry_boot_activate (size, hid_session.verify ? &hid_session.crc : NULL) != HAL_OK;
+    RY_LOG_I ("firmware upgrade done:%u err:%u\r\n", size, err);
+    RY_LOG_I4 ("install program:%u/%u erase:%u/%u\r\n", stats->program_cycles, stats->program_count,
+               stats->erase_cycles, stats->erase_count);
+    RY_LOG_I ("install stall:%u/%u\r\n", stats->stall_cycles, stats->stall_count);
+    ry_prof_dump();
+    return err;
+}
+
+// ̼дW25Q64ݴۣղУŰװжϲӰ쵱ǰ̼
+static uint8_t firmware_upgrade_handle (const uint8_t *data, uint16_t len, uint8_t first, uint8_t last) {
+    uint8_t err = 0;
+
+    if (first || !ry_boot_stage_active()) {
+        ry_boot_stage_begin (0);  // һδδʱ¿ʼ
+    }
+    if (ry_boot_stage_write (data, len) != HAL_OK) {
+        RY_LOG_E ("firmware too large\r\n", 0, 0);
+        err = 1;
+    }
+    if (last || err) {
+        uint32_t size = ry_boot_stage_finish();
+
+        if (!err) {
+            err = firmware_activate (size);
+        }
+    }
+    return err;
+}
+
+static uint8_t setup_upgrade_handle (const uint8_t *data, uint16_t len, uint8_t first, uint8_t last) {
+    if (first) {
+        fatfs_file_abort();
+    }
+    return fatfs_file_receive (hid_upgrade_path (SETUP_UPGRADE), hid_session.size, data, len, last) != FR_OK;
+}
+
+static uint8_t load_uprade_handle (const uint8_t *data, uint16_t len, uint8_t first, uint8_t last) {
+    if (first) {
+        fatfs_file_abort();
+    }
+    return fatfs_file_receive (hid_upgrade_path (LOAD_UPGRADE), hid_session.size, data, len, last) != FR_OK;
+}
+
+//--------------------------------------------------------------
+// APPеĵǰ̼ϳ¹̼
+// 1.¹̼˳дݴۣɹ̼ڴڼ䱣ֲ
+// 2.ӦúУ鲢װ;Ӱ쵱ǰ̼
+// 3.RAMֻҪͷ256Byte壬̼С޹
+//--------------------------------------------------------------------
+static ry_delta_t hid_delta;
+static uint8_t hid_delta_active;
+
+static uint8_t delta_sink (const uint8_t *data, uint16_t len, void *ctx) {
+    (void)ctx;
+    return ry_boot_stage_write (data, len) != HAL_OK;
+}
+
+static uint8_t delta_upgrade_handle (const uint8_t *data, uint16_t len, uint8_t first, uint8_t last) {
+    uint8_t err;
+
+    if (first || !hid_delta_active) {
+        ry_delta_init (&hid_delta, (const uint8_t *)IAP_APP_ADDR, IAP_IMAGE_MAX, IAP_IMAGE_MAX);
+        ry_boot_stage_begin (0);
+        hid_delta_active = 1;
+    }
+    err = ry_delta_apply (&hid_delta, data, len, delta_sink, NULL);
+    if (last || err) {
+        uint32_t size = ry_boot_stage_finish();
+
+        hid_delta_active = 0;
+        if (!err && ry_delta_done (&hid_delta)) {
+            err = firmware_activate (size);
+        } else {
+            RY_LOG_E ("delta patch rejected at new:%u\r\n", hid_delta.new_pos, 0);
+            err = 1;
+        }
+    }
+    return err;
 }
 
-void hid_ry_hid_handle (void) {
-    if (custom_out_flag == 1) {
-        custom_out_flag = 0;
-        hid_data_process();
+static void usbd_rx_ring_handle (usbd_rx_ring *ring) {
+    if (ring->head != ring->tail) {
+        // OUT˵ڻصָһ壬֮ĲͱUSBͬʱ
+        packet_buffer = ring->buffer[ring->tail & (HID_RX_DEPTH - 1)];
+
+        hid_data_process (ring);
+        usbd_rx_ring_pop (ring);
 
-        for (int i = 0; i < 1024; i++) {
-            send_buffer[i] = i & 0xff;
+        if ((ring == hid_session.ring) && (ring->head == ring->tail) &&
+            (hid_session.next_seq != hid_session.acked_seq)) {
+            hid_ack_post (HID_ACK_OK);  // ûдİȷʣδȷϵİ
         }
-        send_buffer[0] = 0x02; /* IN: report id */
-        usbd_ep_start_write (HIDRAW_IN_EP, send_buffer, HIDRAW_IN_EP_SIZE);
-        usbd_ep_start_read (HIDRAW_OUT_EP, read_buffer, HIDRAW_OUT_EP_SIZE);
     }
+}
+
+/* IN˵к͵ȴеACKV1ظ */
+static void hid_usb_in_event (void) {
+    if (hid_session.ring) {
+        hid_ack_flush();
+    }
+    hid_v1_reply_flush();
+}
+
+/* ÿӿڴһδİʱµǼǣ¼ص崦 */
+static void hid_usb_out_event (void) {
+    usbd_rx_ring_handle (&vendor_rx);
+    usbd_rx_ring_handle (&hid_rx);
+    if ((vendor_rx.head != vendor_rx.tail) || (hid_rx.head != hid_rx.tail)) {
+        ry_event_post (RY_EVENT_USB_OUT);
+    }
+    hid_usb_in_event();
 }
\ No newline at end of file
@@ -10,6 +10,5 @@
 #include "usbd_hid.h"
 #define CONFIG_USB_HS
 void hid_custom_init(uint8_t busid, uintptr_t reg_base);
-void hid_ry_hid_handle(void);
 
 #endif /* HID_CUSTOM_H*/
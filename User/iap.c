@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "iap.h"
+#include "ry_crc.h"
+#include <string.h>
+
+//--------------------------流式升级------------------------------------
+// 固件数据按顺序写入内部FLASH的APP区（安装时ry_boot从暂存槽读出后写入）：
+// 1.数据先拼成256Byte整页，用FLASH_ProgramPage_Fast编程
+// 2.擦除以32K块为单位（FLASH_EraseBlock_32K_Fast），并且提前一块擦除：
+//   ry_slot_install()启动下一段的SPI DMA读取之后调用IAP_Stream_Poll()，
+//   擦除时下一段数据已经在SPI上传输
+// 3.编程追上擦除位置时（未及时调用Poll）在Write中同步擦除，保证正确性
+// 4.数据和已擦除的页都准备好才编程；各阶段耗时记录在IAP_StatsTypeDef中，
+//   rx_cycles包含提前擦除的时间，stall_count为0且平均段间隔与不擦除时相同，
+//   即擦除完全被SPI读取时间隐藏
+//--------------------------------------------------------------------
+typedef struct {
+    uint32_t addr;        // 下一页编程地址
+    uint32_t erased_end;  // 已擦除区域的结束地址
+    uint32_t size;        // 已接收字节数
+    uint16_t fill;        // page中已填充字节数
+    uint8_t active;
+    uint32_t last_cycle;  // 上一次Write返回时的mcycle
+    __attribute__((aligned(4))) uint8_t page[IAP_PAGE_SIZE];
+} IAP_Stream;
+
+static IAP_Stream iap_stream;
+static IAP_StatsTypeDef iap_stats;
+
+static void IAP_EraseNextBlock (uint8_t ahead) {
+    uint32_t t = __get_MCYCLE();
+
+    FLASH_EraseBlock_32K_Fast (iap_stream.erased_end);
+    iap_stream.erased_end += IAP_BLOCK_SIZE;
+
+    t = __get_MCYCLE() - t;
+    if (ahead) {
+        iap_stats.erase_cycles += t;
+        iap_stats.erase_count++;
+    } else {
+        iap_stats.stall_cycles += t;
+        iap_stats.stall_count++;
+    }
+}
+
+static IAP_StatusTypeDef IAP_ProgramPage (void) {
+    uint32_t t;
+
+    if (iap_stream.addr + IAP_PAGE_SIZE > IAP_RECORD_ADDR) {
+        return IAP_ERROR;
+    }
+    while (iap_stream.addr >= iap_stream.erased_end) {
+        IAP_EraseNextBlock (0);
+    }
+    t = __get_MCYCLE();
+    FLASH_ProgramPage_Fast (iap_stream.addr, (uint32_t *)iap_stream.page);
+    iap_stats.program_cycles += __get_MCYCLE() - t;
+    iap_stats.program_count++;
+    iap_stream.addr += IAP_PAGE_SIZE;
+    iap_stream.fill = 0;
+    return IAP_OK;
+}
+
+/**
+ * @brief  开始一次流式升级，解锁快速编程模式并擦除第一块
+ */
+void IAP_Stream_Begin (void) {
+    iap_stream.addr = IAP_APP_ADDR;
+    iap_stream.erased_end = IAP_APP_ADDR;
+    iap_stream.size = 0;
+    iap_stream.fill = 0;
+    iap_stream.active = 1;
+    memset (&iap_stats, 0, sizeof (iap_stats));
+
+    FLASH_Unlock_Fast();
+    IAP_EraseNextBlock (1);
+    iap_stream.last_cycle = __get_MCYCLE();
+}
+
+/**
+ * @brief  写入一段固件数据，满一页即编程
+ * @retval IAP_ERROR：固件超出APP区
+ */
+IAP_StatusTypeDef IAP_Stream_Write (const uint8_t *pData, uint32_t Size) {
+    IAP_StatusTypeDef status = IAP_OK;
+    uint32_t n;
+
+    if (!iap_stream.active) {
+        return IAP_STATE;
+    }
+    iap_stats.rx_cycles += __get_MCYCLE() - iap_stream.last_cycle;
+    while (Size) {
+        n = IAP_PAGE_SIZE - iap_stream.fill;
+        if (n > Size) {
+            n = Size;
+        }
+        memcpy (&iap_stream.page[iap_stream.fill], pData, n);
+        iap_stream.fill += n;
+        iap_stream.size += n;
+        pData += n;
+        Size -= n;
+        if ((iap_stream.fill == IAP_PAGE_SIZE) && (IAP_ProgramPage() != IAP_OK)) {
+            status = IAP_ERROR;
+            break;
+        }
+    }
+    iap_stream.last_cycle = __get_MCYCLE();
+    return status;
+}
+
+/**
+ * @brief  结束流式升级，最后不满一页的数据补0xFF后编程，快速模式和标准锁都重新上锁
+ * @retval 固件总长度
+ */
+uint32_t IAP_Stream_Finish (void) {
+    if (!iap_stream.active) {
+        return 0;
+    }
+    if (iap_stream.fill) {
+        memset (&iap_stream.page[iap_stream.fill], 0xFF, IAP_PAGE_SIZE - iap_stream.fill);
+        IAP_ProgramPage();
+    }
+    FLASH_Lock_Fast();
+    FLASH_Lock();  // FLASH_Unlock_Fast()同时解除了标准锁
+    iap_stream.active = 0;
+    return iap_stream.size;
+}
+
+/**
+ * @brief  提前擦除：编程位置进入最后一个已擦除块时擦除下一块
+ * @note   在启动下一段数据的读取（SPI DMA）之后调用，使擦除与读取重叠
+ */
+void IAP_Stream_Poll (void) {
+    if (iap_stream.active && (iap_stream.erased_end < IAP_APP_ADDR + IAP_APP_SIZE) &&
+        (iap_stream.erased_end - iap_stream.addr <= IAP_BLOCK_SIZE)) {
+        IAP_EraseNextBlock (1);
+    }
+}
+
+static uint32_t IAP_Record_Check (const IAP_RecordTypeDef *rec) {
+    return ~(rec->magic ^ rec->size ^ rec->crc ^ rec->generation ^ rec->head_crc ^ rec->tail_crc);
+}
+
+/**
+ * @brief  固件第一页和最后一页的CRC32
+ * @note   快速启动中调用（.data/.bss初始化之前），不使用DMA和全局变量
+ */
+static void IAP_Record_Sentinel (uint32_t size, uint32_t *head, uint32_t *tail) {
+    uint32_t en = RCC->AHBPCENR;
+
+    RCC->AHBPCENR = en | RCC_CRCEN;
+    CRC_ResetDR();
+    *head = CRC_CalcBlockCRC ((uint32_t *)IAP_APP_ADDR, IAP_PAGE_SIZE / 4);
+    CRC_ResetDR();
+    *tail = CRC_CalcBlockCRC ((uint32_t *)(IAP_APP_ADDR + ((size - 1) & ~(IAP_PAGE_SIZE - 1))), IAP_PAGE_SIZE / 4);
+    RCC->AHBPCENR = en;
+}
+
+/**
+ * @brief  写入有效性记录，清除确认字，新安装的固件从未确认状态开始试运行
+ * @param  size，crc：已读回校验的固件
+ */
+void IAP_Record_Write (uint32_t size, uint32_t crc, uint32_t generation) {
+    IAP_RecordTypeDef *rec = (IAP_RecordTypeDef *)iap_stream.page;
+
+    memset (iap_stream.page, 0xFF, IAP_PAGE_SIZE);
+    rec->magic = IAP_RECORD_MAGIC;
+    rec->size = size;
+    rec->crc = crc;
+    rec->generation = generation;
+    IAP_Record_Sentinel (size, &rec->head_crc, &rec->tail_crc);
+    rec->check = IAP_Record_Check (rec);
+
+    FLASH_Unlock_Fast();
+    FLASH_ErasePage_Fast (IAP_RECORD_ADDR);
+    FLASH_ProgramPage_Fast (IAP_RECORD_ADDR, (uint32_t *)iap_stream.page);
+    FLASH_Lock_Fast();
+    FLASH_Lock();
+}
+
+/**
+ * @brief  擦除记录页，APP区内容不再被信任
+ */
+void IAP_Record_Clear (void) {
+    FLASH_Unlock_Fast();
+    FLASH_ErasePage_Fast (IAP_RECORD_ADDR);
+    FLASH_Lock_Fast();
+    FLASH_Lock();
+}
+
+/**
+ * @brief  安装失败：同时擦除APP第一页，没有记录的APP区也不会被当作可运行
+ */
+void IAP_Record_Invalidate (void) {
+    FLASH_Unlock_Fast();
+    FLASH_ErasePage_Fast (IAP_APP_ADDR);
+    FLASH_ErasePage_Fast (IAP_RECORD_ADDR);
+    FLASH_Lock_Fast();
+    FLASH_Lock();
+}
+
+/**
+ * @brief  有效性记录，没有或校验错误时返回NULL（如调试器直接下载的APP）
+ */
+const IAP_RecordTypeDef *IAP_Record_Get (void) {
+    const IAP_RecordTypeDef *rec = (const IAP_RecordTypeDef *)IAP_RECORD_ADDR;
+
+    if ((rec->magic != IAP_RECORD_MAGIC) || (rec->check != IAP_Record_Check (rec)) ||
+        (rec->size == 0) || (rec->size > IAP_IMAGE_MAX)) {
+        return NULL;
+    }
+    return rec;
+}
+
+/**
+ * @brief  上电快速检查：记录有效，首尾两页与记录一致
+ * @note   快速启动中调用，不使用全局变量
+ */
+uint8_t IAP_Record_Quick (void) {
+    const IAP_RecordTypeDef *rec = IAP_Record_Get();
+    uint32_t head, tail;
+
+    if (rec == NULL) {
+        return 0;
+    }
+    IAP_Record_Sentinel (rec->size, &head, &tail);
+    return (head == rec->head_crc) && (tail == rec->tail_crc);
+}
+
+/**
+ * @brief  完整检查：计算整个固件的CRC32与记录比较（按需）
+ */
+uint8_t IAP_Record_Full (void) {
+    const IAP_RecordTypeDef *rec = IAP_Record_Get();
+
+    return rec && (ry_crc_block ((const void *)IAP_APP_ADDR, rec->size) == rec->crc);
+}
+
+/**
+ * @brief  APP是否已在确认页写入IAP_CONFIRM_MAGIC
+ */
+uint8_t IAP_Confirmed (void) {
+    return *(volatile uint32_t *)IAP_CONFIRM_ADDR == IAP_CONFIRM_MAGIC;
+}
+
+uint8_t IAP_Stream_Active (void) {
+    return iap_stream.active;
+}
+
+/**
+ * @brief  最近一次升级的各阶段耗时
+ */
+const IAP_StatsTypeDef *IAP_Stream_Stats (void) {
+    return &iap_stats;
+}
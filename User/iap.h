@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef IAP_H
+#define IAP_H
+
+#include "debug.h"
+
+/* 内部FLASH分区：前64K为IAP本身（见Ld/Link.ld），其后为APP */
+#define IAP_APP_ADDR        (FLASH_BASE + 0x10000)
+#define IAP_APP_SIZE        0x30000     // 192K，对应FLASH-256K + RAM-64K配置
+#define IAP_PAGE_SIZE       256         // FLASH_ProgramPage_Fast一次编程长度
+#define IAP_BLOCK_SIZE      0x8000      // FLASH_EraseBlock_32K_Fast一次擦除长度
+
+/* APP区最后一页为记录页，不属于固件：
+ * 1.开头为有效性记录，安装并读回校验后由IAP写入，上电只检查记录和首尾两页，不计算整个固件
+ * 2.最后一个字为确认字：新固件运行正常后在IAP_CONFIRM_ADDR写入IAP_CONFIRM_MAGIC
+ *   （FLASH_ProgramWord），否则多次上电后回滚到上一版本（见ry_boot.h） */
+#define IAP_RECORD_ADDR     (IAP_APP_ADDR + IAP_APP_SIZE - IAP_PAGE_SIZE)
+#define IAP_RECORD_MAGIC    0x44524352  // "RCRD"
+#define IAP_CONFIRM_ADDR    (IAP_RECORD_ADDR + IAP_PAGE_SIZE - 4)
+#define IAP_CONFIRM_MAGIC   0x4B4F5952  // "RYOK"
+#define IAP_IMAGE_MAX       (IAP_APP_SIZE - IAP_PAGE_SIZE)
+
+/* 有效性记录，CRC32见ry_crc.h */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t size;              // 固件长度
+  uint32_t crc;               // 整个固件
+  uint32_t generation;        // 每次安装加1
+  uint32_t head_crc;          // 第一页（向量表）
+  uint32_t tail_crc;          // 最后一页（含补齐的0xFF）
+  uint32_t check;             // 以上各字异或取反
+} IAP_RecordTypeDef;
+
+/* 流水线各阶段耗时统计（mcycle计数） */
+typedef struct
+{
+  uint32_t rx_cycles;         // 两次Write之间的时间（等待SPI读取，含提前擦除）
+  uint32_t program_cycles;    // FLASH_ProgramPage_Fast
+  uint32_t erase_cycles;      // 提前擦除（与USB接收重叠）
+  uint32_t stall_cycles;      // 同步擦除，编程等待擦除的时间
+  uint16_t program_count;
+  uint16_t erase_count;
+  uint16_t stall_count;       // 为0说明擦除完全隐藏在SPI读取中
+} IAP_StatsTypeDef;
+
+typedef enum
+{
+  IAP_OK = 0,
+  IAP_ERROR,      // 超出APP区（不含确认页）
+  IAP_STATE       // 未调用IAP_Stream_Begin
+} IAP_StatusTypeDef;
+
+void IAP_Stream_Begin(void);
+IAP_StatusTypeDef IAP_Stream_Write(const uint8_t *pData, uint32_t Size);
+uint32_t IAP_Stream_Finish(void);
+void IAP_Stream_Poll(void);
+uint8_t IAP_Stream_Active(void);
+void IAP_Record_Write(uint32_t size, uint32_t crc, uint32_t generation);
+void IAP_Record_Clear(void);
+void IAP_Record_Invalidate(void);
+const IAP_RecordTypeDef *IAP_Record_Get(void);
+uint8_t IAP_Record_Quick(void);
+uint8_t IAP_Record_Full(void);
+uint8_t IAP_Confirmed(void);
+const IAP_StatsTypeDef *IAP_Stream_Stats(void);
+
+#endif /* IAP_H */
@@ -24,8 +24,19 @@
 #include "user_fatfs.h"
 #include "debug.h"
 #include "hid_custom.h"
+#include "ry_log.h"
+#include "ry_prof.h"
+#include "ry_boot.h"
+#include "ry_fastboot.h"
+#include "ry_event.h"
 
 
+void USBHS_IRQHandler (void);
+
+static void main_usb_configured (void) {
+    RY_LOG_I ("usb_device_is_configured\r\n", 0, 0);
+}
+
 /*********************************************************************************************
  * @fn      main
  *
@@ -34,25 +45,37 @@
  * @return  none
  *********************************************************************************************/
 int main (void) {
+    uint16_t request = ry_fastboot_requested();     // δתԭ֮һAPPУ
+
+    ry_prof_stack_paint();                            // ջֵͳ
     NVIC_PriorityGroupConfig (NVIC_PriorityGroup_2);  // ж
     SystemCoreClockUpdate();                          // ʱ
 
     Delay_Init();
     USART_Printf_Init (115200);  // printfڳʼ
+    ry_log_init();               // ־DMA
 
     printf ("SystemClk:%dMHz,ChipID:%08X\r\n\r\n", SystemCoreClock/1000000, DBGMCU_GetCHIPID());//ӡϵͳϢ
-    //1.ϵе˴
-    //2.жϰ״ֱ̬תapp,½
-    //3.״̬HIDʼ״̬
+    //1.ϵе˴APPȷûʱstartupֱתappry_fastboot.h
+    //2.δİװûappЧʱתapp
+    //3.ûappHIDʼ״̬
     //4.λָAPPá
+    ry_fastboot_report();
+    fatfs_file_init();
+    ry_boot_check();  // δɵİװ¹̼м/ع
+    if ((request != RY_BOOT_REQUEST) && ry_fastboot_app_valid (request == RY_BOOT_VERIFY)) {
+        ry_log_flush();
+        ry_fastboot_jump();
+    }
+    ry_event_register (RY_EVENT_USB_CONFIGURED, main_usb_configured);
+    ry_event_register (RY_EVENT_LOG, ry_log_poll);
+    ry_event_register (RY_EVENT_TICK, ry_log_poll);
+    ry_event_tick_init();
     hid_custom_init(0,0);
-    
-    while (!usb_device_is_configured());             // ȴUSBö
-    printf ("usb_device_is_configured\r\n");
 
-    while (1)  // DAPݴʹݴ
+    while (1)  // ¼ȣUSBݴʹ־ͣʱWFIry_event.h
     {
-        hid_ry_hid_handle();
+        ry_event_dispatch();
     }
 }
 
@@ -67,5 +90,6 @@ void USBHS_RCC_Init (void) {
 
 void usb_dc_low_level_init (void) {  // hid_custom_init()
     USBHS_RCC_Init();
+    SetVTFIRQ ((uint32_t)USBHS_IRQHandler, USBHS_IRQn, 0, ENABLE);  // RAMУFLASHеry_ramfunc.h
     NVIC_EnableIRQ (USBHS_IRQn);
 }
\ No newline at end of file
@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_boot.h"
+#include "ry_record.h"
+#include "ry_crc.h"
+#include "ry_log.h"
+#include <string.h>
+
+/* 写入W25Q64槽的流，按页编程，进入新的块时先擦除该块 */
+typedef struct {
+    uint32_t base;
+    uint32_t addr;        // 下一页编程地址
+    uint32_t erased_end;  // 已擦除区域的结束地址
+    uint32_t size;
+    uint16_t fill;
+    uint8_t active;
+    __attribute__((aligned(4))) uint8_t page[SPI_FLASH_PageSize];
+} ry_slot_stream;
+
+static ry_slot_stream ry_slot;
+static ry_boot_record_t ry_boot;
+static ry_record_area ry_boot_area = {RY_BOOT_RECORD_ADDR, sizeof (ry_boot_record_t)};
+static __attribute__((aligned(4))) uint8_t ry_boot_buf[2][512];
+
+static void ry_slot_begin (uint32_t base, uint32_t offset) {
+    ry_slot.base = base;
+    ry_slot.addr = base + offset;
+    ry_slot.erased_end = ry_slot.addr;
+    ry_slot.size = offset;
+    ry_slot.fill = 0;
+    ry_slot.active = 1;
+}
+
+static HAL_StatusTypeDef ry_slot_program (void) {
+    if (ry_slot.addr + SPI_FLASH_PageSize > ry_slot.base + IAP_IMAGE_MAX) {
+        return HAL_ERROR;
+    }
+    // W25Q64擦除期间不能编程，提前擦除没有好处；擦除命令立即返回，由下一次编程等待
+    if ((ry_slot.addr >= ry_slot.erased_end) && (Flash_BlockErase32K (ry_slot.erased_end) == HAL_OK)) {
+        ry_slot.erased_end += RY_SLOT_BLOCK;
+    }
+    if (Flash_PageProgram (ry_slot.addr, ry_slot.page, SPI_FLASH_PageSize) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    ry_slot.addr += SPI_FLASH_PageSize;
+    ry_slot.fill = 0;
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef ry_slot_write (const uint8_t *data, uint32_t len) {
+    uint32_t n;
+
+    if (!ry_slot.active) {
+        return HAL_ERROR;
+    }
+    while (len) {
+        n = SPI_FLASH_PageSize - ry_slot.fill;
+        if (n > len) {
+            n = len;
+        }
+        memcpy (&ry_slot.page[ry_slot.fill], data, n);
+        ry_slot.fill += n;
+        ry_slot.size += n;
+        data += n;
+        len -= n;
+        if ((ry_slot.fill == SPI_FLASH_PageSize) && (ry_slot_program() != HAL_OK)) {
+            return HAL_ERROR;
+        }
+    }
+    return HAL_OK;
+}
+
+static uint32_t ry_slot_finish (void) {
+    if (!ry_slot.active) {
+        return 0;
+    }
+    if (ry_slot.fill) {
+        memset (&ry_slot.page[ry_slot.fill], 0xFF, SPI_FLASH_PageSize - ry_slot.fill);
+        ry_slot_program();
+    }
+    Flash_WaitBusy();
+    ry_slot.active = 0;
+    return ry_slot.size;
+}
+
+/**
+ * @brief  计算槽中镜像的CRC32，读取下一段（SPI DMA）与上一段的CRC计算（DMA）同时进行
+ */
+static uint32_t ry_slot_crc (uint32_t addr, uint32_t size) {
+    uint32_t n, next, done = 0;
+    uint8_t i = 0;
+
+    ry_crc_reset();
+    n = (size > sizeof (ry_boot_buf[0])) ? sizeof (ry_boot_buf[0]) : size;
+    Flash_ReadData (addr, ry_boot_buf[0], n);
+    while (n) {
+        if (n & 3) {
+            memset (&ry_boot_buf[i][n], 0xFF, 4 - (n & 3));
+        }
+        ry_crc_start ((const uint32_t *)ry_boot_buf[i], (n + 3) / 4);
+        done += n;
+        next = size - done;
+        if (next > sizeof (ry_boot_buf[0])) {
+            next = sizeof (ry_boot_buf[0]);
+        }
+        if (next) {
+            Flash_ReadData (addr + done, ry_boot_buf[i ^ 1], next);
+        }
+        ry_crc_wait();
+        n = next;
+        i ^= 1;
+    }
+    return ry_crc_value();
+}
+
+/**
+ * @brief  槽中的镜像写入APP区，读回校验后写入有效性记录
+ * @note   下一段的SPI DMA读取与本段的编程、下一块的提前擦除（IAP_Stream_Poll）同时进行
+ */
+static HAL_StatusTypeDef ry_slot_install (uint32_t addr, uint32_t size, uint32_t crc) {
+    const IAP_RecordTypeDef *rec = IAP_Record_Get();
+    uint32_t generation = rec ? rec->generation + 1 : 1;
+    HAL_StatusTypeDef status = HAL_OK;
+    uint32_t n, next, done = 0;
+    uint8_t i = 0;
+
+    IAP_Record_Clear();  // 写入过程中掉电时不被当作有效固件
+    IAP_Stream_Begin();
+    n = (size > sizeof (ry_boot_buf[0])) ? sizeof (ry_boot_buf[0]) : size;
+    if (n && (Flash_ReadData_DMA (addr, ry_boot_buf[0], n) != HAL_OK)) {
+        status = HAL_ERROR;
+    }
+    while (n && (status == HAL_OK)) {
+        SPI_FLASH_DMA_Wait();
+        next = size - done - n;
+        if (next > sizeof (ry_boot_buf[0])) {
+            next = sizeof (ry_boot_buf[0]);
+        }
+        if (next && (Flash_ReadData_DMA (addr + done + n, ry_boot_buf[i ^ 1], next) != HAL_OK)) {
+            status = HAL_ERROR;
+        }
+        // 镜像还需要下一块时才提前擦除，不多擦APP区
+        if ((done / IAP_BLOCK_SIZE + 1) * IAP_BLOCK_SIZE < size) {
+            IAP_Stream_Poll();
+        }
+        if (IAP_Stream_Write (ry_boot_buf[i], n) != IAP_OK) {
+            status = HAL_ERROR;
+        }
+        done += n;
+        n = next;
+        i ^= 1;
+    }
+    SPI_FLASH_DMA_Wait();
+    IAP_Stream_Finish();
+    if ((status == HAL_OK) && (ry_crc_block ((const void *)IAP_APP_ADDR, size) != crc)) {
+        status = HAL_ERROR;
+    }
+    if (status == HAL_OK) {
+        IAP_Record_Write (size, crc, generation);  // 读回校验通过后才写入，同时清除确认字
+    } else {
+        IAP_Record_Invalidate();
+    }
+    return status;
+}
+
+static HAL_StatusTypeDef ry_boot_commit (ry_boot_state state) {
+    ry_boot.magic = RY_BOOT_MAGIC;
+    ry_boot.state = state;
+    memset (ry_boot.reserved, 0, sizeof (ry_boot.reserved));
+    return ry_record_append (&ry_boot_area, &ry_boot);
+}
+
+static const ry_boot_record_t *ry_boot_get (void) {
+    if (!ry_boot_area.loaded && ry_record_load (&ry_boot_area, &ry_boot) &&
+        (ry_boot.magic != RY_BOOT_MAGIC)) {
+        memset (&ry_boot, 0, sizeof (ry_boot));
+    }
+    return &ry_boot;
+}
+
+/**
+ * @brief  从R恢复上一版本
+ */
+static void ry_boot_rollback (void) {
+    if (ry_boot.bak_size == 0) {
+        RY_LOG_E ("no backup, keep current app\r\n", 0, 0);
+    } else if (ry_slot_install (RY_SLOT_BACKUP_ADDR, ry_boot.bak_size, ry_boot.bak_crc) != HAL_OK) {
+        RY_LOG_E ("rollback failed\r\n", 0, 0);
+        return;  // 保持原状态，下次上电重试
+    } else {
+        RY_LOG_W ("rollback to backup:%u crc:%x\r\n", ry_boot.bak_size, ry_boot.bak_crc);
+        ry_boot.size = ry_boot.bak_size;
+        ry_boot.crc = ry_boot.bak_crc;
+    }
+    ry_boot.bak_size = 0;
+    ry_boot.trials = 0;
+    ry_boot_commit (RY_BOOT_IDLE);
+}
+
+/**
+ * @brief  继续未完成的安装：备份A到R，B写入A，进入试运行
+ */
+static HAL_StatusTypeDef ry_boot_resume (void) {
+    uint32_t size, a_size, a_crc;
+
+    if (ry_boot.state == RY_BOOT_PENDING) {
+        a_size = ry_boot.bak_size;  // PENDING中bak_size/bak_crc为A中当前固件，见ry_boot_activate()
+        a_crc = ry_boot.bak_crc;
+        // 经过本流程安装的固件长度已知，其余情况备份整个APP区；APP区为空时不备份
+        size = ry_boot.bak_size ? ry_boot.bak_size : IAP_IMAGE_MAX;
+        if (*(volatile uint32_t *)IAP_APP_ADDR == 0xFFFFFFFF) {
+            size = 0;
+        }
+        ry_boot.bak_size = size;
+        ry_boot.bak_crc = ry_crc_block ((const void *)IAP_APP_ADDR, size);
+        if (size) {
+            ry_slot_begin (RY_SLOT_BACKUP_ADDR, 0);
+            ry_slot_write ((const uint8_t *)IAP_APP_ADDR, size);
+            ry_slot_finish();
+            if (ry_slot_crc (RY_SLOT_BACKUP_ADDR, size) != ry_boot.bak_crc) {
+                RY_LOG_E ("backup failed\r\n", 0, 0);
+                // 不安装，A保持不变：IDLE记录恢复A的长度和CRC；R已被部分覆盖，不能再用于回滚
+                ry_boot.size = a_size;
+                ry_boot.crc = a_crc;
+                ry_boot.bak_size = 0;
+                ry_boot.bak_crc = 0;
+                ry_boot_commit (RY_BOOT_IDLE);
+                return HAL_ERROR;
+            }
+        }
+        if (ry_boot_commit (RY_BOOT_COPY) != HAL_OK) {
+            return HAL_ERROR;
+        }
+    }
+
+    if (ry_boot.state == RY_BOOT_COPY) {
+        if (ry_slot_install (RY_SLOT_STAGE_ADDR, ry_boot.size, ry_boot.crc) != HAL_OK) {
+            RY_LOG_E ("install failed\r\n", 0, 0);
+            ry_boot_rollback();
+            return HAL_ERROR;
+        }
+        ry_boot.trials = 0;
+        return ry_boot_commit (RY_BOOT_TRIAL);
+    }
+    return HAL_OK;
+}
+
+/**
+ * @brief  开始把新固件写入暂存槽B
+ * @param  offset，续传起点，必须为RY_SLOT_BLOCK的整数倍
+ */
+HAL_StatusTypeDef ry_boot_stage_begin (uint32_t offset) {
+    if ((offset % RY_SLOT_BLOCK) || (offset >= IAP_IMAGE_MAX)) {
+        return HAL_ERROR;
+    }
+    ry_slot_begin (RY_SLOT_STAGE_ADDR, offset);
+    return HAL_OK;
+}
+
+/**
+ * @retval HAL_ERROR：超出APP区长度
+ */
+HAL_StatusTypeDef ry_boot_stage_write (const uint8_t *data, uint32_t len) {
+    return ry_slot_write (data, len);
+}
+
+/**
+ * @brief  结束写入暂存槽，不安装
+ * @retval 固件长度
+ */
+uint32_t ry_boot_stage_finish (void) {
+    return ry_slot_finish();
+}
+
+uint8_t ry_boot_stage_active (void) {
+    return ry_slot.active;
+}
+
+/**
+ * @brief  校验暂存槽中的新固件，切换状态并安装
+ * @param  crc，期望的CRC32，NULL时不比较（仍用于安装后的读回校验）
+ * @retval HAL_ERROR：校验失败（A不受影响）或安装失败（已回滚）
+ */
+HAL_StatusTypeDef ry_boot_activate (uint32_t size, const uint32_t *crc) {
+    uint32_t stage_crc = ry_slot_crc (RY_SLOT_STAGE_ADDR, size);
+
+    if ((size == 0) || (crc && (*crc != stage_crc))) {
+        RY_LOG_E ("stage crc:%x size:%u\r\n", stage_crc, size);
+        return HAL_ERROR;
+    }
+    ry_boot_get();
+    if (ry_boot.state == RY_BOOT_IDLE) {
+        ry_boot.bak_size = ry_boot.size;  // A中当前固件，PENDING中备份
+        ry_boot.bak_crc = ry_boot.crc;
+        ry_boot.state = RY_BOOT_PENDING;
+    } else {
+        ry_boot.state = RY_BOOT_COPY;  // 上一个新固件还未确认，A不一定可用，保留R中的备份
+    }
+    ry_boot.size = size;
+    ry_boot.crc = stage_crc;
+    if (ry_boot_commit (ry_boot.state) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    return ry_boot_resume();
+}
+
+/**
+ * @brief  上电检查：继续未完成的安装，试运行计数，超过次数未确认时回滚
+ * @note   SPI FLASH初始化（fatfs_file_init）之后调用
+ */
+void ry_boot_check (void) {
+    ry_boot_get();
+    switch (ry_boot.state) {
+    case RY_BOOT_PENDING:
+    case RY_BOOT_COPY:
+        ry_boot_resume();
+        break;
+
+    case RY_BOOT_TRIAL:
+        if (IAP_Confirmed()) {
+            ry_boot_commit (RY_BOOT_IDLE);
+        } else if (ry_boot.trials >= RY_BOOT_TRIALS) {
+            ry_boot_rollback();
+        } else {
+            ry_boot.trials++;
+            ry_boot_commit (RY_BOOT_TRIAL);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
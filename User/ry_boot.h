@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_BOOT_H
+#define RY_BOOT_H
+
+#include "iap.h"
+#include "ry_journal.h"
+
+//--------------------------A/B升级------------------------------------
+// 内部FLASH只有256K，APP区不够分成两个槽，另外两个槽放在W25Q64中FatFs之后：
+// A：内部FLASH的APP区，运行的固件
+// B：暂存槽，收到的新固件完整写入这里并校验，期间A不受影响
+// R：备份槽，安装前A的备份，新固件试运行失败时从这里恢复
+// 状态记录保存在记录扇区中（见ry_record.h），每次切换写入一条，切换是原子的：
+// IDLE    : A为已确认的固件
+// PENDING : B已校验，等待备份A
+// COPY    : 备份完成，正在把B写入A；中途掉电时上电后重新写入
+// TRIAL   : 新固件试运行，每次上电trials加1，APP写入确认页（见iap.h）后回到IDLE，
+//           RY_BOOT_TRIALS次上电仍未确认则从R恢复
+//--------------------------------------------------------------------
+#define RY_BOOT_RECORD_ADDR (RY_JOURNAL_ADDR + RY_RECORD_AREA_SIZE)
+#define RY_SLOT_STAGE_ADDR  (RY_JOURNAL_ADDR + FLASH_BLOCK64_SIZE)
+#define RY_SLOT_BACKUP_ADDR (RY_SLOT_STAGE_ADDR + IAP_APP_SIZE)
+#define RY_SLOT_BLOCK       FLASH_BLOCK32_SIZE  // 暂存槽按块擦除，续传只能从块边界开始
+#define RY_BOOT_TRIALS      3
+#define RY_BOOT_MAGIC       0x4252  // "RB"
+
+typedef enum {
+    RY_BOOT_IDLE = 0,
+    RY_BOOT_PENDING,
+    RY_BOOT_COPY,
+    RY_BOOT_TRIAL
+} ry_boot_state;
+
+typedef struct {
+    uint16_t magic;
+    uint8_t state;
+    uint8_t trials;
+    uint32_t size;          // A中的固件（IDLE）或待安装的B（其他状态）
+    uint32_t crc;
+    uint32_t bak_size;      // R中的备份，0表示没有备份
+    uint32_t bak_crc;
+    uint32_t reserved[2];
+    uint32_t check;
+} ry_boot_record_t;
+
+HAL_StatusTypeDef ry_boot_stage_begin(uint32_t offset);
+HAL_StatusTypeDef ry_boot_stage_write(const uint8_t *data, uint32_t len);
+uint32_t ry_boot_stage_finish(void);
+uint8_t ry_boot_stage_active(void);
+HAL_StatusTypeDef ry_boot_activate(uint32_t size, const uint32_t *crc);
+void ry_boot_check(void);
+
+#endif /* RY_BOOT_H */
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_clock.h"
+#include "ry_log.h"
+#include "ry_event.h"
+#include "debug.h"
+
+#ifdef CH32V30x_D8
+#define RY_CLOCK_MUL12      RCC_PLLMULL12
+#define RY_CLOCK_MUL18      RCC_PLLMULL18
+#else
+#define RY_CLOCK_MUL12      RCC_PLLMULL12_EXTEN
+#define RY_CLOCK_MUL18      RCC_PLLMULL18_EXTEN
+#endif
+
+typedef struct
+{
+  uint32_t pllmul;          // PLLCLK = HSE(8MHz) * pllmul
+  uint32_t flash_access;    // FLASH访问时钟
+} ry_clock_cfg;
+
+/* FLASH访问时钟保持系统时钟的1/2（复位值，与SystemInit()一致） */
+static const ry_clock_cfg ry_clock_cfgs[RY_CLOCK_NUM] = {
+    {RY_CLOCK_MUL12, FLASH_Access_SYSTEM_HALF},
+    {RY_CLOCK_MUL18, FLASH_Access_SYSTEM_HALF},
+};
+
+static ry_clock_profile ry_clock_profile_cur = RY_CLOCK_NORMAL;
+
+/**
+ * @brief  切换系统时钟，HCLK/PCLK分频不变
+ * @note   主循环中调用；等待日志发送完成，切换期间关中断（先切到HSI，PLL重新锁定）
+ */
+void ry_clock_set (ry_clock_profile profile) {
+    const ry_clock_cfg *cfg = &ry_clock_cfgs[profile];
+
+    if (profile == ry_clock_profile_cur) {
+        return;
+    }
+    ry_log_flush();
+    __disable_irq();
+
+    RCC->CTLR |= RCC_HSION;
+    while ((RCC->CTLR & RCC_HSIRDY) == 0) {
+    }
+    RCC->CFGR0 = (RCC->CFGR0 & ~RCC_SW) | RCC_SW_HSI;
+    while ((RCC->CFGR0 & RCC_SWS) != RCC_SWS_HSI) {
+    }
+
+    RCC->CTLR &= ~RCC_PLLON;
+    while (RCC->CTLR & RCC_PLLRDY) {
+    }
+    RCC->CFGR0 = (RCC->CFGR0 & ~RCC_PLLMULL) | cfg->pllmul;
+    RCC->CTLR |= RCC_PLLON;
+    while ((RCC->CTLR & RCC_PLLRDY) == 0) {
+    }
+
+    FLASH_Unlock();
+    FLASH_Access_Clock_Cfg (cfg->flash_access);
+    FLASH_Lock();
+
+    RCC->CFGR0 = (RCC->CFGR0 & ~RCC_SW) | RCC_SW_PLL;
+    while ((RCC->CFGR0 & RCC_SWS) != RCC_SWS_PLL) {
+    }
+    __enable_irq();
+
+    ry_clock_profile_cur = profile;
+    SystemCoreClockUpdate();
+    Delay_Init();
+    USART_Printf_Update();
+    ry_event_tick_update();
+}
+
+ry_clock_profile ry_clock_get (void) {
+    return ry_clock_profile_cur;
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_CLOCK_H
+#define RY_CLOCK_H
+
+#include "ch32v30x.h"
+
+//--------------------------时钟切换------------------------------------
+// 上电由SystemInit()设置为96MHz（system_ch32v30x.c），升级过程中切换到144MHz，
+// CRC、解压、FatFs等CPU处理快50%，结束后恢复
+// 切换后重新计算SystemCoreClock、Delay、调试串口波特率，设置FLASH访问时钟
+// USBHS时钟来自HSE和USB PHY PLL，不受影响；SPI3（APB1 2分频）由24MHz变为36MHz
+// 跳转到APP前恢复为96MHz（ry_fastboot_jump()）
+//--------------------------------------------------------------------
+typedef enum
+{
+  RY_CLOCK_NORMAL = 0,      // 96MHz，与SystemInit()一致
+  RY_CLOCK_BOOST,           // 144MHz，升级过程中
+  RY_CLOCK_NUM
+} ry_clock_profile;
+
+void ry_clock_set(ry_clock_profile profile);
+ry_clock_profile ry_clock_get(void);
+
+#endif /* RY_CLOCK_H */
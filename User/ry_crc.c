@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_crc.h"
+#include <string.h>
+
+static const uint32_t *ry_crc_next;  // DMA完成一段后继续的位置
+static uint32_t ry_crc_left;         // 未启动DMA的字数
+
+static void ry_crc_dma (void) {
+    uint32_t n = (ry_crc_left > RY_CRC_DMA_MAX) ? RY_CRC_DMA_MAX : ry_crc_left;
+
+    RY_CRC_DMA_CH->CFGR &= ~DMA_CFGR1_EN;
+    RY_CRC_DMA_CH->PADDR = (uint32_t)ry_crc_next;
+    RY_CRC_DMA_CH->CNTR = n;
+    RY_CRC_DMA_CH->CFGR |= DMA_CFGR1_EN;
+    ry_crc_next += n;
+    ry_crc_left -= n;
+}
+
+/**
+ * @brief  开始新的CRC计算，初始化DMA内存到内存通道
+ */
+void ry_crc_reset (void) {
+    DMA_InitTypeDef DMA_InitStructure = {0};
+
+    RCC_AHBPeriphClockCmd (RCC_AHBPeriph_CRC | RCC_AHBPeriph_DMA2, ENABLE);
+    CRC_ResetDR();
+
+    DMA_DeInit (RY_CRC_DMA_CH);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = 0;  // 源地址，每段设置
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)&CRC->DATAR;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = 0;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Enable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Disable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Enable;
+    DMA_Init (RY_CRC_DMA_CH, &DMA_InitStructure);
+    ry_crc_left = 0;
+}
+
+/**
+ * @brief  启动DMA把一段数据送入CRC单元，立即返回
+ * @param  data   4字节对齐，内部FLASH或RAM
+ * @param  words  字数，超过DMA计数范围时在ry_crc_wait()中分段续传
+ * @note   上一段必须已经ry_crc_wait()
+ */
+void ry_crc_start (const uint32_t *data, uint32_t words) {
+    ry_crc_next = data;
+    ry_crc_left = words;
+    if (words) {
+        DMA_ClearFlag (RY_CRC_DMA_FLAG_TC);
+        ry_crc_dma();
+    }
+}
+
+/**
+ * @brief  等待已启动的数据全部送入CRC单元
+ */
+void ry_crc_wait (void) {
+    if (!(RY_CRC_DMA_CH->CFGR & DMA_CFGR1_EN)) {
+        return;
+    }
+    for (;;) {
+        while (!DMA_GetFlagStatus (RY_CRC_DMA_FLAG_TC)) {
+        }
+        DMA_ClearFlag (RY_CRC_DMA_FLAG_TC);
+        if (!ry_crc_left) {
+            break;
+        }
+        ry_crc_dma();
+    }
+    RY_CRC_DMA_CH->CFGR &= ~DMA_CFGR1_EN;
+}
+
+uint32_t ry_crc_value (void) {
+    return CRC->DATAR;
+}
+
+/**
+ * @brief  计算一块数据的CRC32，结尾不足一个字时补0xFF
+ * @param  data  4字节对齐
+ */
+uint32_t ry_crc_block (const void *data, uint32_t len) {
+    uint32_t tail = 0xFFFFFFFF;
+
+    ry_crc_reset();
+    ry_crc_start ((const uint32_t *)data, len / 4);
+    if (len & 3) {
+        memcpy (&tail, (const uint8_t *)data + (len & ~3), len & 3);
+    }
+    ry_crc_wait();
+    if (len & 3) {
+        CRC_CalcCRC (tail);
+    }
+    return ry_crc_value();
+}
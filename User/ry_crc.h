@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_CRC_H
+#define RY_CRC_H
+
+#include "debug.h"
+
+//--------------------------CRC32校验------------------------------------
+// 使用片上CRC单元（多项式0x04C11DB7，初值0xFFFFFFFF，按32位字输入，不反转，不异或），
+// 数据由DMA内存到内存传输写入CRC->DATAR，CPU在此期间可以继续读取下一段数据
+// 镜像长度不是4的倍数时按0xFF补齐（与FLASH擦除值、IAP_Stream_Finish的补齐一致）
+//--------------------------------------------------------------------
+#define RY_CRC_DMA_CH       DMA2_Channel3
+#define RY_CRC_DMA_FLAG_TC  DMA2_FLAG_TC3
+#define RY_CRC_DMA_MAX      65535  // DMA计数寄存器为16位
+
+void ry_crc_reset(void);
+void ry_crc_start(const uint32_t *data, uint32_t words);
+void ry_crc_wait(void);
+uint32_t ry_crc_value(void);
+uint32_t ry_crc_block(const void *data, uint32_t len);
+
+#endif /* RY_CRC_H */
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_delta.h"
+#include "ry_crc.h"
+#include <string.h>
+
+#define RY_DELTA_HEAD   0  // 接收文件头
+#define RY_DELTA_CTRL   1  // 接收记录头
+#define RY_DELTA_DIFF   2
+#define RY_DELTA_EXTRA  3
+#define RY_DELTA_DONE   4  // 新固件已全部输出
+#define RY_DELTA_ERROR  5
+
+static uint32_t ry_delta_u32 (const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t ry_delta_flush (ry_delta_t *delta, ry_delta_sink sink, void *ctx) {
+    uint8_t err = 0;
+
+    if (delta->out_fill) {
+        err = sink (delta->out, delta->out_fill, ctx);
+        delta->out_fill = 0;
+    }
+    return err;
+}
+
+/**
+ * @brief  检查文件头，旧固件长度和CRC32必须与当前固件一致
+ */
+static uint8_t ry_delta_head (ry_delta_t *delta) {
+    if (ry_delta_u32 (&delta->hdr[0]) != RY_DELTA_MAGIC) {
+        return 1;
+    }
+    delta->old_size = ry_delta_u32 (&delta->hdr[4]);
+    delta->new_size = ry_delta_u32 (&delta->hdr[12]);
+    if ((delta->old_size > delta->old_limit) || (delta->old_size & 3) ||
+        (delta->new_size == 0) || (delta->new_size > delta->new_limit)) {
+        return 1;
+    }
+
+    return ry_crc_block (delta->old, delta->old_size) != ry_delta_u32 (&delta->hdr[8]);
+}
+
+/**
+ * @brief  检查记录头，diff不能读出旧固件，输出不能超过新固件长度
+ */
+static uint8_t ry_delta_ctrl (ry_delta_t *delta) {
+    delta->diff = ry_delta_u32 (&delta->hdr[0]);
+    delta->extra = ry_delta_u32 (&delta->hdr[4]);
+    delta->seek = (int32_t)ry_delta_u32 (&delta->hdr[8]);
+
+    if ((delta->diff > delta->old_size - delta->old_pos) ||
+        (delta->diff > delta->new_size - delta->new_pos) ||
+        (delta->extra > delta->new_size - delta->new_pos - delta->diff)) {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief  一条记录结束，移动old_pos
+ */
+static uint8_t ry_delta_next (ry_delta_t *delta) {
+    int64_t pos = (int64_t)delta->old_pos + delta->seek;
+
+    if ((pos < 0) || (pos > delta->old_size)) {
+        return 1;
+    }
+    delta->old_pos = (uint32_t)pos;
+    delta->state = (delta->new_pos == delta->new_size) ? RY_DELTA_DONE : RY_DELTA_CTRL;
+    return 0;
+}
+
+/**
+ * @brief  diff/extra用完时进入下一阶段，不等待下一个输入字节
+ */
+static uint8_t ry_delta_advance (ry_delta_t *delta) {
+    if ((delta->state == RY_DELTA_DIFF) && (delta->diff == 0)) {
+        delta->state = RY_DELTA_EXTRA;
+    }
+    if ((delta->state == RY_DELTA_EXTRA) && (delta->extra == 0)) {
+        return ry_delta_next (delta);
+    }
+    return 0;
+}
+
+/**
+ * @brief  开始应用一个补丁
+ * @param  old        旧固件地址
+ * @param  old_limit  旧固件区域长度，补丁头中的旧固件长度不能超过
+ * @param  new_limit  新固件最大长度
+ */
+void ry_delta_init (ry_delta_t *delta, const uint8_t *old, uint32_t old_limit, uint32_t new_limit) {
+    delta->old = old;
+    delta->old_limit = old_limit;
+    delta->new_limit = new_limit;
+    delta->old_pos = 0;
+    delta->new_pos = 0;
+    delta->fill = 0;
+    delta->out_fill = 0;
+    delta->state = RY_DELTA_HEAD;
+}
+
+/**
+ * @brief  应用一段补丁数据，新固件按顺序交给sink
+ * @param  in   补丁数据，可以在任意字节处分段
+ * @retval 0:成功 1:补丁错误、与旧固件不匹配或sink返回非0，之后的数据都返回错误
+ */
+uint8_t ry_delta_apply (ry_delta_t *delta, const uint8_t *in, uint32_t len, ry_delta_sink sink, void *ctx) {
+    const uint8_t *end = in + len;
+    uint32_t n, i;
+    uint16_t size;
+    uint8_t err = 0;
+
+    while ((in != end) && !err) {
+        switch (delta->state) {
+        case RY_DELTA_HEAD:
+        case RY_DELTA_CTRL:
+            size = (delta->state == RY_DELTA_HEAD) ? RY_DELTA_HEAD_SIZE : RY_DELTA_CTRL_SIZE;
+            n = size - delta->fill;
+            if (n > (uint32_t)(end - in)) {
+                n = end - in;
+            }
+            memcpy (&delta->hdr[delta->fill], in, n);
+            delta->fill += n;
+            in += n;
+            if (delta->fill < size) {
+                break;
+            }
+            delta->fill = 0;
+            if (delta->state == RY_DELTA_HEAD) {
+                err = ry_delta_head (delta);
+                delta->state = RY_DELTA_CTRL;
+            } else if (!(err = ry_delta_ctrl (delta))) {
+                delta->state = RY_DELTA_DIFF;
+                err = ry_delta_advance (delta);
+            }
+            break;
+
+        case RY_DELTA_DIFF:
+            n = end - in;
+            if (n > delta->diff) {
+                n = delta->diff;
+            }
+            if (n > RY_DELTA_OUT_SIZE - delta->out_fill) {
+                n = RY_DELTA_OUT_SIZE - delta->out_fill;
+            }
+            for (i = 0; i < n; i++) {
+                delta->out[delta->out_fill + i] = delta->old[delta->old_pos + i] + in[i];
+            }
+            delta->out_fill += n;
+            delta->old_pos += n;
+            delta->new_pos += n;
+            delta->diff -= n;
+            in += n;
+            if (delta->out_fill == RY_DELTA_OUT_SIZE) {
+                err = ry_delta_flush (delta, sink, ctx);
+            }
+            if (!err) {
+                err = ry_delta_advance (delta);
+            }
+            break;
+
+        case RY_DELTA_EXTRA:
+            // extra数据直接从输入输出，不经过out
+            n = end - in;
+            if (n > delta->extra) {
+                n = delta->extra;
+            }
+            err = ry_delta_flush (delta, sink, ctx) || sink (in, n, ctx);
+            delta->new_pos += n;
+            delta->extra -= n;
+            in += n;
+            if (!err) {
+                err = ry_delta_advance (delta);
+            }
+            break;
+
+        default:
+            err = 1;  // 补丁结束后还有数据，或之前已出错
+            break;
+        }
+    }
+    if (!err) {
+        err = ry_delta_flush (delta, sink, ctx);  // 本段输出立即写入，与下一包接收重叠
+    }
+    if (err) {
+        delta->state = RY_DELTA_ERROR;
+    }
+    return err;
+}
+
+/**
+ * @brief  新固件是否已全部输出
+ */
+uint8_t ry_delta_done (const ry_delta_t *delta) {
+    return delta->state == RY_DELTA_DONE;
+}
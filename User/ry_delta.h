@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_DELTA_H
+#define RY_DELTA_H
+
+#include "debug.h"
+
+//--------------------------补丁格式------------------------------------
+// bsdiff风格，顺序应用，旧固件只读，新固件按顺序输出，不需要在RAM中保存整个镜像
+// 所有整数为小端
+// 文件头16Byte:
+// [0-3]  :"RYDP"
+// [4-7]  :旧固件长度，4的倍数（主机按FLASH擦除值0xFF补齐）
+// [8-11] :旧固件CRC32，见ry_crc.h，旧固件不一致时拒绝补丁
+// [12-15]:新固件长度
+// 之后为若干记录，每条记录:
+// [0-3]  :diff长度，新[i] = 旧[old_pos + i] + diff[i]，old_pos随之增加
+// [4-7]  :extra长度，其后diff长度字节的diff数据和extra长度字节的新数据原样输出
+// [8-11] :seek，有符号，记录结束后old_pos += seek
+// 新固件输出满新固件长度后补丁结束
+//--------------------------------------------------------------------
+#define RY_DELTA_MAGIC      0x50445952  // "RYDP"
+#define RY_DELTA_HEAD_SIZE  16
+#define RY_DELTA_CTRL_SIZE  12
+#define RY_DELTA_OUT_SIZE   256
+
+/* 新固件输出，返回非0时停止 */
+typedef uint8_t (*ry_delta_sink)(const uint8_t *data, uint16_t len, void *ctx);
+
+typedef struct {
+    const uint8_t *old;        // 旧固件，内部FLASH直接寻址读取
+    uint32_t old_limit;        // 旧固件区域长度
+    uint32_t new_limit;        // 新固件最大长度
+    uint32_t old_size;
+    uint32_t new_size;
+    uint32_t old_pos;
+    uint32_t new_pos;          // 已输出字节数（含out中未输出的）
+    uint32_t diff;             // 当前记录剩余diff长度
+    uint32_t extra;            // 当前记录剩余extra长度
+    int32_t seek;
+    uint16_t fill;             // hdr中已收到字节数
+    uint16_t out_fill;
+    uint8_t state;
+    uint8_t hdr[RY_DELTA_HEAD_SIZE];
+    uint8_t out[RY_DELTA_OUT_SIZE];
+} ry_delta_t;
+
+void ry_delta_init(ry_delta_t *delta, const uint8_t *old, uint32_t old_limit, uint32_t new_limit);
+uint8_t ry_delta_apply(ry_delta_t *delta, const uint8_t *in, uint32_t len, ry_delta_sink sink, void *ctx);
+uint8_t ry_delta_done(const ry_delta_t *delta);
+
+#endif /* RY_DELTA_H */
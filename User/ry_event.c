@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_event.h"
+#include "debug.h"
+#include "ry_ramfunc.h"
+
+void SysTick_Handler (void) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+static volatile uint32_t ry_event_pending;  // 每个事件一位
+static ry_event_handler ry_event_handlers[RY_EVENT_NUM];
+static uint8_t ry_event_tick_on;
+
+void ry_event_register (ry_event_id id, ry_event_handler handler) {
+    ry_event_handlers[id] = handler;
+}
+
+/**
+ * @brief  登记事件，中断和主循环中都可以调用
+ * @note   同一事件在处理前多次登记只处理一次
+ */
+RY_RAMFUNC void ry_event_post (ry_event_id id) {
+    __atomic_fetch_or (&ry_event_pending, 1u << id, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief  处理一轮已登记的事件，没有事件时休眠
+ * @note   关中断后检查再WFI：检查之后到来的中断挂起，WFI立即唤醒，不会丢失事件
+ */
+void ry_event_dispatch (void) {
+    uint32_t pending;
+    uint8_t id;
+
+    __disable_irq();
+    pending = ry_event_pending;
+    if (pending == 0) {
+        __WFI();
+        __enable_irq();
+        return;
+    }
+    __enable_irq();
+
+    pending = __atomic_exchange_n (&ry_event_pending, 0, __ATOMIC_RELAXED);
+    for (id = 0; id < RY_EVENT_NUM; id++) {
+        if ((pending & (1u << id)) && ry_event_handlers[id]) {
+            ry_event_handlers[id]();
+        }
+    }
+}
+
+/**
+ * @brief  启动或按新的SystemCoreClock重新设置SysTick定时
+ */
+void ry_event_tick_init (void) {
+    SysTick->CTLR = 0;
+    SysTick->SR = 0;
+    SysTick->CNT = 0;
+    SysTick->CMP = SystemCoreClock / 8 / 1000 * RY_EVENT_TICK_MS - 1;
+    SysTick->CTLR = (1 << 3) | (1 << 1) | (1 << 0);  // 自动重装，中断，HCLK/8，使能
+    NVIC_EnableIRQ (SysTicK_IRQn);
+    ry_event_tick_on = 1;
+}
+
+void SysTick_Handler (void) {
+    SysTick->SR = 0;
+    ry_event_post (RY_EVENT_TICK);
+}
+
+/**
+ * @brief  时钟切换后调用，定时未启动时不处理
+ */
+void ry_event_tick_update (void) {
+    if (ry_event_tick_on) {
+        ry_event_tick_init();
+    }
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_EVENT_H
+#define RY_EVENT_H
+
+#include <stdint.h>
+
+//--------------------------事件调度------------------------------------
+// 1.中断回调只调用ry_event_post()登记事件（原子置位，可嵌套），不做处理
+// 2.主循环ry_event_dispatch()按编号从小到大依次调用已登记事件的处理函数，
+//   每个处理函数只做有限的工作（如处理一个包），还有剩余时重新登记，
+//   保证其余事件的调度延迟不超过一轮
+// 3.没有事件时WFI休眠，直到下一个中断
+// 4.SysTick每RY_EVENT_TICK_MS产生RY_EVENT_TICK（HCLK/8），Delay_Us/Delay_Ms同样使用SysTick，
+//   开始调度后不能再调用
+//--------------------------------------------------------------------
+#define RY_EVENT_TICK_MS    10
+
+typedef enum
+{
+  RY_EVENT_USB_CONFIGURED = 0,  // USB枚举完成
+  RY_EVENT_USB_OUT,             // OUT端点收到数据包
+  RY_EVENT_USB_IN,              // IN端点发送完成
+  RY_EVENT_LOG,                 // 有新的日志记录
+  RY_EVENT_TICK,                // 定时
+  RY_EVENT_NUM
+} ry_event_id;
+
+typedef void (*ry_event_handler)(void);
+
+void ry_event_register(ry_event_id id, ry_event_handler handler);
+void ry_event_post(ry_event_id id);
+void ry_event_dispatch(void);
+void ry_event_tick_init(void);
+void ry_event_tick_update(void);
+
+#endif /* RY_EVENT_H */
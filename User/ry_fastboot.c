@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_fastboot.h"
+#include "ry_clock.h"
+
+static uint32_t ry_fastboot_main_cycle;  // 进入main时的mcycle（SystemInit之前按HSI计）
+
+static void ry_fastboot_record (uint32_t us, uint16_t path) {
+    PWR->CTLR |= PWR_CTLR_DBP;
+    BKP->DATAR2 = (uint16_t)us;
+    BKP->DATAR3 = (uint16_t)(us >> 16);
+    BKP->DATAR4 = path;
+    PWR->CTLR &= ~PWR_CTLR_DBP;
+}
+
+static void ry_fastboot_goto (void) {
+    ((void (*)(void))IAP_APP_ENTRY)();
+}
+
+/**
+ * @brief  复位后最先执行，满足条件时直接跳转到APP，不返回
+ * @note   在.data/.bss初始化之前调用，不能使用全局变量
+ */
+void ry_fastboot (void) {
+    RCC->APB1PCENR |= RCC_PWREN | RCC_BKPEN;
+    if ((BKP->DATAR1 != 0) || !IAP_Confirmed() || !IAP_Record_Quick()) {
+        return;
+    }
+    ry_fastboot_record (__get_MCYCLE() / (HSI_VALUE / 1000000), RY_BOOT_PATH_FAST);
+    RCC->APB1PCENR &= ~(RCC_PWREN | RCC_BKPEN);
+    ry_fastboot_goto();
+}
+
+/**
+ * @brief  读取并清除APP的请求，main()开始时调用
+ * @retval 0:没有请求，RY_BOOT_REQUEST:进入升级，RY_BOOT_VERIFY:完整校验后跳转
+ */
+uint16_t ry_fastboot_requested (void) {
+    uint16_t request;
+
+    ry_fastboot_main_cycle = __get_MCYCLE();
+    RCC->APB1PCENR |= RCC_PWREN | RCC_BKPEN;
+    request = BKP->DATAR1;
+    if (request) {
+        PWR->CTLR |= PWR_CTLR_DBP;
+        BKP->DATAR1 = 0;  // 只进入一次，升级完成后复位运行APP
+        PWR->CTLR &= ~PWR_CTLR_DBP;
+    }
+    return request;
+}
+
+/**
+ * @brief  APP区是否可以运行（不要求已确认，试运行的固件也跳转）
+ * @param  full：1:计算整个固件的CRC与记录比较，0:首尾两页不一致时才计算
+ * @note   没有有效性记录（调试器直接下载）时只检查APP区不为空
+ */
+uint8_t ry_fastboot_app_valid (uint8_t full) {
+    if (IAP_Record_Get() == NULL) {
+        return *(volatile uint32_t *)IAP_APP_ADDR != 0xFFFFFFFF;
+    }
+    if (!full && IAP_Record_Quick()) {
+        return 1;
+    }
+    return IAP_Record_Full();
+}
+
+/**
+ * @brief  输出上一次复位到跳转APP的时间
+ */
+void ry_fastboot_report (void) {
+    uint32_t us = BKP->DATAR2 | ((uint32_t)BKP->DATAR3 << 16);
+
+    if (BKP->DATAR4) {
+        printf ("last boot to app:%uus path:%u\r\n", us, BKP->DATAR4);
+    }
+}
+
+/**
+ * @brief  main()中跳转到APP：关中断，复位外设，关闭DMA，不返回
+ * @note   调用前发送完日志；时钟恢复为96MHz PLL，由APP的SystemInit()重新配置
+ */
+void ry_fastboot_jump (void) {
+    static DMA_Channel_TypeDef *const dma[] = {
+        DMA1_Channel1, DMA1_Channel2, DMA1_Channel3, DMA1_Channel4, DMA1_Channel5, DMA1_Channel6, DMA1_Channel7,
+        DMA2_Channel1, DMA2_Channel2, DMA2_Channel3, DMA2_Channel4, DMA2_Channel5};
+    uint32_t us;
+    uint8_t i;
+
+    us = ry_fastboot_main_cycle / (HSI_VALUE / 1000000) +
+         (__get_MCYCLE() - ry_fastboot_main_cycle) / (SystemCoreClock / 1000000);
+    ry_fastboot_record (us, RY_BOOT_PATH_SLOW);
+    ry_clock_set (RY_CLOCK_NORMAL);  // APP从SystemInit()的状态开始
+
+    __disable_irq();
+    for (i = 0; i < 8; i++) {
+        NVIC->IRER[i] = 0xFFFFFFFF;
+    }
+    for (i = 0; i < 4; i++) {
+        NVIC->VTFADDR[i] = 0;  // VTF不随跳转复位，入口可能指向IAP的RAM函数
+    }
+    SysTick->CTLR = 0;
+    for (i = 0; i < sizeof (dma) / sizeof (dma[0]); i++) {
+        dma[i]->CFGR = 0;
+    }
+    RCC->APB2PRSTR = 0xFFFFFFFF;
+    RCC->APB2PRSTR = 0;
+    RCC->APB1PRSTR = ~(RCC_BKPRST | RCC_PWRRST);  // 保留后备寄存器中的启动记录
+    RCC->APB1PRSTR = 0;
+    RCC->APB2PCENR = 0;
+    RCC->APB1PCENR = 0;
+    RCC->AHBPCENR = 0x14;  // 复位值（SRAM、FLASH接口）
+    ry_fastboot_goto();
+}
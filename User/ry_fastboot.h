@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_FASTBOOT_H
+#define RY_FASTBOOT_H
+
+#include "iap.h"
+
+//--------------------------快速启动------------------------------------
+// 1.ry_fastboot()在startup中最先执行（.data/.bss初始化和SystemInit之前，HSI 8MHz）：
+//   没有请求、APP已确认且有效性记录与首尾两页一致（见iap.h记录页）时直接跳转到APP，
+//   外设和中断都还是复位状态，不计算整个固件的CRC
+// 2.否则进入main()：初始化SPI FLASH，完成ry_boot_check()（安装/试运行计数/回滚），
+//   没有升级请求且APP有效时，复位用过的外设后跳转（ry_fastboot_jump()），
+//   首尾两页与记录不一致或APP请求校验时才计算整个固件的CRC
+// 3.只有升级请求或APP区为空时才初始化USB，进入升级
+// APP请求升级：使能PWR/BKP时钟和后备域写入，BKP_DR1写入RY_BOOT_REQUEST后复位，
+// 写入RY_BOOT_VERIFY则完整校验APP后跳转
+// 每次跳转把复位到跳转的时间（us）记录在BKP_DR2/3，方式记录在BKP_DR4，
+// APP或下一次进入升级时可以读出
+//--------------------------------------------------------------------
+#define RY_BOOT_REQUEST     0x5259      // "RY"
+#define RY_BOOT_VERIFY      0x5256      // "RV"
+#define RY_BOOT_PATH_FAST   1
+#define RY_BOOT_PATH_SLOW   2
+#define IAP_APP_ENTRY       (IAP_APP_ADDR - FLASH_BASE)  // 从0地址映射区执行，与WCH IAP例程一致
+
+void ry_fastboot(void);
+uint16_t ry_fastboot_requested(void);
+uint8_t ry_fastboot_app_valid(uint8_t full);
+void ry_fastboot_report(void);
+void ry_fastboot_jump(void);
+
+#endif /* RY_FASTBOOT_H */
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_journal.h"
+#include "ry_record.h"
+
+static ry_journal_t ry_journal;
+static ry_record_area ry_journal_area = {RY_JOURNAL_ADDR, sizeof (ry_journal_t)};
+
+/**
+ * @brief  当前有效的进度记录，没有时type为0
+ */
+const ry_journal_t *ry_journal_get (void) {
+    if (!ry_journal_area.loaded && ry_record_load (&ry_journal_area, &ry_journal) &&
+        (ry_journal.magic != RY_JOURNAL_MAGIC)) {
+        ry_journal.type = 0;
+    }
+    return &ry_journal;
+}
+
+/**
+ * @brief  提交传输进度
+ * @param  type    数据类型，0表示清除（传输完成或不可续传）
+ * @param  id      镜像ID
+ * @param  offset  已持久化的字节数，调用前数据必须已写入FLASH
+ */
+HAL_StatusTypeDef ry_journal_commit (uint16_t type, uint32_t id, uint32_t offset) {
+    ry_journal_t rec;
+
+    ry_journal_get();
+    if ((ry_journal.type == type) && (ry_journal.id == id) && (ry_journal.offset == offset)) {
+        return HAL_OK;
+    }
+    rec.magic = RY_JOURNAL_MAGIC;
+    rec.type = type;
+    rec.id = id;
+    rec.offset = offset;
+    if (ry_record_append (&ry_journal_area, &rec) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    ry_journal = rec;
+    return HAL_OK;
+}
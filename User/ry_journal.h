@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_JOURNAL_H
+#define RY_JOURNAL_H
+
+#include "ry_record.h"
+
+//--------------------------传输进度日志---------------------------------
+// 记录可续传传输的进度，保存在W25Q64中FatFs之外的两个记录扇区（FatFs只使用前2MB，
+// 见ry_record.h），USB断开掉电后仍然有效（BKP寄存器掉电丢失，不适合总线供电的下载器）
+//--------------------------------------------------------------------
+#define RY_JOURNAL_ADDR     (FLASH_SECTOR_COUNT * FLASH_SECTOR_SIZE)
+#define RY_JOURNAL_MAGIC    0x4A52  // "RJ"
+
+typedef struct {
+    uint16_t magic;
+    uint16_t type;      // 传输的数据类型，0:没有可续传的传输
+    uint32_t id;        // 主机指定的镜像ID（如文件CRC32）
+    uint32_t offset;    // 已写入并持久化的字节数，从这里续传
+    uint32_t check;
+} ry_journal_t;
+
+const ry_journal_t *ry_journal_get(void);
+HAL_StatusTypeDef ry_journal_commit(uint16_t type, uint32_t id, uint32_t offset);
+
+#endif /* RY_JOURNAL_H */
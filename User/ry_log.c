@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_log.h"
+#include "ry_event.h"
+#include "ry_ramfunc.h"
+
+//--------------------------日志缓冲------------------------------------
+// USB回调在中断中执行，直接printf会阻塞在115200波特率的串口上（每字符约87us）
+// 1.生产者只写入一条二进制记录{fmt, arg0..arg3}，单生产者单消费者，无锁
+// 2.消费者ry_log_poll()在主循环中格式化记录，通过DMA发送，不等待串口；
+//   写入记录时登记RY_EVENT_LOG，DMA发送中未能发出的记录由RY_EVENT_TICK继续发送
+// 3.缓冲满时丢弃新记录并计数，下次发送时输出丢弃条数；消费者用原子交换读取并清零，
+//   读和清零之间中断中的计数不会丢失
+//--------------------------------------------------------------------
+#define RY_LOG_DEPTH    64   // 必须为2的幂
+#define RY_LOG_TX_SIZE  256
+
+typedef struct {
+    const char *fmt;
+    uint32_t arg0;
+    uint32_t arg1;
+    uint32_t arg2;
+    uint32_t arg3;
+} ry_log_record;
+
+static ry_log_record ry_log_ring[RY_LOG_DEPTH];
+static volatile uint16_t ry_log_head;  // 生产者递增
+static volatile uint16_t ry_log_tail;  // 消费者递增
+static volatile uint32_t ry_log_dropped;  // 32位：amoswap.w
+static char ry_log_tx[RY_LOG_TX_SIZE];
+
+/**
+ * @brief  DEBUG串口TX DMA初始化，在USART_Printf_Init()之后调用
+ */
+void ry_log_init (void) {
+    DMA_InitTypeDef DMA_InitStructure = {0};
+
+    RCC_AHBPeriphClockCmd (RCC_AHBPeriph_DMA1, ENABLE);
+    DMA_DeInit (DEBUG_DMA_TX_CH);
+
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&DEBUG_USART->DATAR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)ry_log_tx;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = 0;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init (DEBUG_DMA_TX_CH, &DMA_InitStructure);
+
+    USART_DMACmd (DEBUG_USART, USART_DMAReq_Tx, ENABLE);
+}
+
+/* 写入一条记录，调用者保证不被其他生产者打断 */
+RY_RAMFUNC static void ry_log_write (const char *fmt, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+    uint16_t head = ry_log_head;
+    ry_log_record *rec;
+
+    if ((uint16_t)(head - ry_log_tail) >= RY_LOG_DEPTH) {
+        ry_log_dropped++;
+        return;
+    }
+    rec = &ry_log_ring[head & (RY_LOG_DEPTH - 1)];
+    rec->fmt = fmt;
+    rec->arg0 = arg0;
+    rec->arg1 = arg1;
+    rec->arg2 = arg2;
+    rec->arg3 = arg3;
+    __asm volatile ("" ::: "memory");  // 记录写完后再发布head
+    ry_log_head = head + 1;
+    ry_event_post (RY_EVENT_LOG);
+}
+
+/**
+ * @brief  写入一条日志记录（生产者）
+ * @note   只能在中断中调用，主循环使用ry_log_put()
+ */
+RY_RAMFUNC void ry_log_isr (const char *fmt, uint32_t arg0, uint32_t arg1) {
+    ry_log_write (fmt, arg0, arg1, 0, 0);
+}
+
+/**
+ * @brief  主循环中写入一条日志记录
+ * @note   与中断中的生产者共用缓冲，只在写一条记录期间关中断
+ */
+void ry_log_put (const char *fmt, uint32_t arg0, uint32_t arg1) {
+    __disable_irq();
+    ry_log_write (fmt, arg0, arg1, 0, 0);
+    __enable_irq();
+}
+
+/**
+ * @brief  主循环中写入一条四个参数的日志记录
+ */
+void ry_log_put4 (const char *fmt, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+    __disable_irq();
+    ry_log_write (fmt, arg0, arg1, arg2, arg3);
+    __enable_irq();
+}
+
+/**
+ * @brief  发送缓冲中的全部日志并等待串口发送完成，跳转到APP前调用
+ */
+void ry_log_flush (void) {
+    do {
+        ry_log_poll();
+    } while ((ry_log_tail != ry_log_head) || (DEBUG_DMA_TX_CH->CNTR != 0));
+    while (USART_GetFlagStatus (DEBUG_USART, USART_FLAG_TC) == RESET) {
+    }
+}
+
+/**
+ * @brief  消费者：上一次DMA发送完成后，把缓冲中的记录格式化并启动下一次发送
+ * @note   在主循环中调用
+ */
+void ry_log_poll (void) {
+    uint16_t len = 0;
+    uint32_t dropped;
+    ry_log_record *rec;
+    int n;
+
+    if (DEBUG_DMA_TX_CH->CNTR != 0) {
+        return;
+    }
+    dropped = __atomic_exchange_n (&ry_log_dropped, 0, __ATOMIC_RELAXED);
+    if (dropped) {
+        len = snprintf (ry_log_tx, RY_LOG_TX_SIZE, "log dropped:%u\r\n", (unsigned)dropped);
+    }
+    while (ry_log_tail != ry_log_head) {
+        rec = &ry_log_ring[ry_log_tail & (RY_LOG_DEPTH - 1)];
+        n = snprintf (&ry_log_tx[len], RY_LOG_TX_SIZE - len, rec->fmt, rec->arg0, rec->arg1, rec->arg2, rec->arg3);
+        if (n < 0) {
+            n = 0;
+        }
+        if (len + n >= RY_LOG_TX_SIZE) {
+            if (len) {
+                break;  // 放不下，下次发送
+            }
+            n = RY_LOG_TX_SIZE - 1;  // 单条超长，截断
+        }
+        len += n;
+        ry_log_tail++;
+    }
+    if (len) {
+        DMA_Cmd (DEBUG_DMA_TX_CH, DISABLE);
+        DEBUG_DMA_TX_CH->MADDR = (uint32_t)ry_log_tx;
+        DEBUG_DMA_TX_CH->CNTR = len;
+        DMA_Cmd (DEBUG_DMA_TX_CH, ENABLE);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_LOG_H
+#define RY_LOG_H
+
+#include "debug.h"
+
+/* 日志等级，编译时过滤：高于RY_LOG_LEVEL的日志宏为空，不产生任何代码 */
+#define RY_LOG_LVL_NONE     0
+#define RY_LOG_LVL_ERR      1
+#define RY_LOG_LVL_WARN     2
+#define RY_LOG_LVL_INFO     3
+#define RY_LOG_LVL_DBG      4
+
+#ifndef RY_LOG_LEVEL
+#define RY_LOG_LEVEL        RY_LOG_LVL_INFO
+#endif
+
+#ifdef RY_NO_DEBUG
+#undef RY_LOG_LEVEL
+#define RY_LOG_LEVEL        RY_LOG_LVL_NONE
+#endif
+
+/*
+ * 每条日志只记录格式字符串指针和最多四个参数，格式化在主循环的ry_log_poll()中完成：
+ * fmt必须是常量字符串，只用%d/%u/%x参数
+ * RY_LOG_x：主循环中使用，两个参数
+ * RY_LOG_x4：主循环中使用，四个参数，一行统计信息用一条记录输出
+ * RY_ISR_LOG_x：中断中使用（USBHS中断是唯一的中断生产者）
+ */
+#define RY_LOG_ARGS(fmt, a0, a1) (fmt), (uint32_t)(a0), (uint32_t)(a1)
+#define RY_LOG_ARGS4(fmt, a0, a1, a2, a3) (fmt), (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3)
+
+#if (RY_LOG_LEVEL >= RY_LOG_LVL_ERR)
+#define RY_LOG_E(fmt, a0, a1)       ry_log_put (RY_LOG_ARGS (fmt, a0, a1))
+#define RY_ISR_LOG_E(fmt, a0, a1)   ry_log_isr (RY_LOG_ARGS (fmt, a0, a1))
+#define RY_LOG_E4(fmt, a0, a1, a2, a3) ry_log_put4 (RY_LOG_ARGS4 (fmt, a0, a1, a2, a3))
+#else
+#define RY_LOG_E(fmt, a0, a1)       ((void)0)
+#define RY_ISR_LOG_E(fmt, a0, a1)   ((void)0)
+#define RY_LOG_E4(fmt, a0, a1, a2, a3) ((void)0)
+#endif
+
+#if (RY_LOG_LEVEL >= RY_LOG_LVL_WARN)
+#define RY_LOG_W(fmt, a0, a1)       ry_log_put (RY_LOG_ARGS (fmt, a0, a1))
+#define RY_ISR_LOG_W(fmt, a0, a1)   ry_log_isr (RY_LOG_ARGS (fmt, a0, a1))
+#define RY_LOG_W4(fmt, a0, a1, a2, a3) ry_log_put4 (RY_LOG_ARGS4 (fmt, a0, a1, a2, a3))
+#else
+#define RY_LOG_W(fmt, a0, a1)       ((void)0)
+#define RY_ISR_LOG_W(fmt, a0, a1)   ((void)0)
+#define RY_LOG_W4(fmt, a0, a1, a2, a3) ((void)0)
+#endif
+
+#if (RY_LOG_LEVEL >= RY_LOG_LVL_INFO)
+#define RY_LOG_I(fmt, a0, a1)       ry_log_put (RY_LOG_ARGS (fmt, a0, a1))
+#define RY_ISR_LOG_I(fmt, a0, a1)   ry_log_isr (RY_LOG_ARGS (fmt, a0, a1))
+#define RY_LOG_I4(fmt, a0, a1, a2, a3) ry_log_put4 (RY_LOG_ARGS4 (fmt, a0, a1, a2, a3))
+#else
+#define RY_LOG_I(fmt, a0, a1)       ((void)0)
+#define RY_ISR_LOG_I(fmt, a0, a1)   ((void)0)
+#define RY_LOG_I4(fmt, a0, a1, a2, a3) ((void)0)
+#endif
+
+#if (RY_LOG_LEVEL >= RY_LOG_LVL_DBG)
+#define RY_LOG_D(fmt, a0, a1)       ry_log_put (RY_LOG_ARGS (fmt, a0, a1))
+#define RY_ISR_LOG_D(fmt, a0, a1)   ry_log_isr (RY_LOG_ARGS (fmt, a0, a1))
+#define RY_LOG_D4(fmt, a0, a1, a2, a3) ry_log_put4 (RY_LOG_ARGS4 (fmt, a0, a1, a2, a3))
+#else
+#define RY_LOG_D(fmt, a0, a1)       ((void)0)
+#define RY_ISR_LOG_D(fmt, a0, a1)   ((void)0)
+#define RY_LOG_D4(fmt, a0, a1, a2, a3) ((void)0)
+#endif
+
+void ry_log_init(void);
+void ry_log_isr(const char *fmt, uint32_t arg0, uint32_t arg1);
+void ry_log_put(const char *fmt, uint32_t arg0, uint32_t arg1);
+void ry_log_put4(const char *fmt, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+void ry_log_poll(void);
+void ry_log_flush(void);
+
+#endif /* RY_LOG_H */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_lz.h"
+
+#define RY_LZ_CTRL      0  // 等待控制字节
+#define RY_LZ_LITERAL   1  // 复制count个字面量
+#define RY_LZ_DIST      2  // 等待距离低字节
+
+/**
+ * @brief  window中未交给sink的数据输出，window写满一圈前必须调用
+ * @note   按pending判断有无数据：pos回到flushed既可能是没有新数据，也可能是写满了一圈
+ * @retval sink的返回值
+ */
+static uint8_t ry_lz_flush (ry_lz_t *lz, ry_lz_sink sink, void *ctx) {
+    const uint8_t *data = &lz->window[lz->flushed];
+    uint16_t len = lz->pending;
+
+    if (len == 0) {
+        return 0;  // 空包、只有控制字节的包、刚在回绕时输出过
+    }
+    lz->flushed = lz->pos;
+    lz->pending = 0;
+    return sink (data, len, ctx);
+}
+
+static uint8_t ry_lz_put (ry_lz_t *lz, uint8_t c, ry_lz_sink sink, void *ctx) {
+    lz->window[lz->pos] = c;
+    lz->pos = (lz->pos + 1) & (RY_LZ_WINDOW - 1);
+    lz->total++;
+    lz->pending++;
+    return lz->pos ? 0 : ry_lz_flush (lz, sink, ctx);  // 回绕前输出到窗口末尾
+}
+
+/**
+ * @brief  开始解码一个新的数据流
+ */
+void ry_lz_init (ry_lz_t *lz) {
+    lz->total = 0;
+    lz->pos = 0;
+    lz->flushed = 0;
+    lz->pending = 0;
+    lz->count = 0;
+    lz->state = RY_LZ_CTRL;
+}
+
+/**
+ * @brief  解码一段压缩数据，解出的数据按window的连续段交给sink
+ * @param  in   压缩数据，可以在任意字节处分段
+ * @retval 0:成功 1:数据错误（距离超出已输出数据）或sink返回非0
+ */
+uint8_t ry_lz_decode (ry_lz_t *lz, const uint8_t *in, uint16_t len, ry_lz_sink sink, void *ctx) {
+    const uint8_t *end = in + len;
+    uint16_t dist;
+    uint8_t c;
+
+    while (in != end) {
+        switch (lz->state) {
+        case RY_LZ_CTRL:
+            c = *in++;
+            if (c < 0x80) {
+                lz->count = c + 1;
+                lz->state = RY_LZ_LITERAL;
+            } else {
+                lz->ctrl = c;
+                lz->state = RY_LZ_DIST;
+            }
+            break;
+
+        case RY_LZ_LITERAL:
+            if (ry_lz_put (lz, *in++, sink, ctx)) {
+                return 1;
+            }
+            if (--lz->count == 0) {
+                lz->state = RY_LZ_CTRL;
+            }
+            break;
+
+        case RY_LZ_DIST:
+            dist = (((lz->ctrl & 0x07) << 8) | *in++) + 1;
+            lz->count = ((lz->ctrl >> 3) & 0x0F) + RY_LZ_MIN_MATCH;
+            if (dist > lz->total) {
+                return 1;
+            }
+            // 复制不消耗输入，在这里一次完成，不必等下一个输入字节
+            while (lz->count) {
+                c = lz->window[(lz->pos - dist) & (RY_LZ_WINDOW - 1)];
+                lz->count--;
+                if (ry_lz_put (lz, c, sink, ctx)) {
+                    return 1;
+                }
+            }
+            lz->state = RY_LZ_CTRL;
+            break;
+
+        default:
+            return 1;
+        }
+    }
+    return ry_lz_flush (lz, sink, ctx);  // 本段解出的数据立即写入，与下一包接收重叠
+}
+
+/**
+ * @brief  数据流是否在完整的字面量/复制边界结束
+ */
+uint8_t ry_lz_done (const ry_lz_t *lz) {
+    return lz->state == RY_LZ_CTRL;
+}
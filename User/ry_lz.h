@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_LZ_H
+#define RY_LZ_H
+
+#include <stdint.h>
+
+//--------------------------压缩格式------------------------------------
+// LZ77，窗口2048Byte，按字节流解码，输入可以在任意位置分包
+// 控制字节c:
+// c < 0x80 : 字面量，其后c+1个字节原样输出(1-128Byte)
+// c >= 0x80: 复制，长度((c >> 3) & 0x0F) + 3(3-18Byte)，
+//            距离((c & 0x07) << 8 | 下一字节) + 1(1-2048Byte)，允许与输出重叠
+//--------------------------------------------------------------------
+// 压缩端（主机）：贪心查找窗口内最长匹配，长度>=3时输出复制，否则并入字面量（host/tools/ry_lzc.c）
+//--------------------------------------------------------------------
+#define RY_LZ_WINDOW        2048  // 必须为2的幂
+#define RY_LZ_MIN_MATCH     3
+#define RY_LZ_MAX_MATCH     18
+#define RY_LZ_MAX_LITERAL   128
+
+/* 解码输出，返回非0时停止解码 */
+typedef uint8_t (*ry_lz_sink)(const uint8_t *data, uint16_t len, void *ctx);
+
+typedef struct {
+    uint8_t window[RY_LZ_WINDOW];  // 历史数据，同时作为输出缓冲
+    uint32_t total;                // 已输出字节数
+    uint16_t pos;                  // window写位置
+    uint16_t flushed;              // window中未交给sink的数据起点
+    uint16_t pending;              // 未交给sink的字节数，0-RY_LZ_WINDOW
+    uint16_t count;                // 当前字面量剩余长度
+    uint8_t ctrl;                  // 等待距离低字节的控制字节
+    uint8_t state;
+} ry_lz_t;
+
+void ry_lz_init(ry_lz_t *lz);
+uint8_t ry_lz_decode(ry_lz_t *lz, const uint8_t *in, uint16_t len, ry_lz_sink sink, void *ctx);
+uint8_t ry_lz_done(const ry_lz_t *lz);
+
+#endif /* RY_LZ_H */
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_prof.h"
+#include "ry_log.h"
+#include "ry_ramfunc.h"
+#include <string.h>
+
+//--------------------------耗时统计------------------------------------
+// RY_PROF_BEGIN/RY_PROF_END成对放在同一作用域内，记录两者之间的mcycle差值
+// 每个统计点只在一个上下文中记录（中断或主循环），记录本身不关中断；
+// 读取快照时关中断复制，保证count/total一致
+//--------------------------------------------------------------------
+static ry_prof_stat ry_prof_stats[RY_PROF_SITE_NUM];
+
+/* 日志记录只保存fmt指针和整数参数，统计点名称直接写在每行的格式字符串中 */
+static const char *const ry_prof_lines[RY_PROF_SITE_NUM] = {
+    "usb_irq      %7u %8u %8u %8u\r\n",
+    "hid_process  %7u %8u %8u %8u\r\n",
+    "disk_read    %7u %8u %8u %8u\r\n",
+    "disk_write   %7u %8u %8u %8u\r\n",
+    "flash_erase  %7u %8u %8u %8u\r\n",
+    "flash_wait   %7u %8u %8u %8u\r\n",
+};
+
+RY_RAMFUNC void ry_prof_record (ry_prof_site site, uint32_t cycles) {
+    ry_prof_stat *stat = &ry_prof_stats[site];
+
+    if ((stat->count == 0) || (cycles < stat->min)) {
+        stat->min = cycles;
+    }
+    if (cycles > stat->max) {
+        stat->max = cycles;
+    }
+    stat->total += cycles;
+    stat->count++;
+}
+
+/**
+ * @brief  复制全部统计点
+ * @param  stats，RY_PROF_SITE_NUM个元素
+ */
+void ry_prof_snapshot (ry_prof_stat *stats) {
+    __disable_irq();
+    memcpy (stats, ry_prof_stats, sizeof (ry_prof_stats));
+    __enable_irq();
+}
+
+void ry_prof_reset (void) {
+    __disable_irq();
+    memset (ry_prof_stats, 0, sizeof (ry_prof_stats));
+    __enable_irq();
+}
+
+/**
+ * @brief  通过日志缓冲输出统计，单位为CPU周期
+ * @note   不直接printf：阻塞在串口上，且与日志DMA发送的内容交错
+ */
+void ry_prof_dump (void) {
+    ry_prof_stat stats[RY_PROF_SITE_NUM];
+
+    ry_prof_snapshot (stats);
+    RY_LOG_I ("site           count      min      max      avg\r\n", 0, 0);
+    for (int i = 0; i < RY_PROF_SITE_NUM; i++) {
+        RY_LOG_I4 (ry_prof_lines[i], stats[i].count, stats[i].min, stats[i].max,
+                   stats[i].count ? stats[i].total / stats[i].count : 0);
+    }
+}
+
+//--------------------------RAM占用------------------------------------
+// 没有堆（不使用malloc），RAM占用 = .ramfunc/.data/.bss（链接时确定） + 栈峰值
+// 栈峰值：上电后把未使用的栈填充固定值，之后从栈底向上找第一个被改写的字
+//--------------------------------------------------------------------
+#define RY_PROF_STACK_FILL 0xA5A5A5A5
+
+extern uint32_t _susrstack[];
+extern uint32_t _eusrstack[];
+extern uint32_t _ramfunc_vma[];
+extern uint32_t _ebss[];
+
+/**
+ * @brief  填充当前栈指针以下的未使用栈，在main()开头调用
+ */
+void ry_prof_stack_paint (void) {
+    uint32_t *p = _susrstack;
+    uint32_t *sp;
+
+    __asm volatile ("mv %0, sp" : "=r"(sp));
+    sp -= 16;  // 保留本函数使用的栈
+    while (p < sp) {
+        *p++ = RY_PROF_STACK_FILL;
+    }
+}
+
+/**
+ * @brief  上电以来栈使用峰值（字节）
+ */
+uint32_t ry_prof_stack_peak (void) {
+    uint32_t *p = _susrstack;
+
+    while ((p < _eusrstack) && (*p == RY_PROF_STACK_FILL)) {
+        p++;
+    }
+    return (uint32_t)_eusrstack - (uint32_t)p;
+}
+
+/**
+ * @brief  静态RAM占用（.ramfunc + .data + .bss，字节）
+ */
+uint32_t ry_prof_static_ram (void) {
+    return (uint32_t)_ebss - (uint32_t)_ramfunc_vma;  // .ramfunc在.data之前
+}
+
+static uint8_t *ry_prof_put32 (uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+/**
+ * @brief  生成HID feature报告数据（不含报告ID）
+ * @retval 长度，RY_PROF_REPORT_SIZE
+ */
+uint32_t ry_prof_report (uint8_t *buf) {
+    ry_prof_stat stats[RY_PROF_SITE_NUM];
+    uint8_t *p = buf;
+
+    ry_prof_snapshot (stats);
+    for (int i = 0; i < RY_PROF_SITE_NUM; i++) {
+        p = ry_prof_put32 (p, stats[i].count);
+        p = ry_prof_put32 (p, stats[i].min);
+        p = ry_prof_put32 (p, stats[i].max);
+        p = ry_prof_put32 (p, stats[i].count ? (uint32_t)(stats[i].total / stats[i].count) : 0);
+    }
+    return p - buf;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_PROF_H
+#define RY_PROF_H
+
+#include <stdint.h>
+
+/* 热点耗时统计（mcycle），RY_PROF_ENABLE为0时所有宏为空 */
+#ifndef RY_PROF_ENABLE
+#define RY_PROF_ENABLE      1
+#endif
+
+typedef enum
+{
+  RY_PROF_USB_IRQ = 0,      // USBD_IRQHandler
+  RY_PROF_HID_PROCESS,      // hid_data_process
+  RY_PROF_DISK_READ,        // disk_read
+  RY_PROF_DISK_WRITE,       // disk_write
+  RY_PROF_FLASH_ERASE,      // Flash_SectorErase
+  RY_PROF_FLASH_WAIT,       // Flash_WaitBusy，SPI FLASH忙等待
+  RY_PROF_SITE_NUM
+} ry_prof_site;
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+} ry_prof_stat;
+
+/* HID feature报告：每个统计点16Byte，count/min/max/avg，小端 */
+#define RY_PROF_REPORT_SIZE (RY_PROF_SITE_NUM * 16)
+
+/* 同__get_MCYCLE()；core_riscv.h依赖ch32v30x.h，与USB port的寄存器定义冲突，这里直接读CSR */
+static inline uint32_t ry_prof_cycle(void)
+{
+  uint32_t result;
+
+  __asm volatile ("csrr %0, mcycle" : "=r" (result));
+  return result;
+}
+
+#if RY_PROF_ENABLE
+#define RY_PROF_BEGIN(site)     uint32_t ry_prof_t_##site = ry_prof_cycle()
+#define RY_PROF_END(site)       ry_prof_record (site, ry_prof_cycle() - ry_prof_t_##site)
+#else
+#define RY_PROF_BEGIN(site)
+#define RY_PROF_END(site)       ((void)0)
+#endif
+
+void ry_prof_record(ry_prof_site site, uint32_t cycles);
+void ry_prof_stack_paint(void);
+uint32_t ry_prof_stack_peak(void);
+uint32_t ry_prof_static_ram(void);
+void ry_prof_snapshot(ry_prof_stat *stats);
+void ry_prof_reset(void);
+void ry_prof_dump(void);
+uint32_t ry_prof_report(uint8_t *buf);
+
+#endif /* RY_PROF_H */
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_RAMFUNC_H
+#define RY_RAMFUNC_H
+
+//--------------------------RAM中执行------------------------------------
+// 内部FLASH擦除/编程期间从FLASH取指会等待，USB中断被推迟到操作结束
+// RY_RAMFUNC函数放在.ramfunc段（Ld/Link.ld），启动时由startup从FLASH复制到RAM
+// 1.USB中断和数据端点路径：USBHS_IRQHandler，端点重新使能，端点回调，事件登记
+// 2.FLASH快速擦除/编程（StdPeriph和CherryUSB core中的函数在Link.ld中按段名放入）
+// USBHS中断使用VTF，入口地址在PFIC寄存器中，不读FLASH中的向量表
+// 注意：RAM函数中调用的函数也要在RAM中，不能使用FLASH中的常量表
+//--------------------------------------------------------------------
+#define RY_RAMFUNC          __attribute__((section(".ramfunc"), noinline))
+
+#endif /* RY_RAMFUNC_H */
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_record.h"
+#include <string.h>
+
+#define RY_RECORD_MAX   64          // 最大记录长度
+#define RY_RECORD_MAGIC 0x44524352  // "RCRD"
+#define RY_RECORD_HEAD  12          // 扇区头{magic, seq, ~seq}
+
+static uint32_t ry_record_check (const uint32_t *w, uint16_t words) {
+    uint32_t check = 0;
+
+    while (--words) {
+        check ^= *w++;
+    }
+    return ~check;
+}
+
+static uint32_t ry_record_sector (const ry_record_area *area, uint8_t sector) {
+    return area->addr + sector * FLASH_SECTOR_SIZE;
+}
+
+/* 读扇区头，返回1时*seq有效 */
+static uint8_t ry_record_head (const ry_record_area *area, uint8_t sector, uint32_t *seq) {
+    uint32_t h[RY_RECORD_HEAD / 4];
+
+    Flash_ReadData (ry_record_sector (area, sector), (uint8_t *)h, RY_RECORD_HEAD);
+    *seq = h[1];
+    return (h[0] == RY_RECORD_MAGIC) && (h[1] == ~h[2]);
+}
+
+static uint8_t ry_record_blank (const ry_record_area *area, uint8_t sector) {
+    uint32_t w[RY_RECORD_MAX / 4];
+    uint32_t addr = ry_record_sector (area, sector);
+    uint16_t i, k;
+
+    for (i = 0; i < FLASH_SECTOR_SIZE; i += RY_RECORD_MAX) {
+        Flash_ReadData (addr + i, (uint8_t *)w, RY_RECORD_MAX);
+        for (k = 0; k < RY_RECORD_MAX / 4; k++) {
+            if (w[k] != 0xFFFFFFFF) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * 扫描一个扇区的记录，返回1时rec为最后一条有效记录，area->slot为第一个空位置
+ */
+static uint8_t ry_record_scan (ry_record_area *area, uint8_t sector, void *rec) {
+    uint32_t w[RY_RECORD_MAX / 4];
+    uint32_t addr = ry_record_sector (area, sector);
+    uint16_t words = area->size / 4;
+    uint16_t slots = FLASH_SECTOR_SIZE / area->size;
+    uint16_t i, k;
+    uint8_t found = 0;
+
+    area->slot = slots;
+    for (i = 1; i < slots; i++) {
+        Flash_ReadData (addr + i * area->size, (uint8_t *)w, area->size);
+        for (k = 0; (k < words) && (w[k] == 0xFFFFFFFF); k++) {
+        }
+        if (k == words) {
+            area->slot = i;  // 记录按顺序追加，第一个空位置之后都是空的
+            break;
+        }
+        if (w[words - 1] == ry_record_check (w, words)) {
+            memcpy (rec, w, area->size);
+            found = 1;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief  读取最后一条有效记录
+ * @param  rec，没有有效记录时清零
+ * @retval 1:找到有效记录
+ */
+uint8_t ry_record_load (ry_record_area *area, void *rec) {
+    uint32_t seq[2];
+    uint8_t valid[2], order[2], i, s;
+    uint8_t found = 0;
+
+    memset (rec, 0, area->size);
+    valid[0] = ry_record_head (area, 0, &seq[0]);
+    valid[1] = ry_record_head (area, 1, &seq[1]);
+    // 较新的扇区在前，seq按回绕比较
+    order[0] = (valid[1] && (!valid[0] || ((int32_t)(seq[1] - seq[0]) > 0))) ? 1 : 0;
+    order[1] = order[0] ^ 1;
+
+    area->sector = 1;
+    area->seq = 0;
+    for (i = 0; i < 2; i++) {
+        s = order[i];
+        if (valid[s] && ry_record_scan (area, s, rec)) {
+            area->sector = s;
+            area->seq = seq[s];
+            found = 1;
+            break;
+        }
+    }
+    if (!found) {
+        // 视为扇区1已写满，第一次追加切换到扇区0
+        area->slot = FLASH_SECTOR_SIZE / area->size;
+        if (valid[order[0]]) {
+            area->seq = seq[order[0]];  // 新扇区的seq大于所有已用过的seq
+        }
+    }
+    area->spare_dirty = !ry_record_blank (area, area->sector ^ 1);
+    area->loaded = 1;
+    return found;
+}
+
+/* 当前扇区写满：记录和头写入另一个扇区，之后擦除旧扇区 */
+static HAL_StatusTypeDef ry_record_switch (ry_record_area *area, void *rec) {
+    uint8_t spare = area->sector ^ 1;
+    uint32_t addr = ry_record_sector (area, spare);
+    uint32_t h[RY_RECORD_HEAD / 4];
+
+    if (area->spare_dirty && (Flash_SectorErase (addr) != HAL_OK)) {
+        return HAL_ERROR;
+    }
+    h[0] = RY_RECORD_MAGIC;
+    h[1] = area->seq + 1;
+    h[2] = ~h[1];
+    // 先写记录再写头：头写完之前掉电，这个扇区被忽略，旧扇区仍然有效
+    if ((Flash_PageProgram (addr + area->size, (uint8_t *)rec, area->size) != HAL_OK) ||
+        (Flash_PageProgram (addr, (uint8_t *)h, RY_RECORD_HEAD) != HAL_OK) || (Flash_WaitBusy() != HAL_OK)) {
+        area->spare_dirty = 1;
+        return HAL_ERROR;
+    }
+    area->sector = spare;
+    area->seq = h[1];
+    area->slot = 2;
+    area->spare_dirty = 0;
+    // 擦除在后台进行，记录已经完整；下一次访问FLASH前等待忙结束
+    return Flash_SectorErase (ry_record_sector (area, spare ^ 1));
+}
+
+/**
+ * @brief  追加一条记录，返回前等待编程完成
+ * @param  rec，最后4Byte由这里填写校验
+ */
+HAL_StatusTypeDef ry_record_append (ry_record_area *area, void *rec) {
+    uint32_t *w = rec;
+    uint16_t words = area->size / 4;
+
+    if (!area->loaded) {
+        uint32_t tmp[RY_RECORD_MAX / 4];
+
+        ry_record_load (area, tmp);
+    }
+    w[words - 1] = ry_record_check (w, words);
+
+    if (area->slot >= FLASH_SECTOR_SIZE / area->size) {
+        return ry_record_switch (area, rec);
+    }
+    if (Flash_PageProgram (ry_record_sector (area, area->sector) + area->slot * area->size, (uint8_t *)rec,
+                           area->size) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    area->slot++;
+    return Flash_WaitBusy();
+}
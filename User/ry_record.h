@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_RECORD_H
+#define RY_RECORD_H
+
+#include "bsp_spi_flash.h"
+
+//--------------------------记录扇区------------------------------------
+// W25Q64中两个交替使用的4K扇区保存一种定长记录，用于掉电后仍需保留的少量状态：
+// 1.每次更新在当前扇区追加一条记录，一次页编程写入，不擦除扇区
+// 2.第一次使用时扫描扇区，最后一条校验正确的记录有效，
+//   写入中途掉电的记录校验错误，自动回退到上一条
+// 3.当前扇区写满后先把记录写入已擦除的另一个扇区，再写该扇区的头{magic, seq, ~seq}，
+//   之后才擦除旧扇区：任何时刻掉电都至少有一个扇区保存着最后一条记录
+// 4.头有效的扇区中seq较新的为当前扇区；另一个扇区不是空白时（切换或擦除中途掉电）
+//   在下一次切换前擦除
+// 扇区的第一个记录位置保存头；记录长度为4的倍数、不小于12且能整除页大小，
+// 最后4Byte为校验，由ry_record_append()填写
+//--------------------------------------------------------------------
+#define RY_RECORD_AREA_SIZE (2 * FLASH_SECTOR_SIZE)
+
+typedef struct {
+    uint32_t addr;      // 第一个扇区地址，占用RY_RECORD_AREA_SIZE
+    uint16_t size;      // 记录长度
+    uint16_t slot;      // 当前扇区中下一条记录的位置
+    uint8_t loaded;
+    uint8_t sector;     // 当前扇区0/1
+    uint8_t spare_dirty;// 1:另一个扇区不是空白，使用前需要擦除
+    uint32_t seq;       // 当前扇区的序号
+} ry_record_area;
+
+uint8_t ry_record_load(ry_record_area *area, void *rec);
+HAL_StatusTypeDef ry_record_append(ry_record_area *area, void *rec);
+
+#endif /* RY_RECORD_H */
@@ -0,0 +1,180 @@
+#include "user_fatfs.h"
+#include "diskio.h"
+#include "ry_crc.h"
+#include <string.h>
+
+FATFS fs;
+FIL fnew;
+
+static const TCHAR *fnew_path;  // fnew当前打开的文件，NULL表示未打开
+
+/**
+ * @brief  挂载SPI FLASH上的FAT卷，没有文件系统时先格式化
+ */
+void fatfs_file_init (void) {
+    FRESULT res;
+
+    res = f_mount (&fs, "0:", 1);
+    if (res == FR_NO_FILESYSTEM) {
+        /* 卷未挂载，借用fs.win作为格式化工作缓冲 */
+        res = f_mkfs ("0:", 0, fs.win, sizeof (fs.win));
+        if (res == FR_OK) {
+            res = f_mount (&fs, "0:", 1);
+        }
+    }
+    printf ("f_mount:%d\r\n", res);
+}
+
+/**
+ * @brief  按包接收文件：第一包创建文件，最后一包写完后关闭
+ * @param  path，文件名，如"0:setup.ry"
+ * @param  size，文件最终长度，0：未知；已知时创建文件后按此预分配
+ * @param  last，1：最后一包
+ */
+FRESULT fatfs_file_receive (const TCHAR *path, FSIZE_t size, const uint8_t *data, UINT len, uint8_t last) {
+    FRESULT res = FR_OK;
+    UINT bw;
+
+    if (fnew_path != path) {
+        if (fnew_path) {
+            f_close (&fnew);
+        }
+        fnew_path = NULL;
+        res = f_open (&fnew, path, FA_CREATE_ALWAYS | FA_WRITE);
+        if (res != FR_OK) {
+            return res;
+        }
+        fnew_path = path;
+        res = fatfs_file_preallocate (&fnew, size);
+        if (res == FR_DENIED) {
+            res = FR_OK;  // 没有连续空间，按包逐簇分配
+        }
+    }
+    if (len && (res == FR_OK)) {
+        res = f_write (&fnew, data, len, &bw);
+        if ((res == FR_OK) && (bw != len)) {
+            res = FR_DENIED;  // 卷已满
+        }
+    }
+    if (last && (res == FR_OK) && (f_tell (&fnew) < f_size (&fnew))) {
+        res = f_truncate (&fnew);  // 实际长度小于预分配长度
+    }
+    if (last || (res != FR_OK)) {
+        if ((f_close (&fnew) != FR_OK) && (res == FR_OK)) {
+            res = FR_DISK_ERR;
+        }
+        fnew_path = NULL;
+    }
+    return res;
+}
+
+/**
+ * @brief  打开已接收的文件，截断到ofs处继续接收，文件不存在时新建
+ * @retval FR_INVALID_PARAMETER：文件比ofs短
+ */
+FRESULT fatfs_file_resume (const TCHAR *path, FSIZE_t ofs) {
+    FRESULT res;
+
+    fatfs_file_abort();
+    res = f_open (&fnew, path, FA_OPEN_ALWAYS | FA_WRITE);
+    if (res != FR_OK) {
+        return res;
+    }
+    if (f_size (&fnew) < ofs) {
+        res = FR_INVALID_PARAMETER;
+    }
+    if (res == FR_OK) {
+        res = f_lseek (&fnew, ofs);
+    }
+    if (res == FR_OK) {
+        res = f_truncate (&fnew);
+    }
+    if (res != FR_OK) {
+        f_close (&fnew);
+        return res;
+    }
+    fnew_path = path;
+    return FR_OK;
+}
+
+/**
+ * @brief  已接收的数据写入FLASH，之后的掉电不影响这些数据
+ */
+FRESULT fatfs_file_sync (void) {
+    return fnew_path ? f_sync (&fnew) : FR_OK;
+}
+
+/**
+ * @brief  计算文件内容的CRC32（见ry_crc.h），从FLASH读回，校验实际写入的数据
+ * @note   读取下一段的同时，上一段由DMA送入CRC单元
+ */
+FRESULT fatfs_file_crc (const TCHAR *path, uint32_t *crc) {
+    static __attribute__((aligned(4))) uint8_t buf[2][512];
+    FRESULT res;
+    UINT br;
+    uint8_t i = 0;
+
+    fatfs_file_abort();
+    res = f_open (&fnew, path, FA_READ);
+    if (res != FR_OK) {
+        return res;
+    }
+    ry_crc_reset();
+    do {
+        res = f_read (&fnew, buf[i], sizeof (buf[0]), &br);
+        ry_crc_wait();  // 上一段
+        if (res != FR_OK) {
+            break;
+        }
+        if (br & 3) {
+            memset (&buf[i][br], 0xFF, 4 - (br & 3));
+        }
+        ry_crc_start ((const uint32_t *)buf[i], (br + 3) / 4);
+        i ^= 1;
+    } while (br == sizeof (buf[0]));
+    ry_crc_wait();
+    f_close (&fnew);
+    *crc = ry_crc_value();
+    return res;
+}
+
+/**
+ * @brief  关闭未接收完的文件，下一包重新创建
+ */
+void fatfs_file_abort (void) {
+    if (fnew_path) {
+        f_close (&fnew);
+        fnew_path = NULL;
+    }
+}
+
+/**
+ * @brief  为新建文件分配连续簇并按大块预擦除，之后的写入不再逐扇区擦除
+ * @note   文件须为刚创建的空文件；分配后文件长度即为size，实际写入较短时需f_truncate
+ * @param  fp，已用FA_WRITE打开的文件
+ * @param  size，预分配长度
+ * @retval FR_DENIED：没有足够的连续空间
+ */
+FRESULT fatfs_file_preallocate (FIL *fp, FSIZE_t size) {
+    FATFS *fs = fp->obj.fs;
+    FRESULT res;
+    DWORD clusters;
+    LBA_t lba[2];
+
+    if (size == 0) {
+        return FR_OK;
+    }
+
+    res = f_expand (fp, size, 1);
+    if (res != FR_OK) {
+        return res;
+    }
+
+    clusters = (size + (FSIZE_t)fs->csize * FF_MAX_SS - 1) / ((FSIZE_t)fs->csize * FF_MAX_SS);
+    lba[0] = fs->database + (LBA_t)fs->csize * (fp->obj.sclust - 2);
+    lba[1] = lba[0] + (LBA_t)clusters * fs->csize - 1;
+    if (disk_ioctl (fs->pdrv, CTRL_ERASE_RANGE, lba) != RES_OK) {
+        return FR_DISK_ERR;
+    }
+    return FR_OK;
+}
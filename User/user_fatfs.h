@@ -10,4 +10,10 @@ extern FIL fnew;
 void fatfs_file_init (void);
 void FatReadDirTest (uint8_t flag,char* FilePath);
 uint8_t load_setup(void);
+FRESULT fatfs_file_preallocate (FIL *fp, FSIZE_t size);
+FRESULT fatfs_file_receive (const TCHAR *path, FSIZE_t size, const uint8_t *data, UINT len, uint8_t last);
+void fatfs_file_abort (void);
+FRESULT fatfs_file_resume (const TCHAR *path, FSIZE_t ofs);
+FRESULT fatfs_file_sync (void);
+FRESULT fatfs_file_crc (const TCHAR *path, uint32_t *crc);
 #endif /* __USER_FATFS_H */
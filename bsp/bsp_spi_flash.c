@@ -1,10 +1,18 @@
 #include "bsp_spi_flash.h"
+#include "ry_prof.h"
 #include <string.h>
 
 /* 私有宏 */
 #define FLASH_CS_LOW() GPIO_WriteBit (SPI_FLASH_CS_PORT, SPI_FLASH_CS_PIN, 0);
 #define FLASH_CS_HIGH() GPIO_WriteBit (SPI_FLASH_CS_PORT, SPI_FLASH_CS_PIN, 1);
 
+static void SPI_FLASH_DMA_Init (void);
+static void Flash_SFDP_Probe (void);
+
+/* 默认使用0x03读命令，Flash_Init()中根据SFDP结果切换 */
+Flash_InfoTypeDef Flash_Info = {0, W25X_ReadData, 0, 1, 0};
+Flash_StatsTypeDef Flash_Stats;
+
 /*********************** 驱动实现 ************************/
 
 void Flash_Init (void) {
@@ -46,6 +54,88 @@ void Flash_Init (void) {
     SPI_Init (SPI_FLASH_SPI, &SPI_InitStructure);
 
     SPI_Cmd (SPI_FLASH_SPI, ENABLE);
+
+    SPI_FLASH_DMA_Init();
+    Flash_SFDP_Probe();
+}
+
+/**
+ * @brief  读取SFDP参数区
+ * @param  addr，SFDP区内地址
+ */
+HAL_StatusTypeDef Flash_ReadSFDP (uint32_t addr, uint8_t *pData, uint16_t Size) {
+    FLASH_CS_LOW();
+    SPI_FLASH_ReadWriteByte (W25X_ReadSFDP);
+    SPI_FLASH_ReadWriteByte ((u8)((addr) >> 16));
+    SPI_FLASH_ReadWriteByte ((u8)((addr) >> 8));
+    SPI_FLASH_ReadWriteByte ((u8)addr);
+    SPI_FLASH_ReadWriteByte (0xFF);
+    SPI_FLASH_Transfer (NULL, pData, Size);
+    FLASH_CS_HIGH();
+    return HAL_OK;
+}
+
+/**
+ * @brief  解析SFDP基本参数表（BFPT），选择读命令
+ * @note   板上SPI3只连接了DO/DI，硬件SPI不支持双线/四线数据相位，
+ *         0x3B/0x6B能力只记录在Flash_Info.max_lines中，实际使用0x0B快速读。
+ *         支持SFDP的芯片均支持0x0B，此时SPI时钟提高到PCLK1/2。
+ *         读不到SFDP签名（老型号）时保持0x03和原时钟。
+ */
+static void Flash_SFDP_Probe (void) {
+    uint8_t hdr[8];
+    uint8_t phdr[8];
+    uint32_t bfpt[SFDP_BFPT_MAX_DWORDS] = {0};
+    uint32_t ptr, dwords, density;
+    uint8_t i, nph;
+
+    Flash_ReadSFDP (0, hdr, sizeof (hdr));
+    if (((uint32_t)hdr[0] | ((uint32_t)hdr[1] << 8) | ((uint32_t)hdr[2] << 16) | ((uint32_t)hdr[3] << 24)) != SFDP_SIGNATURE) {
+        return;
+    }
+
+    /* 查找JEDEC基本参数表，hdr[6]为参数头个数减1 */
+    nph = hdr[6] + 1;
+    dwords = 0;
+    ptr = 0;
+    for (i = 0; i < nph; i++) {
+        Flash_ReadSFDP (8 + 8 * i, phdr, sizeof (phdr));
+        if ((phdr[0] == SFDP_BFPT_ID_LSB) && (phdr[7] == SFDP_BFPT_ID_MSB)) {
+            dwords = phdr[3];
+            ptr = (uint32_t)phdr[4] | ((uint32_t)phdr[5] << 8) | ((uint32_t)phdr[6] << 16);
+            break;
+        }
+    }
+    if (dwords < 2) {
+        return;
+    }
+    if (dwords > SFDP_BFPT_MAX_DWORDS) {
+        dwords = SFDP_BFPT_MAX_DWORDS;
+    }
+    Flash_ReadSFDP (ptr, (uint8_t *)bfpt, dwords * 4);  // RISC-V小端，可直接按DWORD访问
+
+    /* DWORD1：bit16 1-1-2，bit20 1-2-2，bit21 1-4-4，bit22 1-1-4 */
+    if (bfpt[0] & ((1 << 21) | (1 << 22))) {
+        Flash_Info.max_lines = 4;
+    } else if (bfpt[0] & ((1 << 16) | (1 << 20))) {
+        Flash_Info.max_lines = 2;
+    }
+
+    /* DWORD2：bit31为0时为(位数-1)，否则为2^N位 */
+    density = bfpt[1];
+    if (density & 0x80000000) {
+        Flash_Info.capacity = ((density & 0x7FFFFFFF) >= 35) ? 0 : (1UL << ((density & 0x7FFFFFFF) - 3));
+    } else {
+        Flash_Info.capacity = (density >> 3) + 1;
+    }
+
+    Flash_Info.sfdp_valid = 1;
+    Flash_Info.read_cmd = W25X_FastReadData;
+    Flash_Info.read_dummy = 1;
+
+    SPI_Cmd (SPI_FLASH_SPI, DISABLE);
+    SPI_FLASH_SPI->CTLR1 = (SPI_FLASH_SPI->CTLR1 & ~SPI_BaudRatePrescaler_256) | SPI_BaudRatePrescaler_2;
+    SPI_Cmd (SPI_FLASH_SPI, ENABLE);
 }
 
 void Flash_WriteEnable (void) {
@@ -69,36 +159,69 @@ uint8_t Flash_ReadStatusReg (void) {
     return status;
 }
 
+/**
+ * @brief  等待上一次编程/擦除完成
+ * @note   编程和擦除命令发出后立即返回，由下一次操作（或CTRL_SYNC）在开始前调用本函数，
+ *         芯片内部编程/擦除期间CPU可以继续处理USB和FatFs
+ */
 HAL_StatusTypeDef Flash_WaitBusy (void) {
+    RY_PROF_BEGIN (RY_PROF_FLASH_WAIT);
+
+    SPI_FLASH_DMA_Wait();
     while ((Flash_ReadStatusReg() & 0x01) == 0x01)
         ;
+    RY_PROF_END (RY_PROF_FLASH_WAIT);
     return HAL_OK;
 }
 
-HAL_StatusTypeDef Flash_ReadData (uint32_t addr, uint8_t *pData, uint16_t Size) {
-    u16 i;
+/**
+ * @brief  启动DMA读数据，立即返回，传输完成后由DMA中断拉高片选
+ * @note   调用者需通过SPI_FLASH_DMA_Busy()/SPI_FLASH_DMA_Wait()确认完成后再使用pData
+ */
+HAL_StatusTypeDef Flash_ReadData_DMA (uint32_t addr, uint8_t *pData, uint32_t Size) {
+    uint8_t i;
+
+    if (SPI_FLASH_DMA_Busy()) {
+        return HAL_BUSY;
+    }
+    Flash_WaitBusy();
+    Flash_Stats.read_bytes += Size;
 
     FLASH_CS_LOW();
 
-    SPI_FLASH_ReadWriteByte (W25X_ReadData);
+    SPI_FLASH_ReadWriteByte (Flash_Info.read_cmd);
     SPI_FLASH_ReadWriteByte ((u8)((addr) >> 16));
     SPI_FLASH_ReadWriteByte ((u8)((addr) >> 8));
     SPI_FLASH_ReadWriteByte ((u8)addr);
+    for (i = 0; i < Flash_Info.read_dummy; i++) {
+        SPI_FLASH_ReadWriteByte (0xFF);
+    }
 
-    for (i = 0; i < Size; i++) {
-        pData[i] = SPI_FLASH_ReadWriteByte (0XFF);
+    if (Size < SPI_FLASH_DMA_MIN_SIZE) {
+        SPI_FLASH_Transfer (NULL, pData, Size);
+        FLASH_CS_HIGH();
+        return HAL_OK;
     }
-    FLASH_CS_HIGH();
-    return HAL_OK;
+    return SPI_FLASH_DMA_Start (NULL, pData, Size);
+}
+
+HAL_StatusTypeDef Flash_ReadData (uint32_t addr, uint8_t *pData, uint32_t Size) {
+    HAL_StatusTypeDef status;
+
+    status = Flash_ReadData_DMA (addr, pData, Size);
+    if (status != HAL_OK) {
+        return status;
+    }
+    return SPI_FLASH_DMA_Wait();
 }
-#define SPI_FLASH_PageSize 256
 HAL_StatusTypeDef Flash_PageProgram (uint32_t addr, uint8_t *pData, uint16_t Size) {
-    u16 i;
     /* 检查页边界 */
     if ((Size == 0) || (Size > SPI_FLASH_PageSize) || ((addr % SPI_FLASH_PageSize) + Size > SPI_FLASH_PageSize)) {
         return HAL_ERROR;
     }
 
+    Flash_WaitBusy();
+    Flash_Stats.program_bytes += Size;
     Flash_WriteEnable();
     FLASH_CS_LOW();
     SPI_FLASH_ReadWriteByte (W25X_PageProgram);
@@ -106,26 +229,95 @@ HAL_StatusTypeDef Flash_PageProgram (uint32_t addr, uint8_t *pData, uint16_t Siz
     SPI_FLASH_ReadWriteByte ((u8)((addr) >> 8));
     SPI_FLASH_ReadWriteByte ((u8)addr);
 
-    for (i = 0; i < Size; i++) {
-        SPI_FLASH_ReadWriteByte (pData[i]);
+    if (Size < SPI_FLASH_DMA_MIN_SIZE) {
+        SPI_FLASH_Transfer (pData, NULL, Size);
+        FLASH_CS_HIGH();
+    } else if ((SPI_FLASH_DMA_Start (pData, NULL, Size) != HAL_OK) || (SPI_FLASH_DMA_Wait() != HAL_OK)) {
+        FLASH_CS_HIGH();
+        return HAL_ERROR;
     }
-    FLASH_CS_HIGH();
 
-    return Flash_WaitBusy();
+    return HAL_OK;
 }
 
-HAL_StatusTypeDef Flash_SectorErase (uint32_t addr) {
+static HAL_StatusTypeDef Flash_EraseCmd (uint8_t cmd, uint32_t addr) {
 
-    Flash_WriteEnable();
     Flash_WaitBusy();
+    Flash_Stats.erase_cmds++;
+    Flash_WriteEnable();
     FLASH_CS_LOW();
-    SPI_FLASH_ReadWriteByte (W25X_SectorErase);
+    SPI_FLASH_ReadWriteByte (cmd);
     SPI_FLASH_ReadWriteByte ((u8)((addr) >> 16));
     SPI_FLASH_ReadWriteByte ((u8)((addr) >> 8));
     SPI_FLASH_ReadWriteByte ((u8)addr);
     FLASH_CS_HIGH();
 
-    return Flash_WaitBusy();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef Flash_SectorErase (uint32_t addr) {
+    HAL_StatusTypeDef status;
+    RY_PROF_BEGIN (RY_PROF_FLASH_ERASE);
+
+    status = Flash_EraseCmd (W25X_SectorErase, addr);
+    RY_PROF_END (RY_PROF_FLASH_ERASE);
+    return status;
+}
+
+HAL_StatusTypeDef Flash_BlockErase32K (uint32_t addr) {
+    return Flash_EraseCmd (W25X_BlockErase32K, addr);
+}
+
+HAL_StatusTypeDef Flash_BlockErase64K (uint32_t addr) {
+    return Flash_EraseCmd (W25X_BlockErase64K, addr);
+}
+
+HAL_StatusTypeDef Flash_ChipErase (void) {
+    Flash_WaitBusy();
+    Flash_Stats.erase_cmds++;
+    Flash_WriteEnable();
+    FLASH_CS_LOW();
+    SPI_FLASH_ReadWriteByte (W25X_ChipErase);
+    FLASH_CS_HIGH();
+
+    return HAL_OK;
+}
+
+/**
+ * @brief  擦除一段地址区间，自动选择擦除命令组合
+ * @note   4K约45ms，32K约120ms，64K约150ms，因此按对齐情况优先使用大块擦除；
+ *         区间覆盖整片（容量由SFDP获得）时使用整片擦除
+ * @param  addr，起始地址，须4K对齐
+ * @param  len，长度，须为4K整数倍
+ * @retval HAL_ERROR：地址或长度未对齐
+ */
+HAL_StatusTypeDef Flash_EraseRange (uint32_t addr, uint32_t len) {
+    HAL_StatusTypeDef status = HAL_OK;
+
+    if ((addr % FLASH_SECTOR_SIZE) || (len % FLASH_SECTOR_SIZE)) {
+        return HAL_ERROR;
+    }
+
+    if ((addr == 0) && Flash_Info.capacity && (len >= Flash_Info.capacity)) {
+        return Flash_ChipErase();
+    }
+
+    while (len && (status == HAL_OK)) {
+        if (((addr % FLASH_BLOCK64_SIZE) == 0) && (len >= FLASH_BLOCK64_SIZE)) {
+            status = Flash_BlockErase64K (addr);
+            addr += FLASH_BLOCK64_SIZE;
+            len -= FLASH_BLOCK64_SIZE;
+        } else if (((addr % FLASH_BLOCK32_SIZE) == 0) && (len >= FLASH_BLOCK32_SIZE)) {
+            status = Flash_BlockErase32K (addr);
+            addr += FLASH_BLOCK32_SIZE;
+            len -= FLASH_BLOCK32_SIZE;
+        } else {
+            status = Flash_SectorErase (addr);
+            addr += FLASH_SECTOR_SIZE;
+            len -= FLASH_SECTOR_SIZE;
+        }
+    }
+    return status;
 }
 
 u16 Flash_ReadID (void) {
@@ -165,78 +357,19 @@ u16 Flash_ReadJedecID (void) {
  */
 
 
-void FLASH_WriteData (uint32_t addr, uint8_t *pData, uint16_t Size) {
-    uint8_t NumOfPage = 0, NumOfSingle = 0, Addr = 0, count = 0, temp = 0;
-
-    /*mod运算求余，若writeAddr是SPI_FLASH_PageSize整数倍，运算结果Addr值为0*/
-    Addr = addr % SPI_FLASH_PageSize;
-
-    /*差count个数据值，刚好可以对齐到页地址*/
-    count = SPI_FLASH_PageSize - Addr;
-    /*计算出要写多少整数页*/
-    NumOfPage = Size / SPI_FLASH_PageSize;
-    /*mod运算求余，计算出剩余不满一页的字节数*/
-    NumOfSingle = Size % SPI_FLASH_PageSize;
-
-    /* Addr=0,则WriteAddr 刚好按页对齐 aligned  */
-    if (Addr == 0) {
-        /* Size < SPI_FLASH_PageSize */
-        if (NumOfPage == 0) {
-            Flash_PageProgram (addr, pData, Size);
-        } else /* Size > SPI_FLASH_PageSize */
-        {
-            /*先把整数页都写了*/
-            while (NumOfPage--) {
-                Flash_PageProgram (addr, pData, SPI_FLASH_PageSize);
-                addr += SPI_FLASH_PageSize;
-                pData += SPI_FLASH_PageSize;
-            }
-            /*若有多余的不满一页的数据，把它写完*/
-            Flash_PageProgram (addr, pData, NumOfSingle);
-        }
-    }
-    /* 若地址与 SPI_FLASH_PageSize 不对齐  */
-    else {
-        /* Size < SPI_FLASH_PageSize */
-        if (NumOfPage == 0) {
-            /*当前页剩余的count个位置比NumOfSingle小，一页写不完*/
-            if (NumOfSingle > count) {
-                temp = NumOfSingle - count;
-                /*先写满当前页*/
-                Flash_PageProgram (addr, pData, count);
-
-                addr += count;
-                pData += count;
-                /*再写剩余的数据*/
-                Flash_PageProgram (addr, pData, temp);
-            } else /*当前页剩余的count个位置能写完NumOfSingle个数据*/
-            {
-                Flash_PageProgram (addr, pData, Size);
-            }
-        } else /* NumByteToWrite > SPI_FLASH_PageSize */
-        {
-            /*地址不对齐多出的count分开处理，不加入这个运算*/
-            Size -= count;
-            NumOfPage = Size / SPI_FLASH_PageSize;
-            NumOfSingle = Size % SPI_FLASH_PageSize;
-
-            /* 先写完count个数据，为的是让下一次要写的地址对齐 */
-            Flash_PageProgram (addr, pData, count);
-
-            /* 接下来就重复地址对齐的情况 */
-            addr += count;
-            pData += count;
-            /*把整数页都写了*/
-            while (NumOfPage--) {
-                Flash_PageProgram (addr, pData, SPI_FLASH_PageSize);
-                addr += SPI_FLASH_PageSize;
-                pData += SPI_FLASH_PageSize;
-            }
-            /*若有多余的不满一页的数据，把它写完*/
-            if (NumOfSingle != 0) {
-                Flash_PageProgram (addr, pData, NumOfSingle);
-            }
+void FLASH_WriteData (uint32_t addr, uint8_t *pData, uint32_t Size) {
+    uint32_t count;
+
+    while (Size) {
+        /*先写到页边界，之后每次写整页，最后写剩余不满一页的数据*/
+        count = SPI_FLASH_PageSize - (addr % SPI_FLASH_PageSize);
+        if (count > Size) {
+            count = Size;
         }
+        Flash_PageProgram (addr, pData, count);
+        addr += count;
+        pData += count;
+        Size -= count;
     }
 }
 
@@ -251,4 +384,178 @@ u8 SPI_FLASH_ReadWriteByte (u8 TxData) {
         ;
 
     return SPI_I2S_ReceiveData (SPI_FLASH_SPI);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief  轮询方式全双工收发，pTx为NULL时发送0xFF，pRx为NULL时丢弃接收数据
+ */
+void SPI_FLASH_Transfer (const uint8_t *pTx, uint8_t *pRx, uint32_t Size) {
+    uint32_t i;
+    u8 rx;
+
+    for (i = 0; i < Size; i++) {
+        rx = SPI_FLASH_ReadWriteByte (pTx ? pTx[i] : 0xFF);
+        if (pRx) {
+            pRx[i] = rx;
+        }
+    }
+}
+
+/*********************** SPI DMA传输 ************************/
+/* 一次传输拆分为若干不超过SPI_FLASH_DMA_MAX_CHUNK的分段，
+ * 分段续传和结束处理（关闭DMA请求、拉高片选）都在RX完成中断中完成，
+ * 传输期间CPU不参与数据搬运，可以继续响应USB中断。
+ */
+typedef struct {
+    const uint8_t *tx;
+    uint8_t *rx;
+    uint32_t remain;
+    uint16_t chunk;
+    volatile uint8_t busy;
+} SPI_FLASH_DMA_State;
+
+static SPI_FLASH_DMA_State spi_dma;
+static const uint8_t spi_dma_dummy_tx = 0xFF;
+static uint8_t spi_dma_dummy_rx;
+
+void SPI_FLASH_DMA_RX_IRQHandler (void) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+static void SPI_FLASH_DMA_Init (void) {
+    DMA_InitTypeDef DMA_InitStructure = {0};
+    NVIC_InitTypeDef NVIC_InitStructure = {0};
+
+    RCC_AHBPeriphClockCmd (RCC_SPI_FLASH_DMA, ENABLE);
+
+    DMA_DeInit (SPI_FLASH_DMA_RX_CH);
+    DMA_DeInit (SPI_FLASH_DMA_TX_CH);
+
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&SPI_FLASH_SPI->DATAR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)&spi_dma_dummy_rx;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = 1;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init (SPI_FLASH_DMA_RX_CH, &DMA_InitStructure);
+
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)&spi_dma_dummy_tx;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_Init (SPI_FLASH_DMA_TX_CH, &DMA_InitStructure);
+
+    DMA_ITConfig (SPI_FLASH_DMA_RX_CH, DMA_IT_TC, ENABLE);
+
+    NVIC_InitStructure.NVIC_IRQChannel = SPI_FLASH_DMA_RX_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init (&NVIC_InitStructure);
+
+    spi_dma.busy = 0;
+}
+
+/* 装载下一分段，先使能RX通道再使能TX通道，保证第一个接收字节不丢失 */
+static void SPI_FLASH_DMA_Kick (void) {
+    uint16_t n = (spi_dma.remain > SPI_FLASH_DMA_MAX_CHUNK) ? SPI_FLASH_DMA_MAX_CHUNK : (uint16_t)spi_dma.remain;
+
+    SPI_FLASH_DMA_RX_CH->CFGR &= ~DMA_CFGR1_EN;
+    SPI_FLASH_DMA_TX_CH->CFGR &= ~DMA_CFGR1_EN;
+
+    if (spi_dma.rx) {
+        SPI_FLASH_DMA_RX_CH->MADDR = (uint32_t)spi_dma.rx;
+        SPI_FLASH_DMA_RX_CH->CFGR |= DMA_MemoryInc_Enable;
+    } else {
+        SPI_FLASH_DMA_RX_CH->MADDR = (uint32_t)&spi_dma_dummy_rx;
+        SPI_FLASH_DMA_RX_CH->CFGR &= ~DMA_MemoryInc_Enable;
+    }
+    if (spi_dma.tx) {
+        SPI_FLASH_DMA_TX_CH->MADDR = (uint32_t)spi_dma.tx;
+        SPI_FLASH_DMA_TX_CH->CFGR |= DMA_MemoryInc_Enable;
+    } else {
+        SPI_FLASH_DMA_TX_CH->MADDR = (uint32_t)&spi_dma_dummy_tx;
+        SPI_FLASH_DMA_TX_CH->CFGR &= ~DMA_MemoryInc_Enable;
+    }
+
+    SPI_FLASH_DMA_RX_CH->CNTR = n;
+    SPI_FLASH_DMA_TX_CH->CNTR = n;
+    spi_dma.chunk = n;
+
+    SPI_FLASH_DMA_RX_CH->CFGR |= DMA_CFGR1_EN;
+    SPI_FLASH_DMA_TX_CH->CFGR |= DMA_CFGR1_EN;
+}
+
+/**
+ * @brief  启动DMA传输，片选须已由调用者拉低，传输结束后在中断中拉高
+ * @param  pTx，发送缓冲，NULL表示发送0xFF
+ * @param  pRx，接收缓冲，NULL表示丢弃接收数据
+ * @param  Size，传输长度，可超过64KB
+ * @retval HAL_BUSY：上一次传输未完成
+ */
+HAL_StatusTypeDef SPI_FLASH_DMA_Start (const uint8_t *pTx, uint8_t *pRx, uint32_t Size) {
+    if (spi_dma.busy) {
+        return HAL_BUSY;
+    }
+    if (Size == 0) {
+        FLASH_CS_HIGH();
+        return HAL_OK;
+    }
+
+    /* 清除轮询阶段可能残留的接收数据 */
+    while (SPI_I2S_GetFlagStatus (SPI_FLASH_SPI, SPI_I2S_FLAG_TXE) == RESET)
+        ;
+    (void)SPI_I2S_ReceiveData (SPI_FLASH_SPI);
+
+    spi_dma.tx = pTx;
+    spi_dma.rx = pRx;
+    spi_dma.remain = Size;
+    spi_dma.busy = 1;
+
+    SPI_FLASH_DMA_Kick();
+    SPI_I2S_DMACmd (SPI_FLASH_SPI, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+
+    return HAL_OK;
+}
+
+uint8_t SPI_FLASH_DMA_Busy (void) {
+    return spi_dma.busy;
+}
+
+/* 等待期间WFI休眠，关中断后检查busy，完成中断不会在检查和WFI之间丢失 */
+HAL_StatusTypeDef SPI_FLASH_DMA_Wait (void) {
+    __disable_irq();
+    while (spi_dma.busy) {
+        __WFI();
+        __enable_irq();
+        __disable_irq();
+    }
+    __enable_irq();
+    return HAL_OK;
+}
+
+void SPI_FLASH_DMA_RX_IRQHandler (void) {
+    if (DMA_GetITStatus (SPI_FLASH_DMA_RX_IT_TC) != RESET) {
+        DMA_ClearITPendingBit (SPI_FLASH_DMA_RX_IT_TC);
+
+        spi_dma.remain -= spi_dma.chunk;
+        if (spi_dma.tx) {
+            spi_dma.tx += spi_dma.chunk;
+        }
+        if (spi_dma.rx) {
+            spi_dma.rx += spi_dma.chunk;
+        }
+
+        if (spi_dma.remain) {
+            SPI_FLASH_DMA_Kick();
+        } else {
+            SPI_I2S_DMACmd (SPI_FLASH_SPI, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+            SPI_FLASH_DMA_RX_CH->CFGR &= ~DMA_CFGR1_EN;
+            SPI_FLASH_DMA_TX_CH->CFGR &= ~DMA_CFGR1_EN;
+            FLASH_CS_HIGH();
+            spi_dma.busy = 0;
+        }
+    }
+}
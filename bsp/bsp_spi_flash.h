@@ -23,18 +23,68 @@ extern "C" {
 #define SPI_FLASH_CS_PIN GPIO_Pin_6
 #define SPI_FLASH_CS_PORT GPIOE
 
+/* SPI3 DMA通道：RX->DMA2_CH1，TX->DMA2_CH2，RX传输完成中断作为整次传输的完成通知 */
+#define RCC_SPI_FLASH_DMA RCC_AHBPeriph_DMA2
+#define SPI_FLASH_DMA_RX_CH DMA2_Channel1
+#define SPI_FLASH_DMA_TX_CH DMA2_Channel2
+#define SPI_FLASH_DMA_RX_IT_TC DMA2_IT_TC1
+#define SPI_FLASH_DMA_RX_IRQn DMA2_Channel1_IRQn
+#define SPI_FLASH_DMA_RX_IRQHandler DMA2_Channel1_IRQHandler
+
+#define SPI_FLASH_DMA_MIN_SIZE 16      // 小于该长度直接轮询，DMA配置开销更大
+#define SPI_FLASH_DMA_MAX_CHUNK 65535  // DMA计数寄存器为16位，超出部分在中断中分段续传
+
 /* W25Q64指令集 */
 #define W25X_WriteEnable        0x06
 #define W25X_WriteDisable       0x04
 #define W25X_ReadStatusReg1     0x05
 #define W25X_PageProgram        0x02
 #define W25X_ReadData           0x03
+#define W25X_FastReadData       0x0B
+#define W25X_FastReadDual       0x3B
+#define W25X_FastReadQuad       0x6B
+#define W25X_ReadSFDP           0x5A
 #define W25X_SectorErase        0x20
+#define W25X_BlockErase32K      0x52
+#define W25X_BlockErase64K      0xD8
+#define W25X_ChipErase          0xC7
 #define W25X_ManufactDeviceID   0x90
 #define W25X_JedecID            0x9F
 
+#define SPI_FLASH_PageSize 256
 #define FLASH_SECTOR_SIZE 4096
 #define FLASH_SECTOR_COUNT 512
+#define FLASH_BLOCK32_SIZE 0x8000
+#define FLASH_BLOCK64_SIZE 0x10000
+
+/* SFDP（JESD216）相关定义 */
+#define SFDP_SIGNATURE          0x50444653  // "SFDP"
+#define SFDP_BFPT_ID_LSB        0x00        // JEDEC Basic Flash Parameter Table
+#define SFDP_BFPT_ID_MSB        0xFF
+#define SFDP_BFPT_MAX_DWORDS    16
+
+/* Flash_Init()时根据SFDP选定的读模式 */
+typedef struct
+{
+  uint8_t  sfdp_valid;   // 1：SFDP解析成功
+  uint8_t  read_cmd;     // 当前使用的读命令
+  uint8_t  read_dummy;   // 地址后空字节数
+  uint8_t  max_lines;    // 芯片支持的最大输出线宽1/2/4，仅作记录
+  uint32_t capacity;     // 容量（字节），SFDP无效时为0
+} Flash_InfoTypeDef;
+
+extern Flash_InfoTypeDef Flash_Info;
+
+/* SPI FLASH访问统计，升级结束时输出 */
+typedef struct
+{
+  uint32_t read_bytes;     // 读数据字节数
+  uint32_t program_bytes;  // 页编程字节数
+  uint32_t erase_cmds;     // 擦除命令次数（扇区/块/整片）
+} Flash_StatsTypeDef;
+
+extern Flash_StatsTypeDef Flash_Stats;
+
 typedef enum
 {
   HAL_OK       = 0x00U,
@@ -52,13 +102,23 @@ void Flash_WriteEnable(void);
 void Flash_WriteDisable(void);
 uint8_t Flash_ReadStatusReg(void);
 HAL_StatusTypeDef Flash_WaitBusy(void);
-HAL_StatusTypeDef Flash_ReadData(uint32_t addr, uint8_t *pData, uint16_t Size);
-void FLASH_WriteData(uint32_t addr,uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef Flash_ReadData(uint32_t addr, uint8_t *pData, uint32_t Size);
+HAL_StatusTypeDef Flash_ReadData_DMA(uint32_t addr, uint8_t *pData, uint32_t Size);
+void FLASH_WriteData(uint32_t addr,uint8_t *pData, uint32_t Size);
 HAL_StatusTypeDef Flash_PageProgram(uint32_t addr, uint8_t *pData, uint16_t Size);
 HAL_StatusTypeDef Flash_SectorErase(uint32_t addr);
+HAL_StatusTypeDef Flash_BlockErase32K(uint32_t addr);
+HAL_StatusTypeDef Flash_BlockErase64K(uint32_t addr);
+HAL_StatusTypeDef Flash_ChipErase(void);
+HAL_StatusTypeDef Flash_EraseRange(uint32_t addr, uint32_t len);
 u16 Flash_ReadID(void);
 u16 Flash_ReadJedecID(void);
+HAL_StatusTypeDef Flash_ReadSFDP(uint32_t addr, uint8_t *pData, uint16_t Size);
  u8 SPI_FLASH_ReadWriteByte(u8 TxData);
+HAL_StatusTypeDef SPI_FLASH_DMA_Start(const uint8_t *pTx, uint8_t *pRx, uint32_t Size);
+uint8_t SPI_FLASH_DMA_Busy(void);
+HAL_StatusTypeDef SPI_FLASH_DMA_Wait(void);
+void SPI_FLASH_Transfer(const uint8_t *pTx, uint8_t *pRx, uint32_t Size);
 #ifdef __cplusplus
 }
 #endif
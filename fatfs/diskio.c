@@ -10,11 +10,279 @@
 #include "ff.h"     /* Obtains integer types */
 #include "diskio.h" /* Declarations of disk functions */
 #include "bsp_spi_flash.h" //hugh
+#include "ry_prof.h"       //hugh
+#include <string.h>
 /* Definitions of physical drive number for each drive */
 #define DEV_RAM 0 /* Example: Map Ramdisk to physical drive 0 */
 #define DEV_MMC 1 /* Example: Map MMC/SD card to physical drive 1 */
 #define DEV_USB 2 /* Example: Map USB MSD to physical drive 2 */
 
+/* Sectors known to be erased (all 0xFF), disk_write can program them without erasing first */
+static BYTE sector_erased[FLASH_SECTOR_COUNT / 8];
+
+#define SECTOR_IS_ERASED(s)    (sector_erased[(s) >> 3] & (1 << ((s) & 7)))
+#define SECTOR_SET_ERASED(s)   (sector_erased[(s) >> 3] |= (1 << ((s) & 7)))
+#define SECTOR_CLR_ERASED(s)   (sector_erased[(s) >> 3] &= ~(1 << ((s) & 7)))
+
+/* Write-back sector cache between FatFs and the flash.
+ * With FF_FS_TINY FatFs shares one window buffer, so FAT and directory sectors
+ * are flushed and re-read constantly while a file grows. Single-sector accesses
+ * (the window) go through the cache, dirty sectors are written back on eviction
+ * or CTRL_SYNC. Multi-sector file data bypasses it. Sectors of the FAT area are
+ * pinned: they are evicted only when every way holds a FAT sector.
+ */
+#ifndef DISK_CACHE_WAYS
+#define DISK_CACHE_WAYS 2 /* 4 KB of RAM per way */
+#endif
+
+typedef struct {
+    LBA_t sector;
+    DWORD stamp; /* LRU: last access */
+    BYTE valid;
+    BYTE dirty;
+    __attribute__((aligned(4))) BYTE buf[FLASH_SECTOR_SIZE];
+} DISK_CACHE_WAY;
+
+static DISK_CACHE_WAY disk_cache[DISK_CACHE_WAYS];
+static DWORD disk_cache_clock;
+static LBA_t fat_start = 1, fat_end = 0; /* Pinned range, learned from the boot sector (empty until then) */
+static DISK_STATS disk_stats;
+
+/* Erase sectors start..end (inclusive) with the largest erase commands the alignment allows.
+ * Sectors already known erased are skipped: a file created over an old one gets
+ * its clusters trimmed by f_open and pre-erased again right after by f_expand. */
+static DRESULT disk_erase_range (LBA_t start, LBA_t end) {
+    LBA_t s, run;
+    DWORD cmds = Flash_Stats.erase_cmds;
+
+    if ((start > end) || (end >= FLASH_SECTOR_COUNT)) {
+        return RES_PARERR;
+    }
+    for (s = start; s <= end;) {
+        if (SECTOR_IS_ERASED (s)) {
+            s++;
+            continue;
+        }
+        for (run = s; (s <= end) && !SECTOR_IS_ERASED (s); s++) {
+        }
+        if (Flash_EraseRange (run * FLASH_SECTOR_SIZE, (s - run) * FLASH_SECTOR_SIZE) != HAL_OK) {
+            return RES_ERROR;
+        }
+        disk_stats.erased_sectors += s - run;
+    }
+    for (s = start; s <= end; s++) {
+        SECTOR_SET_ERASED (s);
+    }
+    disk_stats.erases += Flash_Stats.erase_cmds - cmds;
+    return RES_OK;
+}
+
+/* Page-granular multi-sector write, done in windows of up to 64 KB.
+ * 1. scan: a sector known erased only needs its non-blank pages programmed;
+ *    any other sector is read back page by page and compared. Unchanged pages
+ *    are skipped, and if no byte needs a 0->1 transition the changed pages are
+ *    programmed over the old data (NOR programming only clears bits).
+ * 2. erase: sectors that do need an erase are grouped into contiguous runs and
+ *    handed to the erase planner, so aligned runs use 32K/64K block erases.
+ * 3. program: dirty pages are programmed. Erase and program commands return
+ *    as soon as they are issued, the flash busy wait happens before the next
+ *    command or on CTRL_SYNC, so USB keeps running while the chip finishes.
+ * All reads happen in step 1, before the chip goes busy with the erases.
+ */
+#define SECTOR_PAGES (FLASH_SECTOR_SIZE / SPI_FLASH_PageSize)
+#define WRITE_WINDOW (FLASH_BLOCK64_SIZE / FLASH_SECTOR_SIZE)
+
+/* Bitmask of the pages in buff that are not all 0xFF */
+static WORD sector_used_pages (const BYTE *buff) {
+    WORD used = 0;
+    UINT n, i;
+
+    for (n = 0; n < SECTOR_PAGES; n++, buff += SPI_FLASH_PageSize) {
+        for (i = 0; i < SPI_FLASH_PageSize; i++) {
+            if (buff[i] != 0xFF) {
+                used |= 1 << n;
+                break;
+            }
+        }
+    }
+    return used;
+}
+
+/* Bitmask of the pages that differ from flash, *erase is set when a 0->1 bit is needed */
+static WORD sector_changed_pages (LBA_t sector, const BYTE *buff, BYTE *erase) {
+    BYTE page[SPI_FLASH_PageSize];
+    DWORD addr = sector * FLASH_SECTOR_SIZE;
+    WORD dirty = 0;
+    UINT n, i;
+
+    *erase = 0;
+    for (n = 0; n < SECTOR_PAGES; n++, buff += SPI_FLASH_PageSize) {
+        Flash_ReadData (addr + n * SPI_FLASH_PageSize, page, SPI_FLASH_PageSize);
+        for (i = 0; i < SPI_FLASH_PageSize; i++) {
+            if (page[i] != buff[i]) {
+                dirty |= 1 << n;
+                if (buff[i] & ~page[i]) {
+                    *erase = 1;
+                    return dirty;
+                }
+            }
+        }
+    }
+    return dirty;
+}
+
+static DRESULT disk_write_window (LBA_t sector, const BYTE *buff, UINT count) {
+    WORD dirty[WRITE_WINDOW];
+    WORD need_erase = 0; /* bit n: sector + n has to be erased */
+    BYTE erase;
+    UINT n, start, i;
+
+    for (n = 0; n < count; n++) {
+        if (SECTOR_IS_ERASED (sector + n)) {
+            dirty[n] = sector_used_pages (buff + n * FLASH_SECTOR_SIZE);
+        } else {
+            dirty[n] = sector_changed_pages (sector + n, buff + n * FLASH_SECTOR_SIZE, &erase);
+            if (erase) {
+                need_erase |= 1 << n;
+            }
+        }
+    }
+
+    for (n = 0; n < count;) {
+        if (!(need_erase & (1 << n))) {
+            n++;
+            continue;
+        }
+        for (start = n; (n < count) && (need_erase & (1 << n)); n++) {
+            dirty[n] = sector_used_pages (buff + n * FLASH_SECTOR_SIZE);
+        }
+        if (disk_erase_range (sector + start, sector + n - 1) != RES_OK) {
+            return RES_ERROR;
+        }
+    }
+
+    for (n = 0; n < count; n++) {
+        DWORD addr = (sector + n) * FLASH_SECTOR_SIZE;
+        const BYTE *src = buff + n * FLASH_SECTOR_SIZE;
+
+        if (dirty[n]) {
+            SECTOR_CLR_ERASED (sector + n);
+        }
+        for (i = 0; i < SECTOR_PAGES; i++) {
+            if (dirty[n] & (1 << i)) {
+                if (Flash_PageProgram (addr + i * SPI_FLASH_PageSize, (uint8_t *)src + i * SPI_FLASH_PageSize, SPI_FLASH_PageSize) != HAL_OK) {
+                    return RES_ERROR;
+                }
+                disk_stats.programs++;
+            }
+        }
+    }
+    return RES_OK;
+}
+
+static DRESULT disk_flash_write (LBA_t sector, const BYTE *buff, UINT count) {
+    UINT n;
+
+    /* Windows end on 64 KB boundaries so a fully rewritten block becomes one block erase */
+    for (; count; count -= n, sector += n, buff += n * FLASH_SECTOR_SIZE) {
+        n = WRITE_WINDOW - (sector % WRITE_WINDOW);
+        if (n > count) {
+            n = count;
+        }
+        if (disk_write_window (sector, buff, n) != RES_OK) {
+            return RES_ERROR;
+        }
+    }
+    return RES_OK;
+}
+
+/* Learn the FAT area from a FAT volume boot sector so its sectors can be pinned */
+static void disk_cache_learn_fat (LBA_t sector, const BYTE *vbr) {
+    DWORD fatsz;
+
+    if (((vbr[0] != 0xEB) && (vbr[0] != 0xE9)) || (vbr[510] != 0x55) || (vbr[511] != 0xAA) ||
+        ((vbr[11] | (vbr[12] << 8)) != FLASH_SECTOR_SIZE) || (vbr[16] == 0)) {
+        return;
+    }
+    fatsz = vbr[22] | (vbr[23] << 8);
+    if (fatsz == 0) {
+        fatsz = vbr[36] | (vbr[37] << 8) | ((DWORD)vbr[38] << 16) | ((DWORD)vbr[39] << 24);
+    }
+    fat_start = sector + (vbr[14] | (vbr[15] << 8));
+    fat_end = fat_start + fatsz * vbr[16] - 1;
+}
+
+static DISK_CACHE_WAY *disk_cache_find (LBA_t sector) {
+    for (UINT i = 0; i < DISK_CACHE_WAYS; i++) {
+        if (disk_cache[i].valid && (disk_cache[i].sector == sector)) {
+            disk_cache[i].stamp = ++disk_cache_clock;
+            return &disk_cache[i];
+        }
+    }
+    return NULL;
+}
+
+static DRESULT disk_cache_writeback (DISK_CACHE_WAY *way) {
+    if (way->dirty) {
+        if (disk_flash_write (way->sector, way->buf, 1) != RES_OK) {
+            return RES_ERROR;
+        }
+        way->dirty = 0;
+        disk_stats.writebacks++;
+    }
+    return RES_OK;
+}
+
+/* Pick a way for a new sector: an empty way, else the LRU unpinned way, else the LRU way */
+static DISK_CACHE_WAY *disk_cache_alloc (LBA_t sector) {
+    DISK_CACHE_WAY *victim = NULL, *pinned = NULL;
+
+    for (UINT i = 0; i < DISK_CACHE_WAYS; i++) {
+        DISK_CACHE_WAY *way = &disk_cache[i];
+
+        if (!way->valid) {
+            victim = way;
+            break;
+        }
+        if ((way->sector >= fat_start) && (way->sector <= fat_end)) {
+            if (!pinned || (way->stamp < pinned->stamp)) {
+                pinned = way;
+            }
+        } else if (!victim || (way->stamp < victim->stamp)) {
+            victim = way;
+        }
+    }
+    if (!victim) {
+        victim = pinned;
+    }
+    if (disk_cache_writeback (victim) != RES_OK) {
+        return NULL;
+    }
+    victim->sector = sector;
+    victim->valid = 1;
+    victim->stamp = ++disk_cache_clock;
+    return victim;
+}
+
+/* Drop cached copies of sectors start..end, pending writes included (trimmed or overwritten) */
+static void disk_cache_invalidate (LBA_t start, LBA_t end) {
+    for (UINT i = 0; i < DISK_CACHE_WAYS; i++) {
+        if (disk_cache[i].valid && (disk_cache[i].sector >= start) && (disk_cache[i].sector <= end)) {
+            disk_cache[i].valid = 0;
+            disk_cache[i].dirty = 0;
+        }
+    }
+}
+
+static DRESULT disk_cache_sync (void) {
+    for (UINT i = 0; i < DISK_CACHE_WAYS; i++) {
+        if (disk_cache[i].valid && (disk_cache_writeback (&disk_cache[i]) != RES_OK)) {
+            return RES_ERROR;
+        }
+    }
+    return (Flash_WaitBusy() == HAL_OK) ? RES_OK : RES_ERROR;
+}
+
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
 /*-----------------------------------------------------------------------*/
@@ -44,6 +312,7 @@ DSTATUS disk_initialize (
         break;
     case 0:
         Flash_Init();printf ("SPI flash W25Qx init done!\r\n");
+        disk_cache_invalidate (0, FLASH_SECTOR_COUNT - 1);
         Stat = RES_OK;
         break;
     default:
@@ -56,19 +325,56 @@ DSTATUS disk_initialize (
 /* Read Sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
 
+static DRESULT disk_read_sectors (BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
+    DISK_CACHE_WAY *way;
+
+    if (pdrv == 0) {
+        if ((sector >= FLASH_SECTOR_COUNT) || (count > FLASH_SECTOR_COUNT - sector)) {
+            return RES_PARERR;
+        }
+        if (count == 1) {
+            way = disk_cache_find (sector);
+            if (way) {
+                disk_stats.hits++;
+            } else {
+                disk_stats.misses++;
+                way = disk_cache_alloc (sector);
+                if (!way) {
+                    return RES_ERROR;
+                }
+                Flash_ReadData (sector * FLASH_SECTOR_SIZE, way->buf, FLASH_SECTOR_SIZE);
+                disk_cache_learn_fat (sector, way->buf);
+            }
+            memcpy (buff, way->buf, FLASH_SECTOR_SIZE);
+            return RES_OK;
+        }
+        /* Bulk file data: read around the cache, then patch in cached (possibly dirty) sectors */
+        disk_stats.misses += count;
+        Flash_ReadData (sector * FLASH_SECTOR_SIZE, (uint8_t *)buff, count * FLASH_SECTOR_SIZE);
+        for (UINT i = 0; i < DISK_CACHE_WAYS; i++) {
+            if (disk_cache[i].valid && (disk_cache[i].sector >= sector) && (disk_cache[i].sector < sector + count)) {
+                memcpy (buff + (disk_cache[i].sector - sector) * FLASH_SECTOR_SIZE, disk_cache[i].buf, FLASH_SECTOR_SIZE);
+            }
+        }
+        return RES_OK;
+    } else {
+        return RES_PARERR;
+    }
+}
+
 DRESULT disk_read (
     BYTE pdrv,    /* Physical drive nmuber to identify the drive */
     BYTE *buff,   /* Data buffer to store read data */
     LBA_t sector, /* Start sector in LBA */
     UINT count    /* Number of sectors to read */
 ) {
+    DRESULT res;
+    RY_PROF_BEGIN (RY_PROF_DISK_READ);
+
     //printf ("disk_read\r\n");
-    if (pdrv == 0) {
-        Flash_ReadData (sector * FLASH_SECTOR_SIZE, (uint8_t *)buff, count * FLASH_SECTOR_SIZE);
-        return RES_OK;
-    } else {
-        return RES_PARERR;
-    }
+    res = disk_read_sectors (pdrv, buff, sector, count);
+    RY_PROF_END (RY_PROF_DISK_READ);
+    return res;
 }
 
 /*-----------------------------------------------------------------------*/
@@ -77,20 +383,49 @@ DRESULT disk_read (
 
 #if FF_FS_READONLY == 0
 
+static DRESULT disk_write_sectors (BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
+    DISK_CACHE_WAY *way;
+
+    if (pdrv == 0) {
+        if ((sector >= FLASH_SECTOR_COUNT) || (count > FLASH_SECTOR_COUNT - sector)) {
+            return RES_PARERR;
+        }
+        if (count == 1) {
+            way = disk_cache_find (sector);
+            if (way) {
+                disk_stats.hits++;
+            } else {
+                disk_stats.misses++;
+                way = disk_cache_alloc (sector);
+                if (!way) {
+                    return RES_ERROR;
+                }
+            }
+            memcpy (way->buf, buff, FLASH_SECTOR_SIZE);
+            way->dirty = 1;
+            return RES_OK;
+        }
+        disk_stats.misses += count;
+        disk_cache_invalidate (sector, sector + count - 1);
+        return disk_flash_write (sector, buff, count);
+    } else {
+        return RES_PARERR;
+    }
+}
+
 DRESULT disk_write (
     BYTE pdrv,        /* Physical drive nmuber to identify the drive */
     const BYTE *buff, /* Data to be written */
     LBA_t sector,     /* Start sector in LBA */
     UINT count        /* Number of sectors to write */
 ) {
+    DRESULT res;
+    RY_PROF_BEGIN (RY_PROF_DISK_WRITE);
+
     //printf ("disk_write\r\n");
-    if (pdrv == 0) {
-        Flash_SectorErase (sector * FLASH_SECTOR_SIZE);
-        FLASH_WriteData (sector * FLASH_SECTOR_SIZE, (uint8_t *)buff, count * FLASH_SECTOR_SIZE);
-        return RES_OK;
-    } else {
-        return RES_PARERR;
-    }
+    res = disk_write_sectors (pdrv, buff, sector, count);
+    RY_PROF_END (RY_PROF_DISK_WRITE);
+    return res;
 }
 
 #endif
@@ -111,7 +446,7 @@ DRESULT disk_ioctl (
     if (pdrv == 0) {
         switch (cmd) {
         case CTRL_SYNC:
-            res = RES_OK;
+            res = disk_cache_sync();
             break;
         case GET_SECTOR_SIZE:
             *(DWORD *)buff = FLASH_SECTOR_SIZE;
@@ -125,6 +460,19 @@ DRESULT disk_ioctl (
             *(DWORD *)buff = 1;
             res = RES_OK;
             break;
+        case CTRL_TRIM:         /* Freed clusters: erase now so later writes skip the erase */
+        case CTRL_ERASE_RANGE:  /* Pre-erase contiguous space for a large file */
+            disk_cache_invalidate (((LBA_t *)buff)[0], ((LBA_t *)buff)[1]);
+            res = disk_erase_range (((LBA_t *)buff)[0], ((LBA_t *)buff)[1]);
+            break;
+        case CTRL_CACHE_STATS:
+            *(DISK_STATS *)buff = disk_stats;
+            res = RES_OK;
+            break;
+        case CTRL_CACHE_RESET:
+            memset (&disk_stats, 0, sizeof (disk_stats));
+            res = RES_OK;
+            break;
         default:
             res = RES_PARERR;
         }
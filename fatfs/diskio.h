@@ -71,6 +71,21 @@ DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 #define ATA_GET_MODEL		21	/* Get model name */
 #define ATA_GET_SN			22	/* Get serial number */
 
+/* User defined command */
+#define CTRL_ERASE_RANGE	64	/* Pre-erase a block of sectors, buff = LBA_t[2] {start, end} (hugh) */
+#define CTRL_CACHE_STATS	65	/* Get sector cache and flash traffic counters, buff = DISK_STATS* (hugh) */
+#define CTRL_CACHE_RESET	66	/* Clear the counters (hugh) */
+
+/* Sector cache and flash traffic counters */
+typedef struct {
+	DWORD	hits;			/* Sector accesses served by the cache */
+	DWORD	misses;			/* Sector accesses that went to the flash */
+	DWORD	writebacks;		/* Dirty cache sectors written back */
+	DWORD	erases;			/* Erase commands issued (4K/32K/64K/chip) */
+	DWORD	erased_sectors;	/* Sectors covered by those erases */
+	DWORD	programs;		/* Pages programmed */
+} DISK_STATS;
+
 static volatile DSTATUS Stat = STA_NOINIT;//hugh
 
 #ifdef __cplusplus
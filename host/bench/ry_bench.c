@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim.h"
+#include "sim_usbd.h"
+#include "sim_w25q.h"
+#include "sim_iflash.h"
+#include "ry_proto.h"
+#include "hid_custom.h"
+#include "user_fatfs.h"
+#include "ry_log.h"
+#include "ry_event.h"
+#include "ry_boot.h"
+#include "iap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//--------------------------升级基准------------------------------------
+// 固件的USB/升级/FatFs/W25Q代码在仿真外设上完成一次无丢包的V2传输，输出：
+// 仿真时间（SOF到DONE）、SPI FLASH和内部FLASH的擦除次数、SPI总线字节数、RAM峰值
+// 每次吞吐量相关的修改前后各运行一次作为回归基准，结果只与代码和镜像有关
+// 空片上写入不需要擦除，先用取反的镜像传输一次，统计第二次（覆盖旧数据）的传输
+//   ry_bench [-t firmware|setup|load] [-i hid|bulk] [-c] [image]
+//   -c：EOF后校验CRC32；不给镜像文件时使用固定种子的160K伪随机数据
+// 静态RAM由Makefile按固件目标文件的.data/.bss统计（主机上指针为8字节，略大于目标板）
+//--------------------------------------------------------------------
+#ifndef RY_BENCH_STATIC_RAM
+#define RY_BENCH_STATIC_RAM     0
+#endif
+
+#define BENCH_IMAGE_MAX         (2 * 1024 * 1024)
+#define BENCH_IMAGE_DEFAULT     (160 * 1024)   // 小于IAP_IMAGE_MAX
+#define BENCH_TIMEOUT_NS        (1000 * SIM_NS_PER_MS)  // 大于FatFs连续擦除时的停顿，基准中不应超时重发
+#define BENCH_DRAIN_NS          (5000 * SIM_NS_PER_MS)
+#define BENCH_DEADLINE_NS       (600000 * SIM_NS_PER_MS)
+
+static struct {
+    uint16_t type;
+    uint8_t out_ep;
+    uint8_t in_ep;
+    uint8_t flags;
+    uint32_t size;
+    const char *type_name;
+    const char *intf_name;
+} bench_cfg = {0xCCDD, 0x03, 0x83, 0, 0, "setup", "bulk"};
+
+static uint8_t bench_image[BENCH_IMAGE_MAX];
+static uint8_t bench_pkt[RY_PROTO_PACKET_SIZE];
+static ry_proto_t bench_proto;
+static uint8_t bench_active;
+
+typedef struct {
+    uint64_t ns;
+    sim_w25q_stats_t w25q;
+    sim_iflash_stats_t iflash;
+    sim_stats_t sim;
+    sim_usbd_stats_t usbd;
+} bench_snap_t;
+
+static bench_snap_t bench_start, bench_end;
+
+//--------------------------主机端------------------------------------
+static void bench_timeout (void *arg);
+
+static void bench_pump (void) {
+    while ((sim_usbd_out_queued (bench_cfg.out_ep) < SIM_USBD_QUEUE) && ry_proto_next (&bench_proto, bench_pkt)) {
+        sim_usbd_out (bench_cfg.out_ep, bench_pkt, sizeof (bench_pkt));
+    }
+    sim_timer_start (bench_timeout, NULL,
+                     sim_now + (ry_proto_draining (&bench_proto) ? BENCH_DRAIN_NS : BENCH_TIMEOUT_NS));
+}
+
+static void bench_timeout (void *arg) {
+    (void)arg;
+    if (bench_active) {
+        ry_proto_timeout (&bench_proto);
+        bench_pump();
+    }
+}
+
+static void bench_host_in (uint8_t ep, const uint8_t *data, uint32_t len) {
+    if (!bench_active || (ep != bench_cfg.in_ep)) {
+        return;
+    }
+    ry_proto_ack (&bench_proto, data, len);
+    if (bench_proto.state != RY_PROTO_RUN) {
+        bench_active = 0;
+        sim_timer_stop (bench_timeout, NULL);
+        return;
+    }
+    bench_pump();
+}
+
+//--------------------------设备端------------------------------------
+static void bench_snapshot (bench_snap_t *s) {
+    s->ns = sim_now;
+    s->w25q = sim_w25q_stats;
+    s->iflash = sim_iflash_stats;
+    s->sim = sim_stats;
+    s->usbd = sim_usbd_stats;
+}
+
+static void bench_invert (void) {
+    for (uint32_t i = 0; i < bench_cfg.size; i++) {
+        bench_image[i] = ~bench_image[i];
+    }
+}
+
+static void bench_transfer (uint16_t seq0) {
+    uint64_t deadline = sim_now + BENCH_DEADLINE_NS;
+
+    ry_proto_begin (&bench_proto, bench_cfg.type, bench_image, bench_cfg.size, bench_cfg.flags, seq0);
+    bench_active = 1;
+    bench_pump();
+    while (bench_active && (sim_now < deadline)) {
+        ry_event_dispatch();
+    }
+    bench_active = 0;
+    sim_timer_stop (bench_timeout, NULL);
+}
+
+static void bench_body (void) {
+
+    USART_Printf_Init (115200);
+    ry_log_init();
+    fatfs_file_init();
+    ry_boot_check();
+    ry_event_register (RY_EVENT_LOG, ry_log_poll);
+    ry_event_register (RY_EVENT_TICK, ry_log_poll);
+    ry_event_tick_init();
+
+    sim_usbd_period (0x02, SIM_USBD_HID_NS);
+    sim_usbd_period (0x81, SIM_USBD_HID_NS);
+    sim_usbd_host_in (bench_host_in);
+    hid_custom_init (0, 0);
+    while (!sim_usbd_configured()) {
+        ry_event_dispatch();
+    }
+    ry_log_flush();
+
+    bench_invert();
+    bench_transfer (0);
+    bench_invert();
+    if (bench_proto.state != RY_PROTO_DONE) {
+        return;
+    }
+    bench_snapshot (&bench_start);
+    bench_transfer (bench_proto.sent);
+    bench_snapshot (&bench_end);
+    ry_log_flush();
+}
+
+//--------------------------------------------------------------------
+static uint32_t bench_load (const char *path) {
+    FILE *f = fopen (path, "rb");
+    size_t n;
+
+    if (f == NULL) {
+        perror (path);
+        exit (2);
+    }
+    n = fread (bench_image, 1, sizeof (bench_image), f);
+    if (!feof (f)) {
+        fprintf (stderr, "%s: larger than %u bytes\n", path, BENCH_IMAGE_MAX);
+        exit (2);
+    }
+    fclose (f);
+    return n;
+}
+
+static void bench_fill (uint32_t size) {
+    uint32_t i, x = 0x2545F491;
+
+    for (i = 0; i < size; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        bench_image[i] = (uint8_t)x;
+    }
+}
+
+static void bench_usage (void) {
+    fprintf (stderr, "usage: ry_bench [-t firmware|setup|load] [-i hid|bulk] [-c] [image]\n");
+    exit (2);
+}
+
+int main (int argc, char **argv) {
+    const char *path = NULL;
+    uint64_t ns;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp (argv[i], "-t") && (i + 1 < argc)) {
+            bench_cfg.type_name = argv[++i];
+            if (!strcmp (bench_cfg.type_name, "firmware")) {
+                bench_cfg.type = 0xAABB;
+            } else if (!strcmp (bench_cfg.type_name, "setup")) {
+                bench_cfg.type = 0xCCDD;
+            } else if (!strcmp (bench_cfg.type_name, "load")) {
+                bench_cfg.type = 0xEEFF;
+            } else {
+                bench_usage();
+            }
+        } else if (!strcmp (argv[i], "-i") && (i + 1 < argc)) {
+            bench_cfg.intf_name = argv[++i];
+            if (!strcmp (bench_cfg.intf_name, "hid")) {
+                bench_cfg.out_ep = 0x02;
+                bench_cfg.in_ep = 0x81;
+            } else if (!strcmp (bench_cfg.intf_name, "bulk")) {
+                bench_cfg.out_ep = 0x03;
+                bench_cfg.in_ep = 0x83;
+            } else {
+                bench_usage();
+            }
+        } else if (!strcmp (argv[i], "-c")) {
+            bench_cfg.flags |= RY_PROTO_FLAG_CRC;
+        } else if ((argv[i][0] != '-') && (path == NULL)) {
+            path = argv[i];
+        } else {
+            bench_usage();
+        }
+    }
+    if (path) {
+        bench_cfg.size = bench_load (path);
+    } else {
+        bench_cfg.size = BENCH_IMAGE_DEFAULT;
+        bench_fill (bench_cfg.size);
+    }
+    if ((bench_cfg.type == 0xAABB) && (bench_cfg.size > IAP_IMAGE_MAX)) {
+        fprintf (stderr, "firmware image larger than %u bytes\n", IAP_IMAGE_MAX);
+        return 2;
+    }
+
+    sim_reset();
+    sim_run (bench_body);
+
+    ns = bench_end.ns - bench_start.ns;
+    printf ("ry_bench: %s %u bytes via %s%s\n", bench_cfg.type_name, bench_cfg.size, bench_cfg.intf_name,
+            (bench_cfg.flags & RY_PROTO_FLAG_CRC) ? " crc" : "");
+    printf ("  result       %s\n", (bench_proto.state == RY_PROTO_DONE) ? "done" : "FAIL");
+    printf ("  time         %.3f ms  %.1f KB/s\n", ns / 1e6, ns ? bench_cfg.size / 1024.0 / (ns / 1e9) : 0.0);
+    printf ("  packets      %u sent %u retransmits %u timeouts  usb out %u in %u\n", bench_proto.stats.packets,
+            bench_proto.stats.retransmits, bench_proto.stats.timeouts, bench_end.usbd.out_packets - bench_start.usbd.out_packets,
+            bench_end.usbd.in_packets - bench_start.usbd.in_packets);
+    printf ("  spi erase    4k:%u 32k:%u 64k:%u\n", bench_end.w25q.erase_4k - bench_start.w25q.erase_4k,
+            bench_end.w25q.erase_32k - bench_start.w25q.erase_32k, bench_end.w25q.erase_64k - bench_start.w25q.erase_64k);
+    printf ("  spi bytes    read:%u program:%u bus:%llu\n", bench_end.w25q.read_bytes - bench_start.w25q.read_bytes,
+            bench_end.w25q.program_bytes - bench_start.w25q.program_bytes,
+            (unsigned long long)(bench_end.sim.spi_bytes - bench_start.sim.spi_bytes));
+    printf ("  iflash       page erase:%u block erase:%u page program:%u\n",
+            bench_end.iflash.page_erases - bench_start.iflash.page_erases,
+            bench_end.iflash.block_erases - bench_start.iflash.block_erases,
+            bench_end.iflash.page_programs - bench_start.iflash.page_programs);
+    printf ("  ram          static:%u stack peak:%u\n", RY_BENCH_STATIC_RAM, sim_stack_peak());
+    if (sim_stats.errors) {
+        printf ("  model errors %u\n", sim_stats.errors);
+    }
+    return ((bench_proto.state == RY_PROTO_DONE) && !sim_stats.errors) ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SIM_CH32V30X_H
+#define SIM_CH32V30X_H
+
+//--------------------------主机仿真------------------------------------
+// 包含原ch32v30x.h，再把固件用到的外设实例改为sim中的全局变量：
+// 全局变量在-no-pie可执行文件的低地址，(uint32_t)&SPI3->DATAR之类的写法保持有效
+//--------------------------------------------------------------------
+#include_next "ch32v30x.h"
+
+extern RCC_TypeDef sim_RCC;
+extern GPIO_TypeDef sim_GPIO[5];
+extern SPI_TypeDef sim_SPI[3];
+extern USART_TypeDef sim_USART[3];
+extern DMA_TypeDef sim_DMA[2];
+extern DMA_Channel_TypeDef sim_DMA1_Channel[7];
+extern DMA_Channel_TypeDef sim_DMA2_Channel[11];
+extern CRC_TypeDef sim_CRC;
+extern FLASH_TypeDef sim_FLASH;
+extern BKP_TypeDef sim_BKP;
+extern PWR_TypeDef sim_PWR;
+
+#undef RCC
+#undef GPIOA
+#undef GPIOB
+#undef GPIOC
+#undef GPIOD
+#undef GPIOE
+#undef SPI1
+#undef SPI2
+#undef SPI3
+#undef USART1
+#undef USART2
+#undef USART3
+#undef DMA1
+#undef DMA2
+#undef DMA1_Channel1
+#undef DMA1_Channel2
+#undef DMA1_Channel3
+#undef DMA1_Channel4
+#undef DMA1_Channel5
+#undef DMA1_Channel6
+#undef DMA1_Channel7
+#undef DMA2_Channel1
+#undef DMA2_Channel2
+#undef DMA2_Channel3
+#undef DMA2_Channel4
+#undef DMA2_Channel5
+#undef DMA2_Channel6
+#undef DMA2_Channel7
+#undef DMA2_Channel8
+#undef DMA2_Channel9
+#undef DMA2_Channel10
+#undef DMA2_Channel11
+#undef CRC
+#undef FLASH
+#undef BKP
+#undef PWR
+
+#define RCC                 (&sim_RCC)
+#define GPIOA               (&sim_GPIO[0])
+#define GPIOB               (&sim_GPIO[1])
+#define GPIOC               (&sim_GPIO[2])
+#define GPIOD               (&sim_GPIO[3])
+#define GPIOE               (&sim_GPIO[4])
+#define SPI1                (&sim_SPI[0])
+#define SPI2                (&sim_SPI[1])
+#define SPI3                (&sim_SPI[2])
+#define USART1              (&sim_USART[0])
+#define USART2              (&sim_USART[1])
+#define USART3              (&sim_USART[2])
+#define DMA1                (&sim_DMA[0])
+#define DMA2                (&sim_DMA[1])
+#define DMA1_Channel1       (&sim_DMA1_Channel[0])
+#define DMA1_Channel2       (&sim_DMA1_Channel[1])
+#define DMA1_Channel3       (&sim_DMA1_Channel[2])
+#define DMA1_Channel4       (&sim_DMA1_Channel[3])
+#define DMA1_Channel5       (&sim_DMA1_Channel[4])
+#define DMA1_Channel6       (&sim_DMA1_Channel[5])
+#define DMA1_Channel7       (&sim_DMA1_Channel[6])
+#define DMA2_Channel1       (&sim_DMA2_Channel[0])
+#define DMA2_Channel2       (&sim_DMA2_Channel[1])
+#define DMA2_Channel3       (&sim_DMA2_Channel[2])
+#define DMA2_Channel4       (&sim_DMA2_Channel[3])
+#define DMA2_Channel5       (&sim_DMA2_Channel[4])
+#define DMA2_Channel6       (&sim_DMA2_Channel[5])
+#define DMA2_Channel7       (&sim_DMA2_Channel[6])
+#define DMA2_Channel8       (&sim_DMA2_Channel[7])
+#define DMA2_Channel9       (&sim_DMA2_Channel[8])
+#define DMA2_Channel10      (&sim_DMA2_Channel[9])
+#define DMA2_Channel11      (&sim_DMA2_Channel[10])
+#define CRC                 (&sim_CRC)
+#define FLASH               (&sim_FLASH)
+#define BKP                 (&sim_BKP)
+#define PWR                 (&sim_PWR)
+
+#endif /* SIM_CH32V30X_H */
@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SIM_HOST_H
+#define SIM_HOST_H
+
+/* 主机编译时强制包含（-include）：x86的interrupt属性不接受参数，中断入口按普通函数编译 */
+#define interrupt(x) unused
+
+#endif /* SIM_HOST_H */
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+//--------------------------主机仿真------------------------------------
+// 固件源文件按原样在x86 Linux上编译，StdPeriph和CherryUSB的接口由sim实现：
+// 1.时间只由外设推进（SPI字节、DMA、FLASH忙、USB帧、WFI），CPU执行不计时间，
+//   得到的是I/O决定的下限，与实测对比时注意
+// 2.中断在外设hook（StdPeriph函数、__enable_irq、WFI）处进入，打开中断时才进入，
+//   中断处理函数与固件运行在同一个栈上
+// 3.固件在sim_run()中运行：栈和全局变量都在4G以下，DMA地址寄存器写(uint32_t)指针仍然有效
+// 4.模型发现的误用（编程前未擦除、DMA期间轮询SPI、未解锁写内部FLASH等）计入sim_stats.errors
+// 5.掉电：sim_power_cut非0时，FLASH模型每次编程/擦除倒数一次，到0的那一次只完成一半，
+//   之后sim_power_off()放弃固件上下文，sim_run()立即返回，sim_power_lost置1
+//--------------------------------------------------------------------
+#define SIM_NS_PER_US       1000ULL
+#define SIM_NS_PER_MS       1000000ULL
+#define SIM_STACK_SIZE      (256 * 1024)
+
+typedef struct {
+    uint64_t spi_bytes;       // SPI总线上的字节数（轮询+DMA）
+    uint64_t spi_dma_bytes;
+    uint32_t spi_dma_chunks;  // DMA分段数
+    uint32_t irqs;
+    uint32_t wfis;
+    uint32_t uart_bytes;      // 日志串口发送的字节数
+    uint32_t errors;          // 模型检查到的错误
+} sim_stats_t;
+
+extern sim_stats_t sim_stats;
+extern uint64_t sim_now;  // ns
+extern uint8_t sim_uart_echo;  // 1:日志串口输出打印到stdout
+extern uint32_t sim_power_cut;  // 非0：第n次FLASH编程/擦除时掉电
+extern uint8_t sim_power_lost;  // 上一次sim_run()因掉电结束
+
+typedef void (*sim_timer_fn)(void *arg);
+typedef void (*sim_irq_handler)(void);
+
+void sim_reset(void);
+void sim_run(void (*fn)(void));
+uint32_t sim_stack_peak(void);
+
+void sim_advance(uint64_t ns);
+void sim_step(void);
+void sim_error(const char *fmt, ...);
+uint8_t sim_in_isr(void);
+uint8_t sim_power_check(void);
+void sim_power_off(void);
+
+void sim_timer_start(sim_timer_fn fn, void *arg, uint64_t when);
+void sim_timer_stop(sim_timer_fn fn, void *arg);
+
+void sim_irq_attach(int irqn, sim_irq_handler handler);
+void sim_irq_raise(int irqn);
+
+/* 由sim_periph.c实现，sim_step()中调用 */
+void sim_periph_reset(void);
+void sim_periph_service(void);
+
+/* 日志串口输出 */
+void sim_uart_put(const uint8_t *data, uint32_t len);
+const char *sim_uart_text(void);
+void sim_uart_clear(void);
+
+#endif /* SIM_H */
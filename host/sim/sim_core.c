@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim.h"
+#include "ch32v30x.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#define SIM_TIMER_MAX   16
+#define SIM_IRQ_MAX     128
+#define SIM_STACK_FILL  0xA5
+
+sim_stats_t sim_stats;
+uint64_t sim_now;
+uint8_t sim_uart_echo;
+uint32_t sim_power_cut;
+uint8_t sim_power_lost;
+
+PFIC_Type sim_PFIC;
+SysTick_Type sim_SysTick;
+uint32_t SystemCoreClock = 96000000;
+
+static struct {
+    sim_timer_fn fn;
+    void *arg;
+    uint64_t when;
+} sim_timers[SIM_TIMER_MAX];
+
+static sim_irq_handler sim_irq_handlers[SIM_IRQ_MAX];
+static uint8_t sim_irq_pending[SIM_IRQ_MAX];
+static uint8_t sim_irq_enabled[SIM_IRQ_MAX];
+static uint8_t sim_irq_on;   // mstatus.MIE
+static uint8_t sim_isr;      // 正在执行中断处理
+static uint8_t sim_firing;   // 正在执行定时事件
+static uint64_t sim_mcycle;
+static uint64_t sim_mcycle_rem;
+
+static char sim_uart_buf[64 * 1024];
+static uint32_t sim_uart_len;
+
+static uint8_t sim_stack[SIM_STACK_SIZE] __attribute__((aligned(16)));
+static ucontext_t sim_host_ctx, sim_fw_ctx;
+static void (*sim_fw_fn)(void);
+
+/**
+ * @brief  复位时间、中断和全部外设模型，每个测试开始时调用
+ */
+void sim_reset (void) {
+    memset (&sim_stats, 0, sizeof (sim_stats));
+    memset (sim_timers, 0, sizeof (sim_timers));
+    memset (sim_irq_pending, 0, sizeof (sim_irq_pending));
+    memset (sim_irq_enabled, 0, sizeof (sim_irq_enabled));
+    memset (&sim_PFIC, 0, sizeof (sim_PFIC));
+    memset (&sim_SysTick, 0, sizeof (sim_SysTick));
+    sim_now = 0;
+    sim_mcycle = 0;
+    sim_mcycle_rem = 0;
+    sim_irq_on = 1;  // startup中mret之后中断已打开
+    sim_isr = 0;
+    sim_firing = 0;
+    SystemCoreClock = 96000000;
+    sim_uart_clear();
+    sim_periph_reset();
+}
+
+static void sim_fw_entry (void) {
+    sim_fw_fn();
+}
+
+/**
+ * @brief  在sim_stack上运行fn，返回后可用sim_stack_peak()得到栈使用峰值
+ */
+void sim_run (void (*fn)(void)) {
+    memset (sim_stack, SIM_STACK_FILL, sizeof (sim_stack));
+    sim_fw_fn = fn;
+    sim_power_lost = 0;
+    getcontext (&sim_fw_ctx);
+    sim_fw_ctx.uc_stack.ss_sp = sim_stack;
+    sim_fw_ctx.uc_stack.ss_size = sizeof (sim_stack);
+    sim_fw_ctx.uc_link = &sim_host_ctx;
+    makecontext (&sim_fw_ctx, sim_fw_entry, 0);
+    swapcontext (&sim_host_ctx, &sim_fw_ctx);
+}
+
+uint32_t sim_stack_peak (void) {
+    uint32_t i = 0;
+
+    while ((i < sizeof (sim_stack)) && (sim_stack[i] == SIM_STACK_FILL)) {
+        i++;
+    }
+    return sizeof (sim_stack) - i;
+}
+
+void sim_error (const char *fmt, ...) {
+    va_list ap;
+
+    sim_stats.errors++;
+    fprintf (stderr, "sim error @%llu.%06llums: ", (unsigned long long)(sim_now / SIM_NS_PER_MS),
+             (unsigned long long)(sim_now % SIM_NS_PER_MS));
+    va_start (ap, fmt);
+    vfprintf (stderr, fmt, ap);
+    va_end (ap);
+    fputc ('\n', stderr);
+}
+
+uint8_t sim_in_isr (void) {
+    return sim_isr;
+}
+
+//--------------------------掉电------------------------------------
+/**
+ * @brief  FLASH模型每次编程/擦除前调用
+ * @retval 1:这一次操作中掉电，模型只完成一半后调用sim_power_off()
+ */
+uint8_t sim_power_check (void) {
+    return sim_power_cut && (--sim_power_cut == 0);
+}
+
+/**
+ * @brief  掉电：固件上下文不再继续，sim_run()返回；FLASH内容保持，其余状态由sim_reset()清除
+ */
+void sim_power_off (void) {
+    sim_power_lost = 1;
+    sim_power_cut = 0;
+    swapcontext (&sim_fw_ctx, &sim_host_ctx);
+    fprintf (stderr, "sim: firmware resumed after power off\n");
+    abort();
+}
+
+//--------------------------定时事件------------------------------------
+void sim_timer_start (sim_timer_fn fn, void *arg, uint64_t when) {
+    int i, free = -1;
+
+    for (i = 0; i < SIM_TIMER_MAX; i++) {
+        if ((sim_timers[i].fn == fn) && (sim_timers[i].arg == arg)) {
+            sim_timers[i].when = when;
+            return;
+        }
+        if ((free < 0) && (sim_timers[i].fn == NULL)) {
+            free = i;
+        }
+    }
+    if (free < 0) {
+        fprintf (stderr, "sim: too many timers\n");
+        abort();
+    }
+    sim_timers[free].fn = fn;
+    sim_timers[free].arg = arg;
+    sim_timers[free].when = when;
+}
+
+void sim_timer_stop (sim_timer_fn fn, void *arg) {
+    int i;
+
+    for (i = 0; i < SIM_TIMER_MAX; i++) {
+        if ((sim_timers[i].fn == fn) && (sim_timers[i].arg == arg)) {
+            sim_timers[i].fn = NULL;
+        }
+    }
+}
+
+/* 最早到期的定时事件，没有时返回-1 */
+static int sim_timer_next (void) {
+    int i, next = -1;
+
+    for (i = 0; i < SIM_TIMER_MAX; i++) {
+        if (sim_timers[i].fn && ((next < 0) || (sim_timers[i].when < sim_timers[next].when))) {
+            next = i;
+        }
+    }
+    return next;
+}
+
+static void sim_clock (uint64_t ns) {
+    uint64_t t = ns * (SystemCoreClock / 1000000) + sim_mcycle_rem;
+
+    sim_mcycle += t / 1000;
+    sim_mcycle_rem = t % 1000;
+    sim_now += ns;
+}
+
+/**
+ * @brief  推进时间，依次处理期间到期的定时事件
+ */
+void sim_advance (uint64_t ns) {
+    uint64_t end = sim_now + ns;
+    sim_timer_fn fn;
+    void *arg;
+    int i;
+
+    while (((i = sim_timer_next()) >= 0) && (sim_timers[i].when <= end)) {
+        if (sim_timers[i].when > sim_now) {
+            sim_clock (sim_timers[i].when - sim_now);
+        }
+        fn = sim_timers[i].fn;
+        arg = sim_timers[i].arg;
+        sim_timers[i].fn = NULL;
+        sim_firing = 1;
+        fn (arg);
+        sim_firing = 0;
+    }
+    if (end > sim_now) {
+        sim_clock (end - sim_now);
+    }
+}
+
+//--------------------------中断------------------------------------
+void sim_irq_attach (int irqn, sim_irq_handler handler) {
+    sim_irq_handlers[irqn] = handler;
+}
+
+void sim_irq_raise (int irqn) {
+    sim_irq_pending[irqn] = 1;
+}
+
+static int sim_irq_next (void) {
+    int i;
+
+    for (i = 0; i < SIM_IRQ_MAX; i++) {
+        if (sim_irq_pending[i] && sim_irq_enabled[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void sim_irq_deliver (void) {
+    int irqn;
+
+    while (sim_irq_on && !sim_isr && !sim_firing && ((irqn = sim_irq_next()) >= 0)) {
+        sim_irq_pending[irqn] = 0;
+        if (sim_irq_handlers[irqn] == NULL) {
+            sim_error ("irq %d without handler", irqn);
+            continue;
+        }
+        sim_stats.irqs++;
+        sim_isr = 1;
+        sim_irq_on = 0;
+        sim_irq_handlers[irqn]();
+        sim_periph_service();  // 中断中重新装载的DMA
+        sim_irq_on = 1;
+        sim_isr = 0;
+    }
+}
+
+/**
+ * @brief  外设hook：服务外设模型，满足条件时进入中断
+ */
+void sim_step (void) {
+    if (sim_firing) {
+        return;
+    }
+    sim_periph_service();
+    sim_irq_deliver();
+}
+
+//--------------------------core_riscv.h------------------------------------
+void __enable_irq (void) {
+    if (!sim_isr) {
+        sim_irq_on = 1;
+    }
+    sim_step();
+}
+
+void __disable_irq (void) {
+    if (!sim_isr) {
+        sim_irq_on = 0;
+    }
+}
+
+void __NOP (void) {
+}
+
+uint32_t __get_MCYCLE (void) {
+    sim_step();
+    return (uint32_t)sim_mcycle;
+}
+
+uint32_t __get_MINSTRET (void) {
+    return (uint32_t)sim_mcycle;
+}
+
+void NVIC_EnableIRQ (IRQn_Type IRQn) {
+    sim_irq_enabled[IRQn] = 1;
+    sim_step();
+}
+
+void NVIC_DisableIRQ (IRQn_Type IRQn) {
+    sim_irq_enabled[IRQn] = 0;
+}
+
+uint32_t NVIC_GetStatusIRQ (IRQn_Type IRQn) {
+    return sim_irq_enabled[IRQn];
+}
+
+uint32_t NVIC_GetPendingIRQ (IRQn_Type IRQn) {
+    return sim_irq_pending[IRQn];
+}
+
+void NVIC_SetPendingIRQ (IRQn_Type IRQn) {
+    sim_irq_raise (IRQn);
+    sim_step();
+}
+
+void NVIC_ClearPendingIRQ (IRQn_Type IRQn) {
+    sim_irq_pending[IRQn] = 0;
+}
+
+void NVIC_SetPriority (IRQn_Type IRQn, uint8_t priority) {
+    (void)IRQn;
+    (void)priority;
+}
+
+/**
+ * @brief  休眠到有中断挂起；关中断时WFI同样被挂起的中断唤醒，打开中断后才进入
+ */
+void __WFI (void) {
+    int i;
+
+    if (sim_isr) {
+        sim_error ("WFI in interrupt");
+        return;
+    }
+    sim_stats.wfis++;
+    sim_periph_service();
+    while (sim_irq_next() < 0) {
+        i = sim_timer_next();
+        if (i < 0) {
+            fprintf (stderr, "sim: WFI with no pending event, firmware would sleep forever\n");
+            abort();
+        }
+        sim_advance ((sim_timers[i].when > sim_now) ? (sim_timers[i].when - sim_now) : 0);
+        sim_periph_service();
+    }
+    sim_irq_deliver();
+}
+
+void SetVTFIRQ (uint32_t addr, IRQn_Type IRQn, uint8_t num, FunctionalState NewState) {
+    (void)addr;
+    (void)num;
+    sim_irq_enabled[IRQn] = (NewState == ENABLE);
+}
+
+void NVIC_SystemReset (void) {
+    fprintf (stderr, "sim: NVIC_SystemReset\n");
+    abort();
+}
+
+//--------------------------日志串口------------------------------------
+void sim_uart_put (const uint8_t *data, uint32_t len) {
+    uint32_t n = len;
+
+    sim_stats.uart_bytes += len;
+    if (sim_uart_echo) {
+        fwrite (data, 1, len, stdout);
+    }
+    if (n > sizeof (sim_uart_buf) - 1 - sim_uart_len) {
+        n = sizeof (sim_uart_buf) - 1 - sim_uart_len;
+    }
+    memcpy (&sim_uart_buf[sim_uart_len], data, n);
+    sim_uart_len += n;
+    sim_uart_buf[sim_uart_len] = 0;
+}
+
+const char *sim_uart_text (void) {
+    return sim_uart_buf;
+}
+
+void sim_uart_clear (void) {
+    sim_uart_len = 0;
+    sim_uart_buf[0] = 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_iflash.h"
+#include "sim.h"
+#include "ch32v30x.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define SIM_IFLASH_LOCK     0x00000080  // CTLR.LOCK
+#define SIM_IFLASH_FLOCK    0x00008000  // CTLR.FLOCK
+
+sim_iflash_stats_t sim_iflash_stats;
+
+static uint8_t *sim_iflash;
+static uint8_t sim_iflash_erased[SIM_IFLASH_SIZE / SIM_IFLASH_PAGE];
+
+void sim_iflash_reset (void) {
+    void *p;
+
+    if (sim_iflash == NULL) {
+        p = mmap ((void *)FLASH_BASE, SIM_IFLASH_SIZE, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if (p != (void *)FLASH_BASE) {
+            perror ("sim: map internal flash");
+            abort();
+        }
+        sim_iflash = p;
+    }
+    memset (sim_iflash, 0xFF, SIM_IFLASH_SIZE);
+    memset (sim_iflash_erased, 1, sizeof (sim_iflash_erased));
+    memset (&sim_iflash_stats, 0, sizeof (sim_iflash_stats));
+    memset (&sim_FLASH, 0, sizeof (sim_FLASH));
+    sim_FLASH.CTLR = SIM_IFLASH_LOCK | SIM_IFLASH_FLOCK;
+}
+
+uint8_t *sim_iflash_mem (void) {
+    return sim_iflash;
+}
+
+/**
+ * @brief  重新上电：恢复掉电前保存的内容，全部为0xFF的页视为已擦除
+ */
+void sim_iflash_restore (const uint8_t *image) {
+    uint32_t i, k;
+
+    memcpy (sim_iflash, image, SIM_IFLASH_SIZE);
+    for (i = 0; i < SIM_IFLASH_SIZE / SIM_IFLASH_PAGE; i++) {
+        for (k = 0; (k < SIM_IFLASH_PAGE) && (image[i * SIM_IFLASH_PAGE + k] == 0xFF); k++) {
+        }
+        sim_iflash_erased[i] = (k == SIM_IFLASH_PAGE);
+    }
+}
+
+/**
+ * @brief  标准锁和快速模式锁都已设置
+ */
+uint8_t sim_iflash_locked (void) {
+    return (sim_FLASH.CTLR & (SIM_IFLASH_LOCK | SIM_IFLASH_FLOCK)) == (SIM_IFLASH_LOCK | SIM_IFLASH_FLOCK);
+}
+
+/* 检查地址和锁，返回相对偏移，错误时返回-1 */
+static int32_t sim_iflash_check (const char *op, uint32_t addr, uint32_t size) {
+    if ((addr < FLASH_BASE) || (addr - FLASH_BASE + size > SIM_IFLASH_SIZE) || (addr & (size - 1))) {
+        sim_error ("iflash: %s at 0x%08x", op, addr);
+        return -1;
+    }
+    if (sim_FLASH.CTLR & (SIM_IFLASH_LOCK | SIM_IFLASH_FLOCK)) {
+        sim_iflash_stats.locked_ops++;
+        sim_error ("iflash: %s at 0x%08x while locked", op, addr);
+        return -1;
+    }
+    return (int32_t)(addr - FLASH_BASE);
+}
+
+static void sim_iflash_busy (uint64_t ns) {
+    sim_iflash_stats.busy_ns += ns;
+    sim_advance (ns);
+    sim_step();
+}
+
+void FLASH_Unlock (void) {
+    sim_FLASH.CTLR &= ~SIM_IFLASH_LOCK;
+}
+
+void FLASH_Lock (void) {
+    sim_FLASH.CTLR |= SIM_IFLASH_LOCK;
+}
+
+void FLASH_Unlock_Fast (void) {
+    sim_FLASH.CTLR &= ~(SIM_IFLASH_LOCK | SIM_IFLASH_FLOCK);
+}
+
+void FLASH_Lock_Fast (void) {
+    sim_FLASH.CTLR |= SIM_IFLASH_FLOCK;
+}
+
+void FLASH_ErasePage_Fast (uint32_t Page_Address) {
+    int32_t off = sim_iflash_check ("page erase", Page_Address & ~(SIM_IFLASH_PAGE - 1), SIM_IFLASH_PAGE);
+
+    if (off < 0) {
+        return;
+    }
+    if (sim_power_check()) {
+        memset (&sim_iflash[off], 0xFF, SIM_IFLASH_PAGE / 2);
+        sim_power_off();
+    }
+    memset (&sim_iflash[off], 0xFF, SIM_IFLASH_PAGE);
+    sim_iflash_erased[off / SIM_IFLASH_PAGE] = 1;
+    sim_iflash_stats.page_erases++;
+    sim_iflash_busy (SIM_IFLASH_T_PE_NS);
+}
+
+void FLASH_EraseBlock_32K_Fast (uint32_t Block_Address) {
+    int32_t off = sim_iflash_check ("block erase", Block_Address & ~0x7FFFu, 0x8000);
+
+    if (off < 0) {
+        return;
+    }
+    if (sim_power_check()) {
+        memset (&sim_iflash[off], 0xFF, 0x8000 / 2);
+        sim_power_off();
+    }
+    memset (&sim_iflash[off], 0xFF, 0x8000);
+    memset (&sim_iflash_erased[off / SIM_IFLASH_PAGE], 1, 0x8000 / SIM_IFLASH_PAGE);
+    sim_iflash_stats.block_erases++;
+    sim_iflash_busy (SIM_IFLASH_T_BE32_NS);
+}
+
+void FLASH_ProgramPage_Fast (uint32_t Page_Address, uint32_t *pbuf) {
+    int32_t off = sim_iflash_check ("page program", Page_Address & ~(SIM_IFLASH_PAGE - 1), SIM_IFLASH_PAGE);
+
+    if (off < 0) {
+        return;
+    }
+    if (!sim_iflash_erased[off / SIM_IFLASH_PAGE]) {
+        sim_iflash_stats.dirty_programs++;
+        sim_error ("iflash: program 0x%08x without erase", Page_Address);
+    }
+    if (sim_power_check()) {
+        memcpy (&sim_iflash[off], pbuf, SIM_IFLASH_PAGE / 2);
+        sim_iflash_erased[off / SIM_IFLASH_PAGE] = 0;
+        sim_power_off();
+    }
+    memcpy (&sim_iflash[off], pbuf, SIM_IFLASH_PAGE);
+    sim_iflash_erased[off / SIM_IFLASH_PAGE] = 0;
+    sim_iflash_stats.page_programs++;
+    sim_iflash_busy (SIM_IFLASH_T_PP_NS);
+}
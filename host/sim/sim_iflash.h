@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SIM_IFLASH_H
+#define SIM_IFLASH_H
+
+#include <stdint.h>
+
+//--------------------------内部FLASH模型------------------------------------
+// 内部FLASH映射到主机的FLASH_BASE（0x08000000）处，固件可以直接读取APP区：
+// 1.快速模式擦除/编程要求LOCK和FLOCK都已清除（FLASH_Unlock_Fast()），否则记为错误，
+//   FLASH_Lock_Fast()只设置FLOCK，标准锁要另外FLASH_Lock()
+// 2.页编程前该页必须已擦除（按256Byte页记录擦除状态，不比较内容）
+// 3.擦除/编程期间CPU停顿，时间为估计值（手册未给出快速模式的典型时间），
+//   只用于比较不同方案，不代表实测
+//--------------------------------------------------------------------
+#define SIM_IFLASH_SIZE         0x40000
+#define SIM_IFLASH_PAGE         256
+#define SIM_IFLASH_T_PP_NS      (300 * 1000ULL)         // 256Byte页编程
+#define SIM_IFLASH_T_PE_NS      (3 * 1000 * 1000ULL)    // 256Byte页擦除
+#define SIM_IFLASH_T_BE32_NS    (15 * 1000 * 1000ULL)   // 32K块擦除
+
+typedef struct {
+    uint32_t page_programs;
+    uint32_t page_erases;
+    uint32_t block_erases;
+    uint32_t locked_ops;       // 未解锁时的擦除/编程
+    uint32_t dirty_programs;   // 编程未擦除的页
+    uint64_t busy_ns;          // 擦除/编程总时间
+} sim_iflash_stats_t;
+
+extern sim_iflash_stats_t sim_iflash_stats;
+
+void sim_iflash_reset(void);
+uint8_t *sim_iflash_mem(void);
+void sim_iflash_restore(const uint8_t *image);
+uint8_t sim_iflash_locked(void);
+
+#endif /* SIM_IFLASH_H */
@@ -0,0 +1,475 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim.h"
+#include "sim_w25q.h"
+#include "sim_iflash.h"
+#include "sim_usbd.h"
+#include "ch32v30x.h"
+#include <string.h>
+
+//--------------------------StdPeriph外设模型------------------------------------
+// 只实现固件用到的部分：
+// 1.SPI3接W25Q64模型，片选为PE6；轮询收发每字节推进8个SPI时钟加上软件开销，
+//   DMA2_CH1/CH2同时使能且SPI打开DMA请求后开始传输，整段结束时置TC并进入中断
+// 2.内存到内存DMA（CRC）在下一个hook处立即完成
+// 3.DEBUG串口DMA立即发出，内容进入sim_uart_put()，不计串口时间
+// 4.SysTick按CMP和时钟源周期触发
+//--------------------------------------------------------------------
+#define SIM_SPI_POLL_NS     150   // 轮询一个字节的软件开销（查标志、读写DATAR）
+#define SIM_W25Q_CS_PORT    GPIOE
+#define SIM_W25Q_CS_PIN     GPIO_Pin_6
+
+#define SIM_DMA_FLAG_DMA2   0x10000000
+
+RCC_TypeDef sim_RCC;
+GPIO_TypeDef sim_GPIO[5];
+SPI_TypeDef sim_SPI[3];
+USART_TypeDef sim_USART[3];
+DMA_TypeDef sim_DMA[2];
+DMA_Channel_TypeDef sim_DMA1_Channel[7];
+DMA_Channel_TypeDef sim_DMA2_Channel[11];
+CRC_TypeDef sim_CRC;
+FLASH_TypeDef sim_FLASH;
+BKP_TypeDef sim_BKP;
+PWR_TypeDef sim_PWR;
+
+/* 固件中的中断处理函数，测试没有链接对应模块时为NULL */
+extern void DMA2_Channel1_IRQHandler (void) __attribute__((weak));
+extern void SysTick_Handler (void) __attribute__((weak));
+
+static struct {
+    uint8_t rx;
+    uint8_t rx_valid;
+} sim_spi[3];
+
+static struct {
+    uint8_t active;
+    uint16_t n;
+} sim_spi_dma;
+
+static struct {
+    uint32_t ctlr;
+    uint64_t cmp;
+    uint64_t period;
+} sim_systick;
+
+static uint32_t sim_crc;
+
+//--------------------------工具------------------------------------
+static int sim_spi_index (SPI_TypeDef *SPIx) {
+    return (int)(SPIx - sim_SPI);
+}
+
+/* SPI一个字节的时间，PCLK1为HCLK/2 */
+static uint64_t sim_spi_byte_ns (SPI_TypeDef *SPIx) {
+    uint32_t div = 2u << ((SPIx->CTLR1 >> 3) & 7);
+
+    return 8ULL * div * 1000000000ULL / (SystemCoreClock / 2);
+}
+
+/* 通道在INTFR中的标志位置，返回所属DMA */
+static DMA_TypeDef *sim_dma_of (DMA_Channel_TypeDef *ch, uint32_t *shift) {
+    if ((ch >= sim_DMA1_Channel) && (ch < sim_DMA1_Channel + 7)) {
+        *shift = 4 * (uint32_t)(ch - sim_DMA1_Channel);
+        return &sim_DMA[0];
+    }
+    *shift = 4 * (uint32_t)(ch - sim_DMA2_Channel);
+    return &sim_DMA[1];
+}
+
+static void sim_dma_done (DMA_Channel_TypeDef *ch) {
+    uint32_t shift;
+    DMA_TypeDef *dma = sim_dma_of (ch, &shift);
+
+    ch->CNTR = 0;
+    dma->INTFR |= 0x3u << shift;  // GIF|TCIF
+}
+
+static void sim_crc_feed (uint32_t data) {
+    int i;
+
+    sim_crc ^= data;
+    for (i = 0; i < 32; i++) {
+        sim_crc = (sim_crc & 0x80000000) ? (sim_crc << 1) ^ 0x04C11DB7 : (sim_crc << 1);
+    }
+    sim_CRC.DATAR = sim_crc;
+}
+
+//--------------------------复位和服务------------------------------------
+void sim_periph_reset (void) {
+    memset (&sim_RCC, 0, sizeof (sim_RCC));
+    memset (sim_GPIO, 0, sizeof (sim_GPIO));
+    memset (sim_SPI, 0, sizeof (sim_SPI));
+    memset (sim_USART, 0, sizeof (sim_USART));
+    memset (sim_DMA, 0, sizeof (sim_DMA));
+    memset (sim_DMA1_Channel, 0, sizeof (sim_DMA1_Channel));
+    memset (sim_DMA2_Channel, 0, sizeof (sim_DMA2_Channel));
+    memset (&sim_CRC, 0, sizeof (sim_CRC));
+    memset (&sim_BKP, 0, sizeof (sim_BKP));
+    memset (&sim_PWR, 0, sizeof (sim_PWR));
+    memset (sim_spi, 0, sizeof (sim_spi));
+    memset (&sim_spi_dma, 0, sizeof (sim_spi_dma));
+    memset (&sim_systick, 0, sizeof (sim_systick));
+    sim_crc = 0xFFFFFFFF;
+    sim_CRC.DATAR = sim_crc;
+    sim_GPIO[4].OUTDR = SIM_W25Q_CS_PIN;
+    sim_w25q_reset();
+    sim_iflash_reset();
+    sim_usbd_reset();
+
+    sim_irq_attach (DMA2_Channel1_IRQn, DMA2_Channel1_IRQHandler);
+    sim_irq_attach (SysTicK_IRQn, SysTick_Handler);
+}
+
+/* SPI3 DMA一段传输结束：按配置交换数据，置RX通道TC */
+static void sim_spi_dma_done (void *arg) {
+    DMA_Channel_TypeDef *rx = DMA2_Channel1;
+    DMA_Channel_TypeDef *tx = DMA2_Channel2;
+    uint8_t *rxp = (uint8_t *)(uintptr_t)rx->MADDR;
+    const uint8_t *txp = (const uint8_t *)(uintptr_t)tx->MADDR;
+    uint32_t i;
+
+    (void)arg;
+    for (i = 0; i < sim_spi_dma.n; i++) {
+        uint8_t b = sim_w25q_xfer (*txp);
+
+        *rxp = b;
+        if (tx->CFGR & DMA_MemoryInc_Enable) {
+            txp++;
+        }
+        if (rx->CFGR & DMA_MemoryInc_Enable) {
+            rxp++;
+        }
+    }
+    sim_stats.spi_bytes += sim_spi_dma.n;
+    sim_stats.spi_dma_bytes += sim_spi_dma.n;
+    sim_stats.spi_dma_chunks++;
+    sim_spi_dma.active = 0;
+    tx->CNTR = 0;
+    sim_dma_done (tx);
+    sim_dma_done (rx);
+    if (rx->CFGR & DMA_IT_TC) {
+        sim_irq_raise (DMA2_Channel1_IRQn);
+    }
+}
+
+static void sim_spi_dma_service (void) {
+    DMA_Channel_TypeDef *rx = DMA2_Channel1;
+    DMA_Channel_TypeDef *tx = DMA2_Channel2;
+    uint16_t req = SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx;
+
+    if (sim_spi_dma.active || ((SPI3->CTLR2 & req) != req)) {
+        return;
+    }
+    if (!(rx->CFGR & DMA_CFGR1_EN) || !(tx->CFGR & DMA_CFGR1_EN) || !rx->CNTR || !tx->CNTR) {
+        return;
+    }
+    if (rx->CNTR != tx->CNTR) {
+        sim_error ("spi dma: rx count %u != tx count %u", rx->CNTR, tx->CNTR);
+    }
+    if (sim_GPIO[4].OUTDR & SIM_W25Q_CS_PIN) {
+        sim_error ("spi dma: started with flash deselected");
+    }
+    sim_spi_dma.active = 1;
+    sim_spi_dma.n = (uint16_t)rx->CNTR;
+    sim_timer_start (sim_spi_dma_done, NULL, sim_now + sim_spi_dma.n * sim_spi_byte_ns (SPI3));
+}
+
+/* 内存到内存DMA（CRC），以及外设为串口数据寄存器的发送DMA */
+static void sim_dma_channel_service (DMA_Channel_TypeDef *ch) {
+    uint32_t cfgr = ch->CFGR;
+    uint32_t i, n = ch->CNTR;
+
+    if (!(cfgr & DMA_CFGR1_EN) || !n) {
+        return;
+    }
+    if (cfgr & DMA_M2M_Enable) {
+        const uint32_t *src = (const uint32_t *)(uintptr_t)((cfgr & DMA_DIR_PeripheralDST) ? ch->MADDR : ch->PADDR);
+        uint32_t dst = (cfgr & DMA_DIR_PeripheralDST) ? ch->PADDR : ch->MADDR;
+
+        if (dst != (uint32_t)(uintptr_t)&sim_CRC.DATAR) {
+            sim_error ("dma: memory to memory only modelled into CRC");
+        } else {
+            for (i = 0; i < n; i++) {
+                sim_crc_feed (src[i]);
+            }
+        }
+        sim_dma_done (ch);
+    } else if ((cfgr & DMA_DIR_PeripheralDST) && (ch->PADDR == (uint32_t)(uintptr_t)&USART1->DATAR)) {
+        sim_uart_put ((const uint8_t *)(uintptr_t)ch->MADDR, n);
+        sim_dma_done (ch);
+    }
+}
+
+static void sim_systick_fire (void *arg) {
+    (void)arg;
+    SysTick->SR = 1;
+    if (SysTick->CTLR & (1 << 1)) {
+        sim_irq_raise (SysTicK_IRQn);
+    }
+    sim_timer_start (sim_systick_fire, NULL, sim_now + sim_systick.period);
+}
+
+static void sim_systick_service (void) {
+    uint64_t clk;
+
+    if ((SysTick->CTLR == sim_systick.ctlr) && (SysTick->CMP == sim_systick.cmp)) {
+        return;
+    }
+    sim_systick.ctlr = SysTick->CTLR;
+    sim_systick.cmp = SysTick->CMP;
+    sim_timer_stop (sim_systick_fire, NULL);
+    if (!(SysTick->CTLR & 1)) {
+        return;
+    }
+    clk = (SysTick->CTLR & (1 << 2)) ? SystemCoreClock : SystemCoreClock / 8;
+    sim_systick.period = (SysTick->CMP + 1) * 1000000000ULL / clk;
+    sim_timer_start (sim_systick_fire, NULL, sim_now + sim_systick.period);
+}
+
+void sim_periph_service (void) {
+    int i;
+
+    sim_spi_dma_service();
+    for (i = 0; i < 7; i++) {
+        sim_dma_channel_service (&sim_DMA1_Channel[i]);
+    }
+    for (i = 2; i < 11; i++) {
+        sim_dma_channel_service (&sim_DMA2_Channel[i]);
+    }
+    sim_systick_service();
+}
+
+//--------------------------RCC/GPIO------------------------------------
+void RCC_AHBPeriphClockCmd (uint32_t RCC_AHBPeriph, FunctionalState NewState) {
+    sim_RCC.AHBPCENR = NewState ? (sim_RCC.AHBPCENR | RCC_AHBPeriph) : (sim_RCC.AHBPCENR & ~RCC_AHBPeriph);
+}
+
+void RCC_APB2PeriphClockCmd (uint32_t RCC_APB2Periph, FunctionalState NewState) {
+    sim_RCC.APB2PCENR = NewState ? (sim_RCC.APB2PCENR | RCC_APB2Periph) : (sim_RCC.APB2PCENR & ~RCC_APB2Periph);
+}
+
+void RCC_APB1PeriphClockCmd (uint32_t RCC_APB1Periph, FunctionalState NewState) {
+    sim_RCC.APB1PCENR = NewState ? (sim_RCC.APB1PCENR | RCC_APB1Periph) : (sim_RCC.APB1PCENR & ~RCC_APB1Periph);
+}
+
+void GPIO_Init (GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct) {
+    (void)GPIOx;
+    (void)GPIO_InitStruct;
+}
+
+static void sim_gpio_out (GPIO_TypeDef *GPIOx, uint16_t pins, uint8_t level) {
+    sim_step();
+    GPIOx->OUTDR = level ? (GPIOx->OUTDR | pins) : (GPIOx->OUTDR & ~pins);
+    if ((GPIOx == SIM_W25Q_CS_PORT) && (pins & SIM_W25Q_CS_PIN)) {
+        if (level && sim_spi_dma.active) {
+            sim_error ("spi: flash deselected during dma");
+        }
+        sim_w25q_cs (level);
+    }
+}
+
+void GPIO_SetBits (GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    sim_gpio_out (GPIOx, GPIO_Pin, 1);
+}
+
+void GPIO_ResetBits (GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    sim_gpio_out (GPIOx, GPIO_Pin, 0);
+}
+
+void GPIO_WriteBit (GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, BitAction BitVal) {
+    sim_gpio_out (GPIOx, GPIO_Pin, BitVal != Bit_RESET);
+}
+
+uint8_t GPIO_ReadOutputDataBit (GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    return (GPIOx->OUTDR & GPIO_Pin) ? 1 : 0;
+}
+
+//--------------------------SPI------------------------------------
+void SPI_Init (SPI_TypeDef *SPIx, SPI_InitTypeDef *SPI_InitStruct) {
+    SPIx->CTLR1 = (SPIx->CTLR1 & 0x3040) | SPI_InitStruct->SPI_Direction | SPI_InitStruct->SPI_Mode |
+                  SPI_InitStruct->SPI_DataSize | SPI_InitStruct->SPI_CPOL | SPI_InitStruct->SPI_CPHA |
+                  SPI_InitStruct->SPI_NSS | SPI_InitStruct->SPI_BaudRatePrescaler | SPI_InitStruct->SPI_FirstBit;
+}
+
+void SPI_Cmd (SPI_TypeDef *SPIx, FunctionalState NewState) {
+    SPIx->CTLR1 = NewState ? (SPIx->CTLR1 | 0x0040) : (SPIx->CTLR1 & ~0x0040);
+}
+
+void SPI_I2S_DMACmd (SPI_TypeDef *SPIx, uint16_t SPI_I2S_DMAReq, FunctionalState NewState) {
+    SPIx->CTLR2 = NewState ? (SPIx->CTLR2 | SPI_I2S_DMAReq) : (SPIx->CTLR2 & ~SPI_I2S_DMAReq);
+    sim_step();
+}
+
+/* 收发是同步完成的：TXE总是置位，RXNE在SendData之后置位 */
+FlagStatus SPI_I2S_GetFlagStatus (SPI_TypeDef *SPIx, uint16_t SPI_I2S_FLAG) {
+    int i = sim_spi_index (SPIx);
+    uint16_t statr = SPI_I2S_FLAG_TXE;
+
+    sim_step();
+    if (sim_spi[i].rx_valid) {
+        statr |= SPI_I2S_FLAG_RXNE;
+    }
+    if ((SPIx == SPI3) && sim_spi_dma.active) {
+        statr |= SPI_I2S_FLAG_BSY;
+    }
+    return (statr & SPI_I2S_FLAG) ? SET : RESET;
+}
+
+void SPI_I2S_SendData (SPI_TypeDef *SPIx, uint16_t Data) {
+    int i = sim_spi_index (SPIx);
+
+    sim_step();
+    if (!(SPIx->CTLR1 & 0x0040)) {
+        sim_error ("spi%d: send while disabled", i + 1);
+    }
+    if ((SPIx == SPI3) && sim_spi_dma.active) {
+        sim_error ("spi: polled transfer during dma");
+    }
+    sim_spi[i].rx = (SPIx == SPI3) ? sim_w25q_xfer ((uint8_t)Data) : 0xFF;
+    sim_spi[i].rx_valid = 1;
+    sim_stats.spi_bytes++;
+    sim_advance (sim_spi_byte_ns (SPIx) + SIM_SPI_POLL_NS);
+}
+
+uint16_t SPI_I2S_ReceiveData (SPI_TypeDef *SPIx) {
+    int i = sim_spi_index (SPIx);
+
+    sim_spi[i].rx_valid = 0;
+    SPIx->DATAR = sim_spi[i].rx;
+    return sim_spi[i].rx;
+}
+
+//--------------------------DMA------------------------------------
+void DMA_DeInit (DMA_Channel_TypeDef *DMAy_Channelx) {
+    uint32_t shift;
+    DMA_TypeDef *dma = sim_dma_of (DMAy_Channelx, &shift);
+
+    DMAy_Channelx->CFGR = 0;
+    DMAy_Channelx->CNTR = 0;
+    DMAy_Channelx->PADDR = 0;
+    DMAy_Channelx->MADDR = 0;
+    dma->INTFR &= ~(0xFu << shift);
+}
+
+void DMA_Init (DMA_Channel_TypeDef *DMAy_Channelx, DMA_InitTypeDef *DMA_InitStruct) {
+    DMAy_Channelx->CFGR = (DMAy_Channelx->CFGR & 0xF) | DMA_InitStruct->DMA_DIR | DMA_InitStruct->DMA_Mode |
+                          DMA_InitStruct->DMA_PeripheralInc | DMA_InitStruct->DMA_MemoryInc |
+                          DMA_InitStruct->DMA_PeripheralDataSize | DMA_InitStruct->DMA_MemoryDataSize |
+                          DMA_InitStruct->DMA_Priority | DMA_InitStruct->DMA_M2M;
+    DMAy_Channelx->CNTR = DMA_InitStruct->DMA_BufferSize;
+    DMAy_Channelx->PADDR = DMA_InitStruct->DMA_PeripheralBaseAddr;
+    DMAy_Channelx->MADDR = DMA_InitStruct->DMA_MemoryBaseAddr;
+}
+
+void DMA_Cmd (DMA_Channel_TypeDef *DMAy_Channelx, FunctionalState NewState) {
+    DMAy_Channelx->CFGR = NewState ? (DMAy_Channelx->CFGR | DMA_CFGR1_EN) : (DMAy_Channelx->CFGR & ~DMA_CFGR1_EN);
+    sim_step();
+}
+
+void DMA_ITConfig (DMA_Channel_TypeDef *DMAy_Channelx, uint32_t DMA_IT, FunctionalState NewState) {
+    DMAy_Channelx->CFGR = NewState ? (DMAy_Channelx->CFGR | DMA_IT) : (DMAy_Channelx->CFGR & ~DMA_IT);
+}
+
+FlagStatus DMA_GetFlagStatus (uint32_t DMAy_FLAG) {
+    DMA_TypeDef *dma = (DMAy_FLAG & SIM_DMA_FLAG_DMA2) ? &sim_DMA[1] : &sim_DMA[0];
+
+    sim_step();
+    return (dma->INTFR & DMAy_FLAG & ~SIM_DMA_FLAG_DMA2) ? SET : RESET;
+}
+
+void DMA_ClearFlag (uint32_t DMAy_FLAG) {
+    DMA_TypeDef *dma = (DMAy_FLAG & SIM_DMA_FLAG_DMA2) ? &sim_DMA[1] : &sim_DMA[0];
+
+    dma->INTFR &= ~(DMAy_FLAG & ~SIM_DMA_FLAG_DMA2);
+}
+
+ITStatus DMA_GetITStatus (uint32_t DMAy_IT) {
+    return DMA_GetFlagStatus (DMAy_IT);
+}
+
+void DMA_ClearITPendingBit (uint32_t DMAy_IT) {
+    DMA_ClearFlag (DMAy_IT);
+}
+
+//--------------------------USART------------------------------------
+void USART_DMACmd (USART_TypeDef *USARTx, uint16_t USART_DMAReq, FunctionalState NewState) {
+    USARTx->CTLR3 = NewState ? (USARTx->CTLR3 | USART_DMAReq) : (USARTx->CTLR3 & ~USART_DMAReq);
+}
+
+FlagStatus USART_GetFlagStatus (USART_TypeDef *USARTx, uint16_t USART_FLAG) {
+    (void)USARTx;
+    (void)USART_FLAG;
+    sim_step();
+    return SET;
+}
+
+void USART_SendData (USART_TypeDef *USARTx, uint16_t Data) {
+    uint8_t c = (uint8_t)Data;
+
+    (void)USARTx;
+    sim_uart_put (&c, 1);
+}
+
+//--------------------------CRC------------------------------------
+void CRC_ResetDR (void) {
+    sim_crc = 0xFFFFFFFF;
+    sim_CRC.DATAR = sim_crc;
+}
+
+uint32_t CRC_CalcCRC (uint32_t Data) {
+    sim_crc_feed (Data);
+    return sim_crc;
+}
+
+uint32_t CRC_CalcBlockCRC (uint32_t pBuffer[], uint32_t BufferLength) {
+    uint32_t i;
+
+    for (i = 0; i < BufferLength; i++) {
+        sim_crc_feed (pBuffer[i]);
+    }
+    return sim_crc;
+}
+
+uint32_t CRC_GetCRC (void) {
+    return sim_crc;
+}
+
+//--------------------------NVIC/延时/调试串口------------------------------------
+void NVIC_PriorityGroupConfig (uint32_t NVIC_PriorityGroup) {
+    (void)NVIC_PriorityGroup;
+}
+
+void NVIC_Init (NVIC_InitTypeDef *NVIC_InitStruct) {
+    if (NVIC_InitStruct->NVIC_IRQChannelCmd != DISABLE) {
+        NVIC_EnableIRQ ((IRQn_Type)NVIC_InitStruct->NVIC_IRQChannel);
+    } else {
+        NVIC_DisableIRQ ((IRQn_Type)NVIC_InitStruct->NVIC_IRQChannel);
+    }
+}
+
+void SystemCoreClockUpdate (void) {
+}
+
+void Delay_Init (void) {
+}
+
+void Delay_Us (uint32_t n) {
+    sim_advance (n * SIM_NS_PER_US);
+    sim_step();
+}
+
+void Delay_Ms (uint32_t n) {
+    sim_advance (n * SIM_NS_PER_MS);
+    sim_step();
+}
+
+void USART_Printf_Init (uint32_t baudrate) {
+    (void)baudrate;
+}
+
+void USART_Printf_Update (void) {
+}
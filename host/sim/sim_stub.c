@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim.h"
+#include "ch32v30x.h"
+#include "ry_clock.h"
+#include "ry_prof.h"
+#include "ry_log.h"
+#include "ry_event.h"
+#include <string.h>
+
+//--------------------------固件模块替代------------------------------------
+// 不能在主机上编译的模块，按相同接口实现：
+// ry_clock.c：轮询RCC就绪位切换PLL，这里只改变SystemCoreClock（SPI、SysTick时间随之改变）
+// ry_prof.c：RISC-V内联汇编和链接脚本符号，栈峰值取sim_run()的仿真栈，静态RAM不统计
+//--------------------------------------------------------------------
+#define SIM_CLOCK_BOOST     144000000
+
+void ry_clock_set (ry_clock_profile profile) {
+    if (profile == ry_clock_get()) {
+        return;
+    }
+    ry_log_flush();
+    SystemCoreClock = (profile == RY_CLOCK_BOOST) ? SIM_CLOCK_BOOST : 96000000;
+    ry_event_tick_update();
+}
+
+/* 按SystemCoreClock判断，sim_reset()恢复96MHz后一致 */
+ry_clock_profile ry_clock_get (void) {
+    return (SystemCoreClock == SIM_CLOCK_BOOST) ? RY_CLOCK_BOOST : RY_CLOCK_NORMAL;
+}
+
+void ry_prof_record (ry_prof_site site, uint32_t cycles) {
+    (void)site;
+    (void)cycles;
+}
+
+void ry_prof_stack_paint (void) {
+}
+
+uint32_t ry_prof_stack_peak (void) {
+    return sim_stack_peak();
+}
+
+uint32_t ry_prof_static_ram (void) {
+    return 0;
+}
+
+void ry_prof_snapshot (ry_prof_stat *stats) {
+    memset (stats, 0, sizeof (ry_prof_stat) * RY_PROF_SITE_NUM);
+}
+
+void ry_prof_reset (void) {
+}
+
+void ry_prof_dump (void) {
+}
+
+uint32_t ry_prof_report (uint8_t *buf) {
+    memset (buf, 0, RY_PROF_REPORT_SIZE);
+    return RY_PROF_REPORT_SIZE;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SIM_TEST_H
+#define SIM_TEST_H
+
+#include <stdio.h>
+#include "sim.h"
+
+/* 每个测试程序一个计数，main()返回它作为ctest/make的结果 */
+static int sim_test_failures;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            sim_test_failures++;                                                    \
+            fprintf (stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                  \
+    do {                                                                                \
+        unsigned long long check_a = (unsigned long long)(a);                           \
+        unsigned long long check_b = (unsigned long long)(b);                           \
+        if (check_a != check_b) {                                                       \
+            sim_test_failures++;                                                        \
+            fprintf (stderr, "%s:%d: %s == %s failed: 0x%llx != 0x%llx\n", __FILE__,    \
+                     __LINE__, #a, #b, check_a, check_b);                               \
+        }                                                                               \
+    } while (0)
+
+/* 在仿真栈上运行body，结束时检查模型没有报告错误 */
+static inline int sim_test_run (const char *name, void (*body)(void)) {
+    sim_reset();
+    sim_run (body);
+    CHECK_EQ (sim_stats.errors, 0);
+    fprintf (stderr, "%s: %s\n", name, sim_test_failures ? "FAIL" : "ok");
+    return sim_test_failures ? 1 : 0;
+}
+
+#endif /* SIM_TEST_H */
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_usbd.h"
+#include "ch32v30x.h"
+#include "usbd_core.h"
+#include "usbd_hid.h"
+#include <string.h>
+
+/* 固件中的USB事件处理（hid_custom.c），测试没有链接时为NULL */
+extern void usbd_event_handler (uint8_t event) __attribute__((weak));
+
+typedef struct {
+    usbd_endpoint_callback cb;
+    uint8_t addr;
+    uint8_t busy;        // 设备已启动传输
+    uint8_t done;        // 传输完成，等待中断处理
+    uint8_t *buf;
+    uint32_t len;
+    uint32_t nbytes;
+    uint64_t period;
+    uint64_t next;       // 下一次可以传输的时间
+} sim_usbd_ep_t;
+
+typedef struct {
+    uint8_t data[SIM_USBD_QUEUE][SIM_USBD_PACKET_MAX];
+    uint32_t len[SIM_USBD_QUEUE];
+    uint32_t head;
+    uint32_t tail;
+} sim_usbd_queue_t;
+
+sim_usbd_stats_t sim_usbd_stats;
+
+static sim_usbd_ep_t sim_usbd_eps[2][SIM_USBD_EP_NUM];  // [0]:OUT [1]:IN
+static sim_usbd_queue_t sim_usbd_queues[SIM_USBD_EP_NUM];
+static sim_usbd_in_fn sim_usbd_in_cb;
+static uint8_t sim_usbd_enum_pending;
+static uint8_t sim_usbd_enum_done;
+static uint8_t sim_usbd_intf_num;
+
+static sim_usbd_ep_t *sim_usbd_ep (uint8_t ep) {
+    return &sim_usbd_eps[(ep & 0x80) ? 1 : 0][ep & (SIM_USBD_EP_NUM - 1)];
+}
+
+static void sim_usbd_irq (void) {
+    uint8_t dir, i;
+    sim_usbd_ep_t *e;
+
+    if (sim_usbd_enum_pending) {
+        sim_usbd_enum_pending = 0;
+        sim_usbd_enum_done = 1;
+        if (usbd_event_handler) {
+            usbd_event_handler (USBD_EVENT_CONFIGURED);
+        }
+    }
+    for (dir = 0; dir < 2; dir++) {
+        for (i = 0; i < SIM_USBD_EP_NUM; i++) {
+            e = &sim_usbd_eps[dir][i];
+            if (!e->done) {
+                continue;
+            }
+            e->done = 0;
+            if (e->cb) {
+                e->cb (e->addr, e->nbytes);
+            } else {
+                sim_error ("ep %02x without callback", e->addr);
+            }
+        }
+    }
+}
+
+/**
+ * @brief  复位控制器和主机队列，由sim_periph_reset()调用
+ */
+void sim_usbd_reset (void) {
+    uint8_t dir, i;
+
+    memset (&sim_usbd_stats, 0, sizeof (sim_usbd_stats));
+    memset (sim_usbd_eps, 0, sizeof (sim_usbd_eps));
+    for (i = 0; i < SIM_USBD_EP_NUM; i++) {
+        sim_usbd_queues[i].head = 0;
+        sim_usbd_queues[i].tail = 0;
+        for (dir = 0; dir < 2; dir++) {
+            sim_usbd_eps[dir][i].addr = i | (dir ? 0x80 : 0);
+            sim_usbd_eps[dir][i].period = SIM_USBD_BULK_NS;
+        }
+    }
+    sim_usbd_in_cb = NULL;
+    sim_usbd_enum_pending = 0;
+    sim_usbd_enum_done = 0;
+    sim_usbd_intf_num = 0;
+    sim_irq_attach (USBHS_IRQn, sim_usbd_irq);
+}
+
+void sim_usbd_period (uint8_t ep, uint64_t ns) {
+    sim_usbd_ep (ep)->period = ns;
+}
+
+/**
+ * @brief  主机收到IN数据的回调，在定时事件中调用，不能调用固件函数
+ */
+void sim_usbd_host_in (sim_usbd_in_fn fn) {
+    sim_usbd_in_cb = fn;
+}
+
+uint8_t sim_usbd_configured (void) {
+    return sim_usbd_enum_done;
+}
+
+//--------------------------传输------------------------------------
+static void sim_usbd_complete (sim_usbd_ep_t *e, uint32_t nbytes) {
+    e->busy = 0;
+    e->done = 1;
+    e->nbytes = nbytes;
+    e->next = sim_now + e->period;
+    sim_irq_raise (USBHS_IRQn);
+}
+
+static void sim_usbd_out_xfer (void *arg) {
+    sim_usbd_ep_t *e = arg;
+    sim_usbd_queue_t *q = &sim_usbd_queues[e->addr & (SIM_USBD_EP_NUM - 1)];
+    uint32_t n;
+
+    if (!e->busy || (q->head == q->tail)) {
+        return;
+    }
+    n = q->len[q->tail % SIM_USBD_QUEUE];
+    if (n > e->len) {
+        sim_error ("ep %02x packet %u > buffer %u", e->addr, n, e->len);
+        n = e->len;
+    }
+    memcpy (e->buf, q->data[q->tail % SIM_USBD_QUEUE], n);
+    q->tail++;
+    sim_usbd_stats.out_packets++;
+    sim_usbd_complete (e, n);
+}
+
+/* 设备已使能接收且主机有包时，在端点的下一个周期传输 */
+static void sim_usbd_out_kick (sim_usbd_ep_t *e) {
+    sim_usbd_queue_t *q = &sim_usbd_queues[e->addr & (SIM_USBD_EP_NUM - 1)];
+
+    if (e->busy && (q->head != q->tail)) {
+        sim_timer_start (sim_usbd_out_xfer, e, (e->next > sim_now) ? e->next : sim_now);
+    }
+}
+
+static void sim_usbd_in_xfer (void *arg) {
+    sim_usbd_ep_t *e = arg;
+
+    if (!e->busy) {
+        return;
+    }
+    sim_usbd_stats.in_packets++;
+    if (sim_usbd_in_cb) {
+        sim_usbd_in_cb (e->addr, e->buf, e->len);
+    }
+    sim_usbd_complete (e, e->len);
+}
+
+/**
+ * @brief  主机发送一包，进入端点队列
+ * @retval 0:队列满
+ */
+uint8_t sim_usbd_out (uint8_t ep, const uint8_t *data, uint32_t len) {
+    sim_usbd_queue_t *q = &sim_usbd_queues[ep & (SIM_USBD_EP_NUM - 1)];
+
+    if ((q->head - q->tail >= SIM_USBD_QUEUE) || (len > SIM_USBD_PACKET_MAX)) {
+        return 0;
+    }
+    memcpy (q->data[q->head % SIM_USBD_QUEUE], data, len);
+    q->len[q->head % SIM_USBD_QUEUE] = len;
+    q->head++;
+    sim_usbd_out_kick (sim_usbd_ep (ep));
+    return 1;
+}
+
+/**
+ * @brief  交换队列中最后两包的顺序（乱序注入），不足两包时不处理
+ */
+void sim_usbd_out_swap (uint8_t ep) {
+    sim_usbd_queue_t *q = &sim_usbd_queues[ep & (SIM_USBD_EP_NUM - 1)];
+    uint8_t tmp[SIM_USBD_PACKET_MAX];
+    uint32_t a, b, n;
+
+    if (q->head - q->tail < 2) {
+        return;
+    }
+    a = (q->head - 2) % SIM_USBD_QUEUE;
+    b = (q->head - 1) % SIM_USBD_QUEUE;
+    memcpy (tmp, q->data[a], q->len[a]);
+    memcpy (q->data[a], q->data[b], q->len[b]);
+    memcpy (q->data[b], tmp, q->len[a]);
+    n = q->len[a];
+    q->len[a] = q->len[b];
+    q->len[b] = n;
+}
+
+uint32_t sim_usbd_out_queued (uint8_t ep) {
+    sim_usbd_queue_t *q = &sim_usbd_queues[ep & (SIM_USBD_EP_NUM - 1)];
+
+    return q->head - q->tail;
+}
+
+/**
+ * @brief  丢弃主机侧未发出的包（主机中止传输）
+ */
+void sim_usbd_out_flush (uint8_t ep) {
+    sim_usbd_queue_t *q = &sim_usbd_queues[ep & (SIM_USBD_EP_NUM - 1)];
+
+    q->tail = q->head;
+}
+
+//--------------------------CherryUSB接口------------------------------------
+void usbd_desc_register (const uint8_t *desc) {
+    (void)desc;
+}
+
+void usbd_msosv2_desc_register (struct usb_msosv2_descriptor *desc) {
+    (void)desc;
+}
+
+void usbd_bos_desc_register (struct usb_bos_descriptor *desc) {
+    (void)desc;
+}
+
+struct usbd_interface *usbd_hid_init_intf (uint8_t busid, struct usbd_interface *intf, const uint8_t *desc, uint32_t desc_len) {
+    (void)busid;
+    intf->hid_report_descriptor = desc;
+    intf->hid_report_descriptor_len = desc_len;
+    return intf;
+}
+
+void usbd_add_interface (struct usbd_interface *intf) {
+    intf->intf_num = sim_usbd_intf_num++;
+}
+
+void usbd_add_endpoint (struct usbd_endpoint *ep) {
+    sim_usbd_ep (ep->ep_addr)->cb = ep->ep_cb;
+}
+
+static void sim_usbd_enum (void *arg) {
+    (void)arg;
+    sim_usbd_enum_pending = 1;
+    sim_irq_raise (USBHS_IRQn);
+}
+
+/**
+ * @brief  打开USB中断，SIM_USBD_ENUM_NS后主机完成枚举
+ */
+int usbd_initialize (void) {
+    NVIC_EnableIRQ (USBHS_IRQn);
+    sim_timer_start (sim_usbd_enum, NULL, sim_now + SIM_USBD_ENUM_NS);
+    return 0;
+}
+
+int usbd_ep_start_read (const uint8_t ep, uint8_t *data, uint32_t data_len) {
+    sim_usbd_ep_t *e = sim_usbd_ep (ep);
+
+    if (e->busy) {
+        sim_error ("ep %02x read while busy", ep);
+        return -1;
+    }
+    e->busy = 1;
+    e->buf = data;
+    e->len = data_len;
+    sim_usbd_out_kick (e);
+    return 0;
+}
+
+int usbd_ep_start_write (const uint8_t ep, const uint8_t *data, uint32_t data_len) {
+    sim_usbd_ep_t *e = sim_usbd_ep (ep);
+
+    if (e->busy || e->done) {
+        sim_error ("ep %02x write while busy", ep);
+        return -1;
+    }
+    e->busy = 1;
+    e->buf = (uint8_t *)data;
+    e->len = data_len;
+    sim_timer_start (sim_usbd_in_xfer, e, (e->next > sim_now) ? e->next : sim_now);
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SIM_USBD_H
+#define SIM_USBD_H
+
+#include "sim.h"
+
+//--------------------------USB设备控制器------------------------------------
+// 代替CherryUSB的usbd_core和ch32 port，只实现hid_custom.c用到的接口：
+// 1.usbd_initialize()后SIM_USBD_ENUM_NS枚举完成，在USB中断中调用usbd_event_handler(CONFIGURED)
+// 2.主机的OUT包进入端点队列，设备usbd_ep_start_read()之后按端点周期传输一包，
+//   没有使能接收时主机的包留在队列中（控制器回复NAK）
+// 3.usbd_ep_start_write()的数据在下一个IN周期交给主机回调，端点忙时再次启动记为错误
+// 4.传输完成时在USB中断中调用端点回调，与固件中USBHS_IRQHandler的上下文一致
+// 端点周期默认为bulk（SIM_USBD_BULK_NS），HID中断端点由测试按bInterval设置
+//--------------------------------------------------------------------
+#define SIM_USBD_EP_NUM         8
+#define SIM_USBD_QUEUE          32      // 每个OUT端点主机侧排队的包数
+#define SIM_USBD_PACKET_MAX     1024
+#define SIM_USBD_ENUM_NS        (50 * SIM_NS_PER_MS)
+#define SIM_USBD_BULK_NS        (20 * SIM_NS_PER_US)    // 1024Byte，HS bulk约50MB/s
+#define SIM_USBD_HID_NS         (1 * SIM_NS_PER_MS)     // HS bInterval=4：2^(4-1)*125us
+
+typedef void (*sim_usbd_in_fn)(uint8_t ep, const uint8_t *data, uint32_t len);
+
+typedef struct {
+    uint32_t out_packets;     // 设备收到的包
+    uint32_t in_packets;      // 主机收到的包
+} sim_usbd_stats_t;
+
+extern sim_usbd_stats_t sim_usbd_stats;
+
+void sim_usbd_reset(void);
+void sim_usbd_period(uint8_t ep, uint64_t ns);
+void sim_usbd_host_in(sim_usbd_in_fn fn);
+uint8_t sim_usbd_configured(void);
+
+uint8_t sim_usbd_out(uint8_t ep, const uint8_t *data, uint32_t len);
+void sim_usbd_out_swap(uint8_t ep);
+uint32_t sim_usbd_out_queued(uint8_t ep);
+void sim_usbd_out_flush(uint8_t ep);
+
+#endif /* SIM_USBD_H */
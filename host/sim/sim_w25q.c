@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_w25q.h"
+#include "sim.h"
+#include <string.h>
+
+uint8_t sim_w25q_mem[SIM_W25Q_SIZE];
+sim_w25q_stats_t sim_w25q_stats;
+
+static uint8_t w25q_sfdp[256];
+static uint32_t w25q_sfdp_len;
+static uint8_t w25q_id[3];
+
+static struct {
+    uint8_t selected;
+    uint8_t wel;
+    uint64_t busy_until;
+    uint32_t idx;        // 本次片选内的字节序号
+    uint8_t cmd;
+    uint8_t ignored;     // 忙期间的命令，其余字节忽略
+    uint32_t addr;
+    uint8_t page[256];   // 页编程数据，片选拉高时写入
+    uint32_t fill;
+} w25q;
+
+void sim_w25q_reset (void) {
+    memset (sim_w25q_mem, 0xFF, sizeof (sim_w25q_mem));
+    memset (&sim_w25q_stats, 0, sizeof (sim_w25q_stats));
+    memset (&w25q, 0, sizeof (w25q));
+    w25q_sfdp_len = 0;
+    sim_w25q_id (0xEF, 0x40, 0x17);  // W25Q64JV-IQ
+}
+
+/**
+ * @brief  设置SFDP区内容（从地址0开始），len为0表示不支持SFDP
+ */
+void sim_w25q_sfdp (const uint8_t *table, uint32_t len) {
+    if (len > sizeof (w25q_sfdp)) {
+        len = sizeof (w25q_sfdp);
+    }
+    memcpy (w25q_sfdp, table, len);
+    w25q_sfdp_len = len;
+}
+
+void sim_w25q_id (uint8_t manufacturer, uint8_t type, uint8_t capacity) {
+    w25q_id[0] = manufacturer;
+    w25q_id[1] = type;
+    w25q_id[2] = capacity;
+}
+
+uint8_t sim_w25q_busy (void) {
+    return sim_now < w25q.busy_until;
+}
+
+static uint8_t w25q_write_start (void) {
+    if (!w25q.wel) {
+        sim_w25q_stats.unlatched++;
+        sim_error ("w25q: cmd %02x without write enable", w25q.cmd);
+        return 0;
+    }
+    w25q.wel = 0;
+    return 1;
+}
+
+static void w25q_erase (uint32_t size, uint64_t t) {
+    uint32_t base = w25q.addr & ~(size - 1) & (SIM_W25Q_SIZE - 1);
+
+    if (sim_power_check()) {
+        memset (&sim_w25q_mem[base], 0xFF, size / 2);  // 擦除中途掉电
+        sim_power_off();
+    }
+    memset (&sim_w25q_mem[base], 0xFF, size);
+    w25q.busy_until = sim_now + t;
+}
+
+/* 片选拉高：执行编程/擦除 */
+static void w25q_finish (void) {
+    uint32_t i, a, base, n;
+
+    if (w25q.ignored) {
+        return;
+    }
+    switch (w25q.cmd) {
+    case 0x02:
+        if ((w25q.idx < 4) || (w25q.fill == 0) || !w25q_write_start()) {
+            break;
+        }
+        base = w25q.addr & ~0xFFu & (SIM_W25Q_SIZE - 1);
+        for (i = 0; i < w25q.fill; i++) {
+            a = base + ((w25q.addr + i) & 0xFF);
+            if (w25q.page[i] & ~sim_w25q_mem[a]) {
+                sim_w25q_stats.dirty_programs++;
+                sim_error ("w25q: program 0x%06x over unerased data", a);
+                break;
+            }
+        }
+        n = sim_power_check() ? w25q.fill / 2 : w25q.fill;  // 编程中途掉电只写入前一半
+        for (i = 0; i < n; i++) {
+            sim_w25q_mem[base + ((w25q.addr + i) & 0xFF)] &= w25q.page[i];
+        }
+        if (n < w25q.fill) {
+            sim_power_off();
+        }
+        sim_w25q_stats.page_programs++;
+        sim_w25q_stats.program_bytes += w25q.fill;
+        w25q.busy_until = sim_now + SIM_W25Q_T_PP_NS;
+        break;
+
+    case 0x20:
+        if ((w25q.idx == 4) && w25q_write_start()) {
+            sim_w25q_stats.erase_4k++;
+            w25q_erase (0x1000, SIM_W25Q_T_SE_NS);
+        }
+        break;
+
+    case 0x52:
+        if ((w25q.idx == 4) && w25q_write_start()) {
+            sim_w25q_stats.erase_32k++;
+            w25q_erase (0x8000, SIM_W25Q_T_BE32_NS);
+        }
+        break;
+
+    case 0xD8:
+        if ((w25q.idx == 4) && w25q_write_start()) {
+            sim_w25q_stats.erase_64k++;
+            w25q_erase (0x10000, SIM_W25Q_T_BE64_NS);
+        }
+        break;
+
+    case 0xC7:
+    case 0x60:
+        if ((w25q.idx == 1) && w25q_write_start()) {
+            sim_w25q_stats.erase_chip++;
+            w25q.addr = 0;
+            w25q_erase (SIM_W25Q_SIZE, SIM_W25Q_T_CE_NS);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void sim_w25q_cs (uint8_t level) {
+    if (level) {
+        if (w25q.selected) {
+            w25q_finish();
+        }
+        w25q.selected = 0;
+    } else if (!w25q.selected) {
+        w25q.selected = 1;
+        w25q.idx = 0;
+        w25q.fill = 0;
+        w25q.ignored = 0;
+        w25q.addr = 0;
+    }
+}
+
+/**
+ * @brief  交换一个字节，片选未选中时返回0xFF
+ */
+uint8_t sim_w25q_xfer (uint8_t tx) {
+    uint32_t i = w25q.idx++;
+    uint8_t rx = 0xFF;
+
+    if (!w25q.selected || w25q.ignored) {
+        return rx;
+    }
+    if (i == 0) {
+        w25q.cmd = tx;
+        if (sim_w25q_busy() && (tx != 0x05)) {
+            sim_w25q_stats.busy_commands++;
+            sim_error ("w25q: cmd %02x while busy", tx);
+            w25q.ignored = 1;
+            return rx;
+        }
+        if (tx == 0x06) {
+            w25q.wel = 1;
+        } else if (tx == 0x04) {
+            w25q.wel = 0;
+        } else if (tx == 0x05) {
+            sim_w25q_stats.status_polls++;
+        }
+        return rx;
+    }
+
+    switch (w25q.cmd) {
+    case 0x05:
+        rx = (sim_w25q_busy() ? 0x01 : 0) | (w25q.wel ? 0x02 : 0);
+        break;
+
+    case 0x03:
+    case 0x0B:
+    case 0x5A:
+        if (i <= 3) {
+            w25q.addr = (w25q.addr << 8) | tx;
+        } else if ((w25q.cmd != 0x03) && (i == 4)) {
+            // 0x0B/0x5A地址后一个空字节
+        } else if (w25q.cmd == 0x5A) {
+            sim_w25q_stats.sfdp_reads++;
+            rx = (w25q.addr < w25q_sfdp_len) ? w25q_sfdp[w25q.addr] : 0xFF;
+            w25q.addr++;
+        } else {
+            sim_w25q_stats.read_bytes++;
+            rx = sim_w25q_mem[w25q.addr & (SIM_W25Q_SIZE - 1)];
+            w25q.addr++;
+        }
+        break;
+
+    case 0x02:
+        if (i <= 3) {
+            w25q.addr = (w25q.addr << 8) | tx;
+        } else {
+            // 超过256字节时在页内回绕，后面的数据覆盖前面的
+            w25q.page[(i - 4) & 0xFF] = tx;
+            if (w25q.fill < 256) {
+                w25q.fill++;
+            }
+        }
+        break;
+
+    case 0x20:
+    case 0x52:
+    case 0xD8:
+        if (i <= 3) {
+            w25q.addr = (w25q.addr << 8) | tx;
+        }
+        break;
+
+    case 0x90:
+        if (i >= 4) {
+            rx = ((i - 4) & 1) ? w25q_id[2] - 1 : w25q_id[0];  // W25Q64：EF 16
+        }
+        break;
+
+    case 0x9F:
+        if (i <= 3) {
+            rx = w25q_id[i - 1];
+        }
+        break;
+
+    default:
+        break;
+    }
+    return rx;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef SIM_W25Q_H
+#define SIM_W25Q_H
+
+#include <stdint.h>
+
+//--------------------------SPI NOR模型------------------------------------
+// W25Q64（8MB）按SPI字节流解释命令，内容保存在RAM中：
+// 1.页编程只能把1改成0，需要0->1时记为擦除前写入错误（NOR实际得到按位与的结果）
+// 2.编程/擦除命令在片选拉高时执行，之后在忙时间内只响应0x05读状态，
+//   其他命令被忽略并记为错误；写命令前必须0x06写使能
+// 3.时间取W25Q64JV数据手册的典型值
+// 4.SFDP区内容由sim_w25q_sfdp()设置，没有设置时返回0xFF（不支持SFDP的老型号）
+//--------------------------------------------------------------------
+#define SIM_W25Q_SIZE           (8 * 1024 * 1024)
+#define SIM_W25Q_T_PP_NS        (400 * 1000ULL)         // 页编程0.4ms
+#define SIM_W25Q_T_SE_NS        (45 * 1000 * 1000ULL)   // 4K擦除45ms
+#define SIM_W25Q_T_BE32_NS      (120 * 1000 * 1000ULL)  // 32K擦除120ms
+#define SIM_W25Q_T_BE64_NS      (150 * 1000 * 1000ULL)  // 64K擦除150ms
+#define SIM_W25Q_T_CE_NS        (20ULL * 1000 * 1000 * 1000)  // 整片擦除20s
+
+typedef struct {
+    uint32_t read_bytes;
+    uint32_t program_bytes;
+    uint32_t page_programs;
+    uint32_t erase_4k;
+    uint32_t erase_32k;
+    uint32_t erase_64k;
+    uint32_t erase_chip;
+    uint32_t sfdp_reads;
+    uint32_t status_polls;
+    uint32_t dirty_programs;   // 编程区域未擦除（需要0->1）
+    uint32_t busy_commands;    // 忙期间发出的非读状态命令
+    uint32_t unlatched;        // 没有写使能的编程/擦除
+} sim_w25q_stats_t;
+
+extern uint8_t sim_w25q_mem[SIM_W25Q_SIZE];
+extern sim_w25q_stats_t sim_w25q_stats;
+
+void sim_w25q_reset(void);
+void sim_w25q_sfdp(const uint8_t *table, uint32_t len);
+void sim_w25q_id(uint8_t manufacturer, uint8_t type, uint8_t capacity);
+void sim_w25q_cs(uint8_t level);
+uint8_t sim_w25q_xfer(uint8_t tx);
+uint8_t sim_w25q_busy(void);
+
+#endif /* SIM_W25Q_H */
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_test.h"
+#include "sim_w25q.h"
+#include "sim_iflash.h"
+#include "ry_boot.h"
+#include "ry_record.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//--------------------------A/B升级状态机------------------------------------
+// 每次“上电”在fork出的子进程中运行固件，全局变量都是初始值；W25Q64的记录/B/R区和
+// 内部FLASH在共享内存中跨上电保存。主进程只调度和检查，不运行固件代码，
+// 子进程继承主进程sim_reset()之后的外设模型，只恢复FLASH内容。
+// 1.空APP区上安装image0（不备份）并确认，作为以下各项的起点BASE
+// 2.安装image1：PENDING->COPY->TRIAL，R中为image0，确认后回到IDLE
+// 3.不确认：每次上电trials加1，RY_BOOT_TRIALS次之后从R恢复image0
+// 4.COPY中掉电后B被破坏：重新安装读回校验失败，从R恢复
+// 5.升级过程中每一次FLASH编程/擦除处掉电（sim_power_cut），以及重新上电继续安装时
+//   再在每一次编程/擦除处掉电：之后A要么是已确认的image0（IDLE），要么是试运行的
+//   image1（TRIAL）且R中为完整的image0
+//--------------------------------------------------------------------
+#define TEST_W25Q_BASE  RY_JOURNAL_ADDR
+#define TEST_W25Q_SIZE  (RY_SLOT_BACKUP_ADDR + IAP_APP_SIZE - RY_JOURNAL_ADDR)
+#define TEST_SIZE0      1000    // 不是页的整数倍，最后一页补0xFF
+#define TEST_SIZE1      1700
+
+typedef struct {
+    uint8_t w25q[TEST_W25Q_SIZE];   // 从RY_JOURNAL_ADDR开始：记录区、B、R
+    uint8_t iflash[SIM_IFLASH_SIZE];
+} test_nv_t;
+
+typedef struct {
+    uint8_t lost;           // 运行中掉电
+    ry_boot_record_t boot;
+    int8_t app;             // A中的固件：0/1，-1为其他内容
+    uint8_t app_valid;      // IAP有效性记录存在且整个固件CRC一致
+} test_out_t;
+
+static test_nv_t *test_nv;      // 共享内存：当前FLASH内容
+static test_out_t *test_out;    // 共享内存：子进程的结果
+static test_nv_t test_base, test_save;
+static uint8_t test_image[2][TEST_SIZE1];
+static const uint32_t test_size[2] = {TEST_SIZE0, TEST_SIZE1};
+static uint8_t test_new;        // 升级写入的镜像
+
+//--------------------------固件（子进程）------------------------------------
+static void test_fw_boot (void) {
+    Flash_Init();
+    ry_boot_check();
+}
+
+/* 上电后收到新固件：写入B，校验并安装（不给期望CRC，安装后的读回校验仍然进行） */
+static void test_fw_upgrade (void) {
+    test_fw_boot();
+    CHECK_EQ (ry_boot_stage_begin (0), HAL_OK);
+    CHECK_EQ (ry_boot_stage_write (test_image[test_new], test_size[test_new]), HAL_OK);
+    CHECK_EQ (ry_boot_stage_finish(), test_size[test_new]);
+    ry_boot_activate (test_size[test_new], NULL);
+}
+
+static void test_fw_probe (void) {
+    ry_record_area area = {RY_BOOT_RECORD_ADDR, sizeof (ry_boot_record_t)};
+    const uint8_t *app = (const uint8_t *)IAP_APP_ADDR;
+    uint8_t i;
+
+    Flash_Init();
+    if (!ry_record_load (&area, &test_out->boot) || (test_out->boot.magic != RY_BOOT_MAGIC)) {
+        memset (&test_out->boot, 0, sizeof (test_out->boot));
+    }
+    test_out->app = -1;
+    for (i = 0; i < 2; i++) {
+        if (!memcmp (app, test_image[i], test_size[i]) && (app[test_size[i]] == 0xFF)) {
+            test_out->app = i;
+        }
+    }
+    test_out->app_valid = IAP_Record_Full() && (IAP_Record_Get()->size == test_size[test_out->app & 1]);
+}
+
+static void test_child (void (*fn)(void), uint32_t cut) {
+    sim_test_failures = 0;  // 只报告这一次上电中的失败
+    memcpy (&sim_w25q_mem[TEST_W25Q_BASE], test_nv->w25q, TEST_W25Q_SIZE);
+    sim_iflash_restore (test_nv->iflash);
+    sim_power_cut = cut;
+    sim_run (fn);
+    test_out->lost = sim_power_lost;
+    memcpy (test_nv->w25q, &sim_w25q_mem[TEST_W25Q_BASE], TEST_W25Q_SIZE);
+    memcpy (test_nv->iflash, sim_iflash_mem(), SIM_IFLASH_SIZE);
+    CHECK_EQ (sim_stats.errors, 0);
+    CHECK (sim_power_lost || sim_iflash_locked());
+    fflush (stderr);
+    _exit (sim_test_failures ? 1 : 0);
+}
+
+//--------------------------调度（主进程）------------------------------------
+/* 上电运行一次fn，cut非0时在第cut次编程/擦除处掉电，返回1表示掉电 */
+static uint8_t test_run (void (*fn)(void), uint32_t cut) {
+    pid_t pid;
+    int status;
+
+    fflush (stderr);
+    pid = fork();
+    if (pid == 0) {
+        test_child (fn, cut);
+    }
+    if ((pid < 0) || (waitpid (pid, &status, 0) != pid) || !WIFEXITED (status) || WEXITSTATUS (status)) {
+        sim_test_failures++;
+        fprintf (stderr, "test_boot: run failed, cut %u\n", cut);
+        return 0;
+    }
+    return test_out->lost;
+}
+
+static const test_out_t *test_probe (void) {
+    test_run (test_fw_probe, 0);
+    return test_out;
+}
+
+static void test_confirm (void) {
+    uint32_t magic = IAP_CONFIRM_MAGIC;
+
+    memcpy (&test_nv->iflash[IAP_CONFIRM_ADDR - FLASH_BASE], &magic, sizeof (magic));
+}
+
+/* A为已确认的image0 */
+static void test_check_old (const char *where, uint32_t n, uint32_t m) {
+    const test_out_t *o = test_probe();
+
+    if ((o->boot.state != RY_BOOT_IDLE) || (o->app != 0) || !o->app_valid || (o->boot.size != TEST_SIZE0)) {
+        sim_test_failures++;
+        fprintf (stderr, "%s cut %u/%u: state %u app %d valid %u size %u\n", where, n, m, o->boot.state, o->app,
+                 o->app_valid, o->boot.size);
+    }
+}
+
+/* 升级结束后的两种合法结果；TRIAL时R中必须是完整的image0（回滚本身见test_trial_rollback） */
+static void test_check_settled (uint32_t n, uint32_t m) {
+    const test_out_t *o = test_probe();
+
+    if (o->boot.state == RY_BOOT_IDLE) {
+        test_check_old ("settled", n, m);
+        return;
+    }
+    if ((o->boot.state != RY_BOOT_TRIAL) || (o->app != 1) || !o->app_valid || (o->boot.bak_size != TEST_SIZE0) ||
+        memcmp (&test_nv->w25q[RY_SLOT_BACKUP_ADDR - TEST_W25Q_BASE], test_image[0], TEST_SIZE0)) {
+        sim_test_failures++;
+        fprintf (stderr, "settled cut %u/%u: state %u app %d valid %u bak %u\n", n, m, o->boot.state, o->app,
+                 o->app_valid, o->boot.bak_size);
+    }
+}
+
+//--------------------------------------------------------------------
+static void test_setup (void) {
+    const test_out_t *o;
+    uint32_t i, x = 0x2545F491;
+
+    for (i = 0; i < sizeof (test_image); i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        test_image[i / TEST_SIZE1][i % TEST_SIZE1] = (uint8_t)x;
+    }
+    memset (test_nv, 0xFF, sizeof (*test_nv));
+
+    // 空APP区：不备份，bak_size为0
+    test_new = 0;
+    CHECK_EQ (test_run (test_fw_upgrade, 0), 0);
+    o = test_probe();
+    CHECK_EQ (o->boot.state, RY_BOOT_TRIAL);
+    CHECK_EQ (o->boot.bak_size, 0);
+    CHECK_EQ (o->app, 0);
+    CHECK (o->app_valid);
+    test_confirm();
+    test_run (test_fw_boot, 0);
+    test_check_old ("base", 0, 0);
+    test_base = *test_nv;
+}
+
+static void test_install_confirm (void) {
+    const test_out_t *o;
+
+    *test_nv = test_base;
+    test_new = 1;
+    CHECK_EQ (test_run (test_fw_upgrade, 0), 0);
+    o = test_probe();
+    CHECK_EQ (o->boot.state, RY_BOOT_TRIAL);
+    CHECK_EQ (o->boot.trials, 0);
+    CHECK_EQ (o->boot.size, TEST_SIZE1);
+    CHECK_EQ (o->boot.bak_size, TEST_SIZE0);
+    CHECK_EQ (o->app, 1);
+    CHECK (o->app_valid);
+    CHECK (!memcmp (&test_nv->w25q[RY_SLOT_BACKUP_ADDR - TEST_W25Q_BASE], test_image[0], TEST_SIZE0));
+
+    test_run (test_fw_boot, 0);
+    CHECK_EQ (test_probe()->boot.trials, 1);
+    test_confirm();
+    test_run (test_fw_boot, 0);
+    o = test_probe();
+    CHECK_EQ (o->boot.state, RY_BOOT_IDLE);
+    CHECK_EQ (o->boot.size, TEST_SIZE1);
+    CHECK_EQ (o->app, 1);
+    CHECK (o->app_valid);
+}
+
+static void test_trial_rollback (void) {
+    uint8_t i;
+
+    *test_nv = test_base;
+    test_new = 1;
+    test_run (test_fw_upgrade, 0);
+    for (i = 1; i <= RY_BOOT_TRIALS; i++) {
+        test_run (test_fw_boot, 0);
+        CHECK_EQ (test_probe()->boot.state, RY_BOOT_TRIAL);
+        CHECK_EQ (test_out->boot.trials, i);
+        CHECK_EQ (test_out->app, 1);
+    }
+    test_run (test_fw_boot, 0);
+    test_check_old ("trial rollback", 0, 0);
+    CHECK_EQ (test_out->boot.bak_size, 0);
+}
+
+/* 在COPY中掉电，B被破坏：重新安装的读回校验失败，从R恢复 */
+static void test_install_fail (void) {
+    uint32_t n;
+
+    for (n = 1; n < 1000; n++) {
+        *test_nv = test_base;
+        test_new = 1;
+        if (!test_run (test_fw_upgrade, n)) {
+            break;
+        }
+        if (test_probe()->boot.state == RY_BOOT_COPY) {
+            test_nv->w25q[RY_SLOT_STAGE_ADDR - TEST_W25Q_BASE + 100] ^= 0x5A;
+            test_run (test_fw_boot, 0);
+            test_check_old ("install fail", n, 0);
+            CHECK_EQ (test_out->boot.bak_size, 0);
+            return;
+        }
+    }
+    CHECK (!"no power cut point in COPY");
+}
+
+static void test_power_cut (void) {
+    uint32_t n, m, ops = 0;
+
+    test_new = 1;
+    for (n = 1; n < 1000; n++) {
+        *test_nv = test_base;
+        if (!test_run (test_fw_upgrade, n)) {
+            ops = n - 1;
+            break;
+        }
+        test_save = *test_nv;
+        // 重新上电继续安装，在每一次编程/擦除处再掉电
+        for (m = 1; m < 1000; m++) {
+            *test_nv = test_save;
+            if (!test_run (test_fw_boot, m)) {
+                test_check_settled (n, 0);
+                break;
+            }
+            test_run (test_fw_boot, 0);
+            test_check_settled (n, m);
+        }
+    }
+    CHECK (ops > 0);
+    fprintf (stderr, "test_boot: %u flash operations per upgrade\n", ops);
+}
+
+int main (void) {
+    test_nv = mmap (NULL, sizeof (*test_nv) + sizeof (*test_out), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                    -1, 0);
+    if (test_nv == MAP_FAILED) {
+        perror ("mmap");
+        return 1;
+    }
+    test_out = (test_out_t *)(test_nv + 1);
+    sim_reset();  // 每次上电的子进程从这里的外设状态开始，只恢复FLASH内容
+    test_setup();
+    test_install_confirm();
+    test_trial_rollback();
+    test_install_fail();
+    test_power_cut();
+    fprintf (stderr, "test_boot: %s\n", sim_test_failures ? "FAIL" : "ok");
+    return sim_test_failures ? 1 : 0;
+}
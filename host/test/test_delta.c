@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_test.h"
+#include "ry_delta.h"
+#include "ry_diff.h"
+#include "ry_proto.h"
+#include "my_data_array.h"
+#include <string.h>
+
+//--------------------------差分补丁生成/应用------------------------------------
+// 1.host/tools/ry_diff.c生成补丁，ry_delta_apply()按不同分包长度应用，与新固件一致
+// 2.负seek（新固件中旧固件的块顺序交换）、diff读到旧固件末尾、旧固件长度不是4的倍数
+// 3.extra在包边界处开始/结束：手工补丁在每个位置分成两包应用
+// 4.补丁结束后多余的数据、文件头和记录头损坏、补丁不完整：拒绝，之后的数据也返回错误
+//--------------------------------------------------------------------
+#define TEST_MAX        (16 * 1024)
+#define TEST_PATCH_MAX  (2 * TEST_MAX)
+
+static ry_delta_t test_delta;
+static uint8_t test_old[TEST_MAX];    // 旧固件区域，旧固件之后为0xFF
+static uint8_t test_new[TEST_MAX];
+static uint8_t test_out[TEST_MAX];
+static uint8_t test_patch[TEST_PATCH_MAX];
+static uint32_t test_out_len;
+static uint8_t test_sink_err;
+
+static uint8_t test_sink (const uint8_t *data, uint16_t len, void *ctx) {
+    (void)ctx;
+    CHECK (len > 0);
+    if (test_out_len + len > TEST_MAX) {
+        CHECK (0);
+        return 1;
+    }
+    memcpy (&test_out[test_out_len], data, len);
+    test_out_len += len;
+    return test_sink_err;
+}
+
+static void test_fill (uint8_t *buf, uint32_t len, uint32_t seed) {
+    uint32_t i, x = seed * 0x9E3779B9u + 1;
+
+    for (i = 0; i < len; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[i] = (uint8_t)x;
+    }
+}
+
+static void test_set_old (const uint8_t *old, uint32_t len) {
+    memset (test_old, 0xFF, sizeof (test_old));
+    memcpy (test_old, old, len);
+}
+
+/* 按chunk字节分包应用，返回第一个错误 */
+static uint8_t test_apply (const uint8_t *patch, uint32_t len, uint32_t chunk) {
+    uint32_t off, n;
+    uint8_t err = 0;
+
+    ry_delta_init (&test_delta, test_old, sizeof (test_old), TEST_MAX);
+    test_out_len = 0;
+    for (off = 0; (off < len) && !err; off += n) {
+        n = (len - off > chunk) ? chunk : len - off;
+        err = ry_delta_apply (&test_delta, &patch[off], n, test_sink, NULL);
+    }
+    return err;
+}
+
+/* 补丁中的记录：extra总长度和最小的seek */
+static void test_records (const uint8_t *patch, uint32_t len, uint32_t *extra, int32_t *seek_min) {
+    uint32_t off = RY_DELTA_HEAD_SIZE, diff, ex;
+    int32_t seek;
+
+    *extra = 0;
+    *seek_min = 0;
+    while (off + RY_DELTA_CTRL_SIZE <= len) {
+        memcpy (&diff, &patch[off], 4);
+        memcpy (&ex, &patch[off + 4], 4);
+        memcpy (&seek, &patch[off + 8], 4);
+        *extra += ex;
+        if (seek < *seek_min) {
+            *seek_min = seek;
+        }
+        off += RY_DELTA_CTRL_SIZE + diff + ex;
+    }
+    CHECK_EQ (off, len);
+}
+
+/* 生成补丁后按各种分包长度应用，返回补丁长度 */
+static uint32_t test_round_trip (const uint8_t *old, uint32_t old_len, const uint8_t *new_, uint32_t new_len) {
+    static const uint32_t chunks[] = {1, 3, 12, 16, 255, 1014, 0xFFFF};
+    uint32_t plen, i;
+
+    test_set_old (old, old_len);
+    plen = ry_diff_make (old, old_len, new_, new_len, test_patch, sizeof (test_patch));
+    CHECK (plen > RY_DELTA_HEAD_SIZE);
+    for (i = 0; i < sizeof (chunks) / sizeof (chunks[0]); i++) {
+        CHECK_EQ (test_apply (test_patch, plen, chunks[i]), 0);
+        CHECK (ry_delta_done (&test_delta));
+        CHECK_EQ (test_out_len, new_len);
+        CHECK (memcmp (test_out, new_, new_len) == 0);
+    }
+    return plen;
+}
+
+/* my_data_array与修改后的副本：改字节、插入、删除、追加 */
+static void test_sample (void) {
+    const uint32_t len = sizeof (my_data_array);
+    uint32_t n = 0, plen, extra, i;
+    int32_t seek;
+
+    memcpy (test_new, my_data_array, 1000);
+    n = 1000;
+    test_fill (&test_new[n], 37, 1);  // 插入
+    n += 37;
+    memcpy (&test_new[n], &my_data_array[1000], 1000);
+    n += 1000;
+    memcpy (&test_new[n], &my_data_array[2050], len - 2050);  // 删除50字节
+    n += len - 2050;
+    test_fill (&test_new[n], 100, 2);  // 追加
+    n += 100;
+    for (i = 0; i < n; i += 97) {
+        test_new[i]++;  // 零散修改，如地址常量
+    }
+
+    plen = test_round_trip (my_data_array, len, test_new, n);
+    test_records (test_patch, plen, &extra, &seek);
+    fprintf (stderr, "  my_data_array: %u -> %u bytes, patch %u extra %u\n", len, n, plen, extra);
+    CHECK (extra < 37 + 100 + 32);
+    CHECK (seek >= 0);
+
+    /* 旧固件长度不是4的倍数：补齐的0xFF参与CRC */
+    test_round_trip (my_data_array, len - 3, test_new, n);
+    test_round_trip (my_data_array, len - 1, my_data_array, len);
+}
+
+/* 新固件中旧固件的两半交换：第二条记录向回seek */
+static void test_seek (void) {
+    static uint8_t old[8192];
+    uint32_t plen, extra;
+    int32_t seek;
+
+    test_fill (old, sizeof (old), 3);
+    memcpy (test_new, &old[4096], 4096);
+    memcpy (&test_new[4096], old, 4096);
+    plen = test_round_trip (old, sizeof (old), test_new, 8192);
+    test_records (test_patch, plen, &extra, &seek);
+    fprintf (stderr, "  swapped halves: patch %u extra %u seek %d\n", plen, extra, seek);
+    CHECK (seek < 0);
+    CHECK_EQ (extra, 0);
+}
+
+/* diff读到旧固件末尾，之后为extra */
+static void test_tail (void) {
+    static uint8_t old[4096];
+    uint32_t plen, extra;
+    int32_t seek;
+
+    test_fill (old, sizeof (old), 4);
+    memcpy (test_new, old, sizeof (old));
+    test_fill (&test_new[sizeof (old)], 500, 5);
+    plen = test_round_trip (old, sizeof (old), test_new, sizeof (old) + 500);
+    test_records (test_patch, plen, &extra, &seek);
+    CHECK_EQ (extra, 500);
+
+    /* 末尾修改过的旧固件：diff正好结束在old_size */
+    memcpy (test_new, old, sizeof (old));
+    test_new[sizeof (old) - 1] ^= 0x55;
+    test_round_trip (old, sizeof (old), test_new, sizeof (old));
+}
+
+//--------------------------手工补丁------------------------------------
+static uint8_t *test_put32 (uint8_t *b, uint32_t v) {
+    b[0] = v;
+    b[1] = v >> 8;
+    b[2] = v >> 16;
+    b[3] = v >> 24;
+    return b + 4;
+}
+
+static uint8_t *test_head (uint8_t *b, uint32_t old_size, uint32_t new_size) {
+    b = test_put32 (b, RY_DELTA_MAGIC);
+    b = test_put32 (b, old_size);
+    b = test_put32 (b, ry_proto_crc32 (test_old, old_size));
+    return test_put32 (b, new_size);
+}
+
+static uint8_t *test_ctrl (uint8_t *b, uint32_t diff, uint32_t extra, int32_t seek) {
+    b = test_put32 (b, diff);
+    b = test_put32 (b, extra);
+    return test_put32 (b, (uint32_t)seek);
+}
+
+/* 旧固件16字节；记录1：diff 10、extra 20、seek -4；记录2：diff 10（读到old_size）*/
+static uint32_t test_handmade (uint8_t *expect) {
+    uint8_t *b = test_patch;
+    uint32_t i;
+
+    test_fill (test_old, 16, 6);
+    memset (&test_old[16], 0xFF, sizeof (test_old) - 16);
+    b = test_head (b, 16, 40);
+    b = test_ctrl (b, 10, 20, -4);
+    for (i = 0; i < 10; i++) {
+        *b++ = i;
+        expect[i] = test_old[i] + i;
+    }
+    for (i = 0; i < 20; i++) {
+        *b++ = 0xA0 + i;
+        expect[10 + i] = 0xA0 + i;
+    }
+    b = test_ctrl (b, 10, 0, 0);  // old_pos = 10 - 4 = 6，读到16
+    for (i = 0; i < 10; i++) {
+        *b++ = 0x10;
+        expect[30 + i] = test_old[6 + i] + 0x10;
+    }
+    return b - test_patch;
+}
+
+/* 在每个位置分成两包：extra的开始/结束和记录头都会落在包边界上 */
+static void test_split (void) {
+    uint8_t expect[40];
+    uint32_t plen = test_handmade (expect), k;
+    uint8_t err;
+
+    for (k = 0; k <= plen; k++) {
+        ry_delta_init (&test_delta, test_old, sizeof (test_old), TEST_MAX);
+        test_out_len = 0;
+        err = ry_delta_apply (&test_delta, test_patch, k, test_sink, NULL);
+        err |= ry_delta_apply (&test_delta, &test_patch[k], plen - k, test_sink, NULL);
+        CHECK_EQ (err, 0);
+        CHECK (ry_delta_done (&test_delta));
+        CHECK_EQ (test_out_len, 40);
+        CHECK (memcmp (test_out, expect, 40) == 0);
+    }
+}
+
+/* 补丁错误：返回1且不完成，之后的数据也返回错误 */
+static void test_reject (const uint8_t *patch, uint32_t len, const char *what) {
+    uint8_t err = test_apply (patch, len, 0xFFFF);
+
+    if (!err || ry_delta_done (&test_delta)) {
+        fprintf (stderr, "  not rejected: %s\n", what);
+    }
+    CHECK_EQ (err, 1);
+    CHECK (!ry_delta_done (&test_delta));
+    CHECK_EQ (ry_delta_apply (&test_delta, patch, 1, test_sink, NULL), 1);
+}
+
+static void test_corrupt (void) {
+    static uint8_t bad[TEST_PATCH_MAX];
+    uint8_t expect[40];
+    uint32_t plen = test_handmade (expect), ctrl2 = RY_DELTA_HEAD_SIZE + RY_DELTA_CTRL_SIZE + 30;
+
+#define TEST_BAD(off, v, what)                  \
+    do {                                        \
+        memcpy (bad, test_patch, plen);         \
+        test_put32 (&bad[off], (uint32_t)(v));  \
+        test_reject (bad, plen, what);          \
+    } while (0)
+
+    CHECK_EQ (test_apply (test_patch, plen, 0xFFFF), 0);
+    CHECK (ry_delta_done (&test_delta));
+
+    /* 补丁结束后多余的数据：同一包中或单独一包 */
+    memcpy (bad, test_patch, plen);
+    bad[plen] = 0;
+    test_reject (bad, plen + 1, "trailing byte");
+    CHECK_EQ (test_apply (test_patch, plen, 0xFFFF), 0);
+    CHECK_EQ (ry_delta_apply (&test_delta, bad, 1, test_sink, NULL), 1);
+    CHECK (!ry_delta_done (&test_delta));
+
+    TEST_BAD (0, 0x50445953, "magic");
+    TEST_BAD (4, 20, "old size");
+    TEST_BAD (4, 18, "old size not multiple of 4");
+    TEST_BAD (4, sizeof (test_old) + 4, "old size over limit");
+    TEST_BAD (8, ry_proto_crc32 (test_old, 16) ^ 1, "old crc");
+    TEST_BAD (12, 0, "new size 0");
+    TEST_BAD (12, TEST_MAX + 1, "new size over limit");
+    TEST_BAD (RY_DELTA_HEAD_SIZE, 17, "diff past old size");
+    TEST_BAD (RY_DELTA_HEAD_SIZE + 4, 31, "extra past new size");
+    TEST_BAD (RY_DELTA_HEAD_SIZE + 8, -11, "seek before old start");
+    TEST_BAD (RY_DELTA_HEAD_SIZE + 8, 7, "seek past old size");
+    TEST_BAD (ctrl2, 11, "second diff past old size");
+    TEST_BAD (ctrl2 + 4, 1, "second extra past new size");
+#undef TEST_BAD
+
+    /* 不完整：不报错，但不完成 */
+    CHECK_EQ (test_apply (test_patch, plen - 1, 0xFFFF), 0);
+    CHECK (!ry_delta_done (&test_delta));
+
+    /* sink出错 */
+    test_sink_err = 1;
+    test_reject (test_patch, plen, "sink error");
+    test_sink_err = 0;
+}
+
+static void test_body (void) {
+    test_sample();
+    test_seek();
+    test_tail();
+    test_split();
+    test_corrupt();
+}
+
+int main (void) {
+    return sim_test_run ("test_delta", test_body);
+}
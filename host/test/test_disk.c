@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_test.h"
+#include "sim_w25q.h"
+#include "bsp_spi_flash.h"
+#include "ff.h"
+#include "diskio.h"
+#include <string.h>
+
+//--------------------------diskio批量写------------------------------------
+// W25Q模型检查每次页编程只把1改成0，忙期间不发其他命令，因此：
+// 1.只清除位的改写不擦除，直接按页编程；未改变的页不编程
+// 2.需要擦除的连续扇区合并为块擦除（64K对齐整块为一次0xD8）
+// 3.disk_write()发出命令后不等待，芯片忙在下一条命令或CTRL_SYNC前等待
+// 4.FatFs格式化、写文件、改写文件后内容正确
+//--------------------------------------------------------------------
+#define TEST_SECTORS    16
+
+static uint8_t test_wr[TEST_SECTORS * FLASH_SECTOR_SIZE];
+static uint8_t test_rd[TEST_SECTORS * FLASH_SECTOR_SIZE];
+static FATFS test_fs;
+static FIL test_fil;
+static uint8_t test_work[FF_MAX_SS];
+
+static void test_fill (uint32_t seed) {
+    uint32_t i, x = seed * 0x9E3779B9u + 1;
+
+    for (i = 0; i < sizeof (test_wr); i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        test_wr[i] = (uint8_t)x;
+    }
+}
+
+static void test_readback (LBA_t sector, UINT count) {
+    memset (test_rd, 0, count * FLASH_SECTOR_SIZE);
+    CHECK_EQ (disk_read (0, test_rd, sector, count), RES_OK);
+    CHECK (memcmp (test_rd, test_wr, count * FLASH_SECTOR_SIZE) == 0);
+    CHECK (memcmp (&sim_w25q_mem[sector * FLASH_SECTOR_SIZE], test_wr, count * FLASH_SECTOR_SIZE) == 0);
+}
+
+static DISK_STATS test_stats (void) {
+    DISK_STATS st;
+
+    disk_ioctl (0, CTRL_CACHE_STATS, &st);
+    disk_ioctl (0, CTRL_CACHE_RESET, NULL);
+    return st;
+}
+
+static void test_raw (void) {
+    const LBA_t base = 16;  // 64KB对齐
+    DISK_STATS st;
+    uint32_t i;
+
+    CHECK_EQ (disk_initialize (0), RES_OK);
+    test_stats();
+
+    /* 空白芯片：只编程 */
+    test_fill (1);
+    CHECK_EQ (disk_write (0, test_wr, base, TEST_SECTORS), RES_OK);
+    CHECK (sim_w25q_busy());  // 最后一页编程未等待
+    CHECK_EQ (disk_ioctl (0, CTRL_SYNC, NULL), RES_OK);
+    CHECK (!sim_w25q_busy());
+    st = test_stats();
+    CHECK_EQ (st.erases, 0);
+    CHECK_EQ (st.programs, TEST_SECTORS * FLASH_SECTOR_SIZE / SPI_FLASH_PageSize);
+    test_readback (base, TEST_SECTORS);
+
+    /* 相同数据：不擦除不编程 */
+    CHECK_EQ (disk_write (0, test_wr, base, TEST_SECTORS), RES_OK);
+    st = test_stats();
+    CHECK_EQ (st.erases + st.programs, 0);
+
+    /* 只清除位，并且只改第3扇区第2页：编程一页 */
+    test_wr[3 * FLASH_SECTOR_SIZE + 2 * SPI_FLASH_PageSize + 7] &= 0x0F;
+    test_wr[3 * FLASH_SECTOR_SIZE + 2 * SPI_FLASH_PageSize + 8] = 0;
+    CHECK_EQ (disk_write (0, test_wr, base, TEST_SECTORS), RES_OK);
+    st = test_stats();
+    CHECK_EQ (st.erases, 0);
+    CHECK_EQ (st.programs, 1);
+    test_readback (base, TEST_SECTORS);
+
+    /* 全部需要0->1：一次64K块擦除，空白页不编程 */
+    test_fill (2);
+    memset (&test_wr[5 * FLASH_SECTOR_SIZE], 0xFF, SPI_FLASH_PageSize);
+    i = sim_w25q_stats.erase_64k;
+    CHECK_EQ (disk_write (0, test_wr, base, TEST_SECTORS), RES_OK);
+    CHECK (sim_w25q_busy());
+    st = test_stats();
+    CHECK_EQ (st.erases, 1);
+    CHECK_EQ (st.erased_sectors, TEST_SECTORS);
+    CHECK_EQ (sim_w25q_stats.erase_64k - i, 1);
+    CHECK_EQ (st.programs, TEST_SECTORS * FLASH_SECTOR_SIZE / SPI_FLASH_PageSize - 1);
+    test_readback (base, TEST_SECTORS);
+
+    /* 第1、2扇区需要擦除：合并为一次擦除命令，其余扇区只编程改变的页 */
+    memcpy (test_rd, test_wr, sizeof (test_wr));
+    test_fill (3);
+    memcpy (&test_rd[1 * FLASH_SECTOR_SIZE], &test_wr[1 * FLASH_SECTOR_SIZE], 2 * FLASH_SECTOR_SIZE);
+    memcpy (test_wr, test_rd, sizeof (test_wr));
+    i = sim_w25q_stats.erase_4k;
+    CHECK_EQ (disk_write (0, test_wr, base, 4), RES_OK);
+    st = test_stats();
+    CHECK_EQ (st.erases, 2);  // 未对齐32K，两条4K擦除命令
+    CHECK_EQ (st.erased_sectors, 2);
+    CHECK_EQ (sim_w25q_stats.erase_4k - i, 2);
+    CHECK_EQ (st.programs, 2 * FLASH_SECTOR_SIZE / SPI_FLASH_PageSize);
+    test_readback (base, 4);
+
+    /* 跨64KB边界：分为两个窗口 */
+    test_fill (4);
+    CHECK_EQ (disk_write (0, test_wr, base + 8, TEST_SECTORS), RES_OK);
+    CHECK_EQ (disk_ioctl (0, CTRL_SYNC, NULL), RES_OK);
+    test_readback (base + 8, TEST_SECTORS);
+
+    /* 单扇区写经过缓存，CTRL_SYNC后写入FLASH */
+    test_fill (5);
+    CHECK_EQ (disk_write (0, test_wr, 100, 1), RES_OK);
+    CHECK (memcmp (&sim_w25q_mem[100 * FLASH_SECTOR_SIZE], test_wr, FLASH_SECTOR_SIZE) != 0);
+    CHECK_EQ (disk_ioctl (0, CTRL_SYNC, NULL), RES_OK);
+    test_readback (100, 1);
+}
+
+static void test_fatfs (void) {
+    MKFS_PARM opt = {FM_FAT, 1, 0, 0, 0};
+    uint32_t size = 300 * 1024, done, i;
+    UINT bw;
+
+    CHECK_EQ (f_mkfs ("0:", &opt, test_work, sizeof (test_work)), FR_OK);
+    CHECK_EQ (f_mount (&test_fs, "0:", 1), FR_OK);
+
+    for (i = 0; i < 2; i++) {
+        test_fill (10 + i);
+        CHECK_EQ (f_open (&test_fil, "0:test.bin", FA_CREATE_ALWAYS | FA_WRITE), FR_OK);
+        for (done = 0; done < size; done += bw) {
+            bw = 0;
+            CHECK_EQ (f_write (&test_fil, &test_wr[done % sizeof (test_wr)], 1024, &bw), FR_OK);
+            if (bw == 0) {
+                break;
+            }
+        }
+        CHECK_EQ (f_close (&test_fil), FR_OK);
+
+        CHECK_EQ (f_open (&test_fil, "0:test.bin", FA_READ), FR_OK);
+        CHECK_EQ (f_size (&test_fil), done);
+        for (done = 0; done < size; done += bw) {
+            bw = 0;
+            CHECK_EQ (f_read (&test_fil, test_rd, 1024, &bw), FR_OK);
+            if ((bw == 0) || (memcmp (test_rd, &test_wr[done % sizeof (test_wr)], bw) != 0)) {
+                CHECK (0);
+                break;
+            }
+        }
+        CHECK_EQ (f_close (&test_fil), FR_OK);
+    }
+    CHECK_EQ (f_unmount ("0:"), FR_OK);
+}
+
+static void test_body (void) {
+    test_raw();
+    test_fatfs();
+    CHECK_EQ (sim_w25q_stats.dirty_programs, 0);
+    CHECK_EQ (sim_w25q_stats.busy_commands, 0);
+}
+
+int main (void) {
+    return sim_test_run ("test_disk", test_body);
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_test.h"
+#include "sim_iflash.h"
+#include "iap.h"
+#include "ry_crc.h"
+#include <string.h>
+
+//--------------------------流式IAP------------------------------------
+// 内部FLASH模型检查编程前已擦除、擦除/编程时已解锁，因此：
+// 1.按USB包长分段写入后APP区内容正确，最后一页补0xFF
+// 2.每个包之后调用Poll时擦除全部提前完成（stall_count为0），不调用时同步擦除结果相同
+// 3.超出APP区返回IAP_ERROR，不写入记录页
+// 4.有效性记录写入/清除/作废后内容正确，每条路径结束后标准锁和快速模式锁都已设置
+//--------------------------------------------------------------------
+#define TEST_PACKET     1014
+
+static uint8_t test_image[IAP_APP_SIZE];
+
+static void test_fill (uint32_t seed) {
+    uint32_t i, x = seed * 0x9E3779B9u + 1;
+
+    for (i = 0; i < sizeof (test_image); i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        test_image[i] = (uint8_t)x;
+    }
+}
+
+static int test_blank (uint32_t addr, uint32_t size) {
+    const uint8_t *p = (const uint8_t *)addr;
+
+    while (size--) {
+        if (*p++ != 0xFF) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static IAP_StatusTypeDef test_stream (uint32_t size, uint8_t poll) {
+    IAP_StatusTypeDef status = IAP_OK;
+    uint32_t off, n;
+
+    IAP_Stream_Begin();
+    CHECK (IAP_Stream_Active());
+    for (off = 0; (off < size) && (status == IAP_OK); off += n) {
+        n = (size - off > TEST_PACKET) ? TEST_PACKET : size - off;
+        status = IAP_Stream_Write (&test_image[off], n);
+        if (poll) {
+            IAP_Stream_Poll();
+        }
+    }
+    n = IAP_Stream_Finish();
+    if (status == IAP_OK) {
+        CHECK_EQ (n, size);
+    }
+    CHECK (!IAP_Stream_Active());
+    CHECK (sim_iflash_locked());
+    return status;
+}
+
+static void test_image_ok (uint32_t size) {
+    uint32_t end = (size + IAP_PAGE_SIZE - 1) & ~(IAP_PAGE_SIZE - 1);
+
+    CHECK (memcmp ((const void *)IAP_APP_ADDR, test_image, size) == 0);
+    CHECK (test_blank (IAP_APP_ADDR + size, end - size));
+    CHECK_EQ (IAP_Stream_Stats()->program_count, end / IAP_PAGE_SIZE);
+}
+
+static void test_body (void) {
+    const IAP_RecordTypeDef *rec;
+    uint32_t size, crc;
+
+    CHECK (sim_iflash_locked());
+    CHECK_EQ (IAP_Stream_Write (test_image, 16), IAP_STATE);
+
+    /* 提前擦除：擦除完全在包之间完成 */
+    test_fill (1);
+    size = 100001;
+    CHECK_EQ (test_stream (size, 1), IAP_OK);
+    test_image_ok (size);
+    CHECK_EQ (IAP_Stream_Stats()->stall_count, 0);
+    CHECK_EQ (IAP_Stream_Stats()->erase_count, (size + IAP_BLOCK_SIZE - 1) / IAP_BLOCK_SIZE + 1);
+
+    /* 不调用Poll：编程时同步擦除 */
+    test_fill (2);
+    size = 70000;
+    CHECK_EQ (test_stream (size, 0), IAP_OK);
+    test_image_ok (size);
+    CHECK (IAP_Stream_Stats()->stall_count > 0);
+
+    /* 正好填满APP区（不含记录页） */
+    test_fill (3);
+    CHECK_EQ (test_stream (IAP_IMAGE_MAX, 1), IAP_OK);
+    test_image_ok (IAP_IMAGE_MAX);
+
+    /* 超出一页：编程到记录页之前停止 */
+    CHECK_EQ (test_stream (IAP_IMAGE_MAX + IAP_PAGE_SIZE, 1), IAP_ERROR);
+    CHECK (test_blank (IAP_RECORD_ADDR, IAP_PAGE_SIZE));
+
+    /* 有效性记录 */
+    test_fill (4);
+    size = 65536;
+    CHECK_EQ (test_stream (size, 1), IAP_OK);
+    crc = ry_crc_block ((const void *)IAP_APP_ADDR, size);
+    CHECK (IAP_Record_Get() == NULL);
+    *(volatile uint32_t *)IAP_CONFIRM_ADDR = IAP_CONFIRM_MAGIC;  // 模拟APP写入的确认字
+    IAP_Record_Write (size, crc, 7);
+    CHECK (sim_iflash_locked());
+    CHECK (!IAP_Confirmed());
+    rec = IAP_Record_Get();
+    CHECK (rec != NULL);
+    if (rec) {
+        CHECK_EQ (rec->size, size);
+        CHECK_EQ (rec->crc, crc);
+        CHECK_EQ (rec->generation, 7);
+    }
+    CHECK (IAP_Record_Quick());
+    CHECK (IAP_Record_Full());
+
+    /* 首页被改动：快速检查发现 */
+    sim_iflash_mem()[IAP_APP_ADDR - FLASH_BASE] ^= 1;
+    CHECK (!IAP_Record_Quick());
+    CHECK (!IAP_Record_Full());
+    sim_iflash_mem()[IAP_APP_ADDR - FLASH_BASE] ^= 1;
+
+    IAP_Record_Clear();
+    CHECK (sim_iflash_locked());
+    CHECK (IAP_Record_Get() == NULL);
+    CHECK (!test_blank (IAP_APP_ADDR, IAP_PAGE_SIZE));
+
+    IAP_Record_Write (size, crc, 8);
+    IAP_Record_Invalidate();
+    CHECK (sim_iflash_locked());
+    CHECK (IAP_Record_Get() == NULL);
+    CHECK (test_blank (IAP_APP_ADDR, IAP_PAGE_SIZE));
+    CHECK (test_blank (IAP_RECORD_ADDR, IAP_PAGE_SIZE));
+
+    CHECK_EQ (sim_iflash_stats.dirty_programs, 0);
+    CHECK_EQ (sim_iflash_stats.locked_ops, 0);
+}
+
+int main (void) {
+    return sim_test_run ("test_iap", test_body);
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_test.h"
+#include "ry_lz.h"
+#include "ry_lzc.h"
+#include "my_data_array.h"
+#include <string.h>
+
+//--------------------------LZ压缩/解码------------------------------------
+// 1.host/tools/ry_lzc.c压缩，ry_lz_decode()按不同分包长度解码，与原数据一致
+// 2.解出长度恰好为窗口整数倍、空包、只含控制字节的包：sink不能收到重复或旧数据
+//--------------------------------------------------------------------
+#define TEST_MAX    (128 * 1024)
+
+static ry_lz_t test_lz;
+static uint8_t test_in[TEST_MAX];
+static uint8_t test_comp[RY_LZC_BOUND (TEST_MAX)];
+static uint8_t test_out[TEST_MAX];
+static uint32_t test_out_len;
+static uint32_t test_sink_calls;
+
+static uint8_t test_sink (const uint8_t *data, uint16_t len, void *ctx) {
+    (void)ctx;
+    test_sink_calls++;
+    CHECK (len > 0);
+    if (test_out_len + len > TEST_MAX) {
+        CHECK (0);
+        return 1;
+    }
+    memcpy (&test_out[test_out_len], data, len);
+    test_out_len += len;
+    return 0;
+}
+
+/* 压缩后按chunk字节分包解码，每包之后再送一个空包 */
+static void test_round_trip (const uint8_t *data, uint32_t len, uint32_t chunk) {
+    uint32_t clen = ry_lzc_compress (data, len, test_comp), off, n;
+
+    CHECK (clen <= RY_LZC_BOUND (len));
+    ry_lz_init (&test_lz);
+    test_out_len = 0;
+    CHECK_EQ (ry_lz_decode (&test_lz, test_comp, 0, test_sink, NULL), 0);  // 空SOF
+    CHECK_EQ (test_out_len, 0);
+    for (off = 0; off < clen; off += n) {
+        n = (clen - off > chunk) ? chunk : clen - off;
+        CHECK_EQ (ry_lz_decode (&test_lz, &test_comp[off], n, test_sink, NULL), 0);
+        CHECK_EQ (ry_lz_decode (&test_lz, &test_comp[off], 0, test_sink, NULL), 0);
+    }
+    CHECK (ry_lz_done (&test_lz));
+    CHECK_EQ (test_lz.total, len);
+    CHECK_EQ (test_out_len, len);
+    CHECK (memcmp (test_out, data, len) == 0);
+}
+
+static void test_fill (uint32_t len, uint32_t seed, uint8_t runs) {
+    uint32_t i, x = seed * 0x9E3779B9u + 1;
+
+    for (i = 0; i < len; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        // runs:混入短重复和远距离重复，覆盖各种复制长度/距离
+        if (runs && (i >= 64) && ((x & 3) == 0)) {
+            test_in[i] = test_in[i - 1 - ((x >> 8) % (i < RY_LZ_WINDOW ? i : RY_LZ_WINDOW))];
+        } else {
+            test_in[i] = (uint8_t)x;
+        }
+    }
+}
+
+static void test_sample (void) {
+    static const uint32_t chunks[] = {1, 2, 3, 64, 1014, 0xFFFF};
+    uint32_t len = sizeof (my_data_array), clen, i;
+
+    clen = ry_lzc_compress (my_data_array, len, test_comp);
+    fprintf (stderr, "  my_data_array: %u -> %u bytes\n", len, clen);
+    CHECK (clen < len);
+    for (i = 0; i < sizeof (chunks) / sizeof (chunks[0]); i++) {
+        test_round_trip (my_data_array, len, chunks[i]);
+    }
+
+    /* 较大的数据，窗口多次回绕 */
+    test_fill (TEST_MAX, 1, 1);
+    test_round_trip (test_in, TEST_MAX, 1014);
+    test_round_trip (test_in, TEST_MAX, 7);
+    test_fill (TEST_MAX, 2, 0);  // 不可压缩
+    test_round_trip (test_in, TEST_MAX, 1014);
+    CHECK (ry_lzc_compress (test_in, TEST_MAX, test_comp) <= RY_LZC_BOUND (TEST_MAX));
+}
+
+/* 解出长度落在窗口边界上：回绕时已输出的数据在结束时不能再输出一次 */
+static void test_boundary (void) {
+    static const uint32_t lens[] = {0, 1, 2047, 2048, 2049, 4095, 4096, 4097, 6144};
+    uint32_t i, n, calls;
+    uint8_t seed;
+
+    for (i = 0; i < sizeof (lens) / sizeof (lens[0]); i++) {
+        for (seed = 0; seed < 3; seed++) {
+            n = lens[i];
+            if (seed == 2) {
+                memset (test_in, 0x5A, n);  // 只有字面量和长复制
+            } else {
+                test_fill (n, seed + 10, seed);
+            }
+            test_round_trip (test_in, n, 0xFFFF);
+            test_round_trip (test_in, n, 1);
+            test_round_trip (test_in, n, 1014);
+        }
+    }
+
+    /* 2048字节的字面量，第二个包只有下一个复制的控制字节 */
+    test_fill (2048, 20, 0);
+    ry_lz_init (&test_lz);
+    test_out_len = 0;
+    test_sink_calls = 0;
+    for (i = 0; i < 2048; i += RY_LZ_MAX_LITERAL) {
+        test_comp[0] = RY_LZ_MAX_LITERAL - 1;
+        CHECK_EQ (ry_lz_decode (&test_lz, test_comp, 1, test_sink, NULL), 0);
+        CHECK_EQ (ry_lz_decode (&test_lz, &test_in[i], RY_LZ_MAX_LITERAL, test_sink, NULL), 0);
+    }
+    CHECK_EQ (test_out_len, 2048);
+    calls = test_sink_calls;
+    test_comp[0] = 0x80 | (15 << 3);  // 长度18，距离1
+    test_comp[1] = 0;
+    CHECK_EQ (ry_lz_decode (&test_lz, test_comp, 1, test_sink, NULL), 0);
+    CHECK_EQ (test_sink_calls, calls);
+    CHECK_EQ (test_out_len, 2048);
+    CHECK_EQ (ry_lz_decode (&test_lz, &test_comp[1], 1, test_sink, NULL), 0);
+    CHECK_EQ (test_out_len, 2048 + 18);
+    CHECK (memcmp (test_out, test_in, 2048) == 0);
+    for (i = 0; i < 18; i++) {
+        CHECK_EQ (test_out[2048 + i], test_in[2047]);
+    }
+}
+
+static void test_body (void) {
+    test_sample();
+    test_boundary();
+}
+
+int main (void) {
+    return sim_test_run ("test_lz", test_body);
+}
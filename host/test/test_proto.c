@@ -0,0 +1,476 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_test.h"
+#include "sim_usbd.h"
+#include "sim_iflash.h"
+#include "sim_w25q.h"
+#include "ry_proto.h"
+#include "hid_custom.h"
+#include "user_fatfs.h"
+#include "ry_log.h"
+#include "ry_event.h"
+#include "ry_boot.h"
+#include "iap.h"
+#include "diskio.h"
+#include <string.h>
+
+//--------------------------V2协议两端联调------------------------------------
+// 设备端为固件的USB/升级/FatFs/W25Q全部代码，主机端为host/tools/ry_proto.c，
+// 两端在同一进程中运行：主机在sim_usbd的IN回调和超时定时中推进，设备在事件循环中处理
+// 1.无丢包：HID和bulk两个接口，内容和CRC一致，没有重发
+// 2.按脚本制造缺包和重复包：设备回复NAK（期望的序号）和重复确认；IN端点忙时多个ACK合并
+// 3.OUT丢包/乱序、ACK丢失：回退N重发后内容一致，固件安装后APP区与镜像一致
+// 4.续传：中止后以相同镜像ID重新开始，从块边界继续
+// 5.V1连续发包：上一次回复未发完时推迟回复，不在IN端点忙时启动发送
+// 6.SOF带最终长度：文件创建时一次预擦除，数据写入时不再擦除；声明较长时EOF后截断
+// DONE/ERROR是传输的最后一个回复，协议中没有重新查询，测试不丢弃
+//--------------------------------------------------------------------
+#define TEST_FIRMWARE       0xAABB
+#define TEST_SETUP          0xCCDD
+#define TEST_LOAD           0xEEFF
+#define TEST_ACK_EVERY      4       // hid_custom.c HID_ACK_EVERY
+#define TEST_HID_OUT        0x02
+#define TEST_VENDOR_OUT     0x03
+#define TEST_TIMEOUT_NS     (300 * SIM_NS_PER_MS)   // 大于W25Q 64K擦除期间主循环的停顿
+#define TEST_DRAIN_NS       (5000 * SIM_NS_PER_MS)  // 全部发出后等待校验/安装
+#define TEST_DEADLINE_NS    (120000 * SIM_NS_PER_MS)
+
+typedef struct {
+    ry_proto_t proto;
+    uint8_t out_ep;
+    uint8_t in_ep;
+    uint8_t active;
+    uint8_t manual;         // 1:只处理ACK，由脚本发包
+    uint32_t loss;          // OUT包丢失（‰）
+    uint32_t reorder;       // 与前一包交换顺序（‰）
+    uint32_t ack_loss;      // OK/NAK丢失（‰）
+    uint32_t stop_after;    // 确认这么多包后主机中止，0:不中止
+    uint32_t length;        // SIZE中的长度，0:镜像长度
+    DISK_STATS sof;         // SOF被确认时的磁盘统计
+} test_link_t;
+
+static test_link_t test_link;
+static uint32_t test_rng = 12345;
+static uint16_t test_seq = 0xFFF0;  // 第一次传输中序号回绕
+static uint32_t test_v1_replies;
+static uint8_t test_pkt[RY_PROTO_PACKET_SIZE];
+static uint8_t test_image[400 * 1024];
+static uint8_t test_buf[4096];
+static FIL test_fil;
+
+static uint32_t test_rand (void) {
+    test_rng ^= test_rng << 13;
+    test_rng ^= test_rng >> 17;
+    test_rng ^= test_rng << 5;
+    return test_rng;
+}
+
+static void test_fill (uint32_t seed) {
+    uint32_t i, x = seed * 0x9E3779B9u + 1;
+
+    for (i = 0; i < sizeof (test_image); i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        test_image[i] = (uint8_t)x;
+    }
+}
+
+//--------------------------主机端（定时事件中运行）------------------------------------
+static void test_pump (void) {
+    test_link_t *l = &test_link;
+
+    while ((sim_usbd_out_queued (l->out_ep) < SIM_USBD_QUEUE) && ry_proto_next (&l->proto, test_pkt)) {
+        if (test_rand() % 1000 < l->loss) {
+            continue;
+        }
+        sim_usbd_out (l->out_ep, test_pkt, sizeof (test_pkt));
+        if (test_rand() % 1000 < l->reorder) {
+            sim_usbd_out_swap (l->out_ep);
+        }
+    }
+}
+
+static void test_timeout (void *arg);
+
+static void test_arm (void) {
+    uint64_t ns = ry_proto_draining (&test_link.proto) ? TEST_DRAIN_NS : TEST_TIMEOUT_NS;
+
+    sim_timer_start (test_timeout, &test_link, sim_now + ns);
+}
+
+static void test_stop (void) {
+    test_link.active = 0;
+    sim_timer_stop (test_timeout, &test_link);
+}
+
+static void test_timeout (void *arg) {
+    (void)arg;
+    if (!test_link.active || test_link.manual) {
+        return;
+    }
+    ry_proto_timeout (&test_link.proto);
+    test_pump();
+    test_arm();
+}
+
+static void test_host_in (uint8_t ep, const uint8_t *data, uint32_t len) {
+    test_link_t *l = &test_link;
+    uint32_t acked = l->proto.acked;
+
+    if (data[0] == 0x02) {
+        test_v1_replies++;  // V1回复
+        return;
+    }
+    if (!l->active || (ep != l->in_ep)) {
+        return;
+    }
+    if ((data[2] <= RY_PROTO_ACK_NAK) && (test_rand() % 1000 < l->ack_loss)) {
+        return;
+    }
+    ry_proto_ack (&l->proto, data, len);
+    if (!acked && l->proto.acked) {
+        disk_ioctl (0, CTRL_CACHE_STATS, &l->sof);
+    }
+    if (l->proto.state != RY_PROTO_RUN) {
+        test_stop();
+        return;
+    }
+    if (l->stop_after && (l->proto.acked >= l->stop_after)) {
+        sim_usbd_out_flush (l->out_ep);  // 主机中止，未发出的包丢弃
+        test_stop();
+        return;
+    }
+    if (!l->manual) {
+        test_pump();
+        test_arm();
+    }
+}
+
+//--------------------------设备端（固件上下文）------------------------------------
+/* 事件循环运行到cond为0，超时返回0 */
+#define TEST_RUN_WHILE(cond)                                                        \
+    ({                                                                              \
+        uint64_t test_deadline = sim_now + TEST_DEADLINE_NS;                        \
+        while ((cond) && (sim_now < test_deadline)) {                               \
+            ry_event_dispatch();                                                    \
+        }                                                                           \
+        !(cond);                                                                    \
+    })
+
+static void test_start (uint8_t out_ep, uint16_t type, uint32_t size, uint8_t flags) {
+    test_link.out_ep = out_ep;
+    test_link.in_ep = out_ep | 0x80;
+    if (out_ep == TEST_HID_OUT) {
+        test_link.in_ep = 0x81;
+    }
+    ry_proto_begin (&test_link.proto, type, test_image, size, flags, test_seq);
+    if (test_link.length) {
+        test_link.proto.length = test_link.length;
+    }
+    test_link.active = 1;
+    if (!test_link.manual) {
+        test_pump();
+        test_arm();
+    }
+}
+
+static uint8_t test_finish (void) {
+    CHECK (TEST_RUN_WHILE (test_link.active));
+    test_seq += test_link.proto.sent + 7;  // 下一次传输从任意序号开始
+    return test_link.proto.state;
+}
+
+static uint8_t test_transfer (uint8_t out_ep, uint16_t type, uint32_t size, uint8_t flags) {
+    test_start (out_ep, type, size, flags);
+    return test_finish();
+}
+
+static void test_file_ok (const TCHAR *path, uint32_t size) {
+    uint32_t off, n;
+    UINT br;
+
+    CHECK_EQ (f_open (&test_fil, path, FA_READ), FR_OK);
+    CHECK_EQ (f_size (&test_fil), size);
+    for (off = 0; off < size; off += br) {
+        n = (size - off > sizeof (test_buf)) ? sizeof (test_buf) : size - off;
+        br = 0;
+        f_read (&test_fil, test_buf, n, &br);
+        if ((br == 0) || (memcmp (test_buf, &test_image[off], br) != 0)) {
+            CHECK (0);
+            break;
+        }
+    }
+    f_close (&test_fil);
+}
+
+static void test_link_reset (uint32_t loss, uint32_t reorder, uint32_t ack_loss) {
+    memset (&test_link, 0, sizeof (test_link));
+    test_link.loss = loss;
+    test_link.reorder = reorder;
+    test_link.ack_loss = ack_loss;
+}
+
+static void test_ordered (void) {
+    const ry_proto_stats_t *st = &test_link.proto.stats;
+
+    /* HID：每1ms一包 */
+    test_fill (1);
+    test_link_reset (0, 0, 0);
+    CHECK_EQ (test_transfer (TEST_HID_OUT, TEST_SETUP, 60000, RY_PROTO_FLAG_CRC), RY_PROTO_DONE);
+    CHECK_EQ (st->retransmits, 0);
+    CHECK_EQ (st->naks + st->dup_acks, 0);
+    test_file_ok ("0:setup.ry", 60000);
+
+    /* bulk：包间隔远小于处理时间 */
+    test_fill (2);
+    test_link_reset (0, 0, 0);
+    CHECK_EQ (test_transfer (TEST_VENDOR_OUT, TEST_LOAD, 300000, RY_PROTO_FLAG_CRC), RY_PROTO_DONE);
+    fprintf (stderr, "  bulk ordered: %u packets %u acks max jump %u\n", st->packets, st->acks, st->max_jump);
+    CHECK_EQ (st->retransmits, 0);
+    CHECK_EQ (st->naks + st->dup_acks, 0);
+    test_file_ok ("0:load.bin", 300000);
+}
+
+/* 脚本：缺包时NAK，重复包时重复确认，之后自动完成 */
+static void test_script (void) {
+    static uint8_t pkt[3][RY_PROTO_PACKET_SIZE];
+    ry_proto_t *p = &test_link.proto;
+    uint16_t seq0;
+    int i;
+
+    test_fill (3);
+    test_link_reset (0, 0, 0);
+    test_link.manual = 1;
+    test_start (TEST_HID_OUT, TEST_SETUP, 8 * RY_PROTO_PAYLOAD_MAX, 0);
+    seq0 = p->seq0;
+    CHECK (ry_proto_next (p, test_pkt));  // SOF
+    sim_usbd_out (TEST_HID_OUT, test_pkt, sizeof (test_pkt));
+    CHECK (TEST_RUN_WHILE (p->acked == 0));
+    CHECK_EQ (p->acked, 1);
+
+    for (i = 0; i < 3; i++) {
+        CHECK (ry_proto_next (p, pkt[i]));
+    }
+    sim_usbd_out (TEST_HID_OUT, pkt[0], sizeof (pkt[0]));
+    sim_usbd_out (TEST_HID_OUT, pkt[2], sizeof (pkt[2]));  // 缺seq0+2
+    CHECK (TEST_RUN_WHILE (p->stats.naks == 0));
+    CHECK_EQ (p->acked, 2);
+    CHECK_EQ (p->next, 2);  // 回退到NAK中的序号
+    CHECK_EQ ((uint16_t)(seq0 + p->acked), (uint16_t)((test_pkt[6] << 8 | test_pkt[7]) + 2));
+
+    sim_usbd_out (TEST_HID_OUT, pkt[0], sizeof (pkt[0]));  // 已处理过
+    CHECK (TEST_RUN_WHILE (p->stats.dup_acks == 0));
+    CHECK_EQ (p->status, RY_PROTO_ACK_OK);
+    CHECK_EQ (p->acked, 2);
+
+    test_link.manual = 0;
+    test_pump();
+    test_arm();
+    CHECK_EQ (test_finish(), RY_PROTO_DONE);
+    CHECK_EQ (p->stats.retransmits, 2);  // 缺的包和设备丢弃的乱序包，其余是新包
+    test_file_ok ("0:setup.ry", 8 * RY_PROTO_PAYLOAD_MAX);
+}
+
+/* 脚本：IN端点忙时多次确认合并为一个累计确认，窗口外的包设备照常接收 */
+static void test_coalesce (void) {
+    ry_proto_t *p = &test_link.proto;
+    int i;
+
+    test_fill (8);
+    test_link_reset (0, 0, 0);
+    test_link.manual = 1;
+    sim_usbd_period (0x81, 200 * SIM_NS_PER_MS);  // 主机很久才读一次IN端点
+    test_start (TEST_HID_OUT, TEST_SETUP, 20 * RY_PROTO_PAYLOAD_MAX, 0);
+    CHECK (ry_proto_next (p, test_pkt));  // SOF
+    sim_usbd_out (TEST_HID_OUT, test_pkt, sizeof (test_pkt));
+    CHECK (TEST_RUN_WHILE (p->acked == 0));
+
+    p->window = 3 * TEST_ACK_EVERY;
+    for (i = 0; i < 3 * TEST_ACK_EVERY; i++) {
+        CHECK (ry_proto_next (p, test_pkt));
+        sim_usbd_out (TEST_HID_OUT, test_pkt, sizeof (test_pkt));
+    }
+    CHECK (TEST_RUN_WHILE (p->acked < 1 + 3 * TEST_ACK_EVERY));
+    sim_usbd_period (0x81, SIM_USBD_HID_NS);
+    // 第1包处理完接收缓冲为空，确认立即发出；之后每4包和缓冲为空时的确认在IN端点忙时合并
+    CHECK_EQ (p->stats.acks, 3);
+    CHECK_EQ (p->stats.max_jump, 3 * TEST_ACK_EVERY - 1);
+
+    test_link.manual = 0;
+    test_pump();
+    test_arm();
+    CHECK_EQ (test_finish(), RY_PROTO_DONE);
+    CHECK_EQ (p->stats.retransmits, 0);
+    test_file_ok ("0:setup.ry", 20 * RY_PROTO_PAYLOAD_MAX);
+}
+
+/* 丢包、乱序、ACK丢失 */
+static void test_lossy (void) {
+    const ry_proto_stats_t *st = &test_link.proto.stats;
+    const IAP_RecordTypeDef *rec;
+    uint32_t size = 150001;
+
+    test_fill (4);
+    test_link_reset (30, 30, 50);
+    CHECK_EQ (test_transfer (TEST_VENDOR_OUT, TEST_LOAD, sizeof (test_image), RY_PROTO_FLAG_CRC), RY_PROTO_DONE);
+    fprintf (stderr, "  bulk lossy: %u packets %u retransmits %u naks %u dup acks %u timeouts max jump %u\n",
+             st->packets, st->retransmits, st->naks, st->dup_acks, st->timeouts, st->max_jump);
+    CHECK (st->naks > 0);
+    CHECK (st->dup_acks > 0);
+    CHECK (st->retransmits > 0);
+    CHECK (st->max_jump > TEST_ACK_EVERY);
+    test_file_ok ("0:load.bin", sizeof (test_image));
+
+    /* 固件：暂存槽校验后安装到APP区 */
+    test_fill (5);
+    test_link_reset (20, 20, 20);
+    CHECK_EQ (test_transfer (TEST_HID_OUT, TEST_FIRMWARE, size, RY_PROTO_FLAG_CRC), RY_PROTO_DONE);
+    fprintf (stderr, "  hid firmware: %u packets %u retransmits %u timeouts\n", st->packets, st->retransmits, st->timeouts);
+    CHECK (memcmp ((const void *)IAP_APP_ADDR, test_image, size) == 0);
+    rec = IAP_Record_Get();
+    CHECK (rec != NULL);
+    if (rec) {
+        CHECK_EQ (rec->size, size);
+        CHECK_EQ (rec->crc, ry_proto_crc32 (test_image, size));
+    }
+    // 安装时提前擦除与SPI读取重叠，只擦除镜像占用的块
+    CHECK_EQ (IAP_Stream_Stats()->stall_count, 0);
+    CHECK_EQ (IAP_Stream_Stats()->erase_count, (size + IAP_BLOCK_SIZE - 1) / IAP_BLOCK_SIZE);
+    CHECK (sim_iflash_locked());
+}
+
+/* 续传：中止后相同ID从块边界继续，内容与一次传完相同 */
+static void test_resume (void) {
+    const uint8_t flags = RY_PROTO_FLAG_RESUME | RY_PROTO_FLAG_CRC;
+    const uint32_t size = 250000;
+    uint64_t end;
+
+    test_fill (6);
+    test_link_reset (10, 10, 0);
+    test_link.stop_after = 150;
+    CHECK_EQ (test_transfer (TEST_VENDOR_OUT, TEST_SETUP, size, flags), RY_PROTO_RUN);
+    CHECK_EQ (test_link.proto.offset, 0);
+    end = sim_now + TEST_TIMEOUT_NS;  // 设备处理完已收到的包
+    TEST_RUN_WHILE (sim_now < end);
+
+    test_link_reset (10, 10, 0);
+    CHECK_EQ (test_transfer (TEST_VENDOR_OUT, TEST_SETUP, size, flags), RY_PROTO_DONE);
+    fprintf (stderr, "  resume offset: %u\n", test_link.proto.offset);
+    CHECK (test_link.proto.offset >= 2 * RY_SLOT_BLOCK);
+    CHECK_EQ (test_link.proto.offset % RY_SLOT_BLOCK, 0);
+    test_file_ok ("0:setup.ry", size);
+}
+
+/* 删除文件，空闲簇写入非0xFF数据（如格式化后没有擦除过的空间），新文件需要擦除 */
+static void test_dirty (const TCHAR *path) {
+    static BYTE sec[FLASH_SECTOR_SIZE];
+    LBA_t s, end = fs.database + (LBA_t)(fs.n_fatent - 2) * fs.csize;
+    uint32_t i;
+
+    f_unlink (path);
+    memset (sec, 0x5A, sizeof (sec));
+    for (s = fs.database; s < end; s++) {
+        for (i = 0; (i < FLASH_SECTOR_SIZE) && (sim_w25q_mem[s * FLASH_SECTOR_SIZE + i] == 0xFF); i++) {
+        }
+        if (i == FLASH_SECTOR_SIZE) {
+            CHECK_EQ (disk_write (0, sec, s, 1), RES_OK);  // 全0xFF的数据扇区不属于任何文件
+        }
+    }
+    CHECK_EQ (disk_ioctl (0, CTRL_SYNC, NULL), RES_OK);
+}
+
+/* 预分配：创建文件时按大块擦除，之后写入数据时不再擦除 */
+static void test_size (void) {
+    const uint8_t flags = RY_PROTO_FLAG_SIZE | RY_PROTO_FLAG_CRC;
+    const uint32_t size = 300000;
+    DISK_STATS st[2];
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        test_dirty ("0:load.bin");
+        test_fill (8 + i);
+        test_link_reset (0, 0, 0);
+        disk_ioctl (0, CTRL_CACHE_RESET, NULL);
+        CHECK_EQ (test_transfer (TEST_VENDOR_OUT, TEST_LOAD, size, i ? flags : RY_PROTO_FLAG_CRC), RY_PROTO_DONE);
+        disk_ioctl (0, CTRL_CACHE_STATS, &st[i]);
+        st[i].erases -= test_link.sof.erases;  // 数据包期间的擦除
+        test_file_ok ("0:load.bin", size);
+    }
+    fprintf (stderr, "  load erases after SOF: %u, with size %u (SOF %u cmds %u sectors)\n", st[0].erases,
+             st[1].erases, test_link.sof.erases, test_link.sof.erased_sectors);
+    CHECK (st[0].erases >= size / FLASH_SECTOR_SIZE / 2);
+    CHECK (st[1].erases <= 2);  // 只有FAT和目录扇区
+    CHECK (test_link.sof.erased_sectors >= size / FLASH_SECTOR_SIZE);
+
+    /* 声明的长度大于实际长度：EOF后截断 */
+    test_fill (10);
+    test_link_reset (0, 0, 0);
+    test_link.length = size;
+    CHECK_EQ (test_transfer (TEST_VENDOR_OUT, TEST_LOAD, 5000, flags), RY_PROTO_DONE);
+    test_file_ok ("0:load.bin", 5000);
+}
+
+/* V1：主机不等回复连续发包，设备按包回复，IN端点忙时推迟 */
+static void test_v1 (void) {
+    const uint32_t size = 4000, max = 1019;
+    uint32_t off, n;
+
+    test_fill (7);
+    test_v1_replies = 0;
+    sim_usbd_period (TEST_HID_OUT, SIM_USBD_BULK_NS);
+    for (off = 0; off <= size; off += max) {
+        n = (size - off > max) ? max : size - off;
+        memset (test_pkt, 0, sizeof (test_pkt));
+        test_pkt[0] = 0x01;
+        test_pkt[1] = TEST_SETUP >> 8;
+        test_pkt[2] = TEST_SETUP & 0xFF;
+        test_pkt[3] = n >> 8;
+        test_pkt[4] = n;
+        memcpy (&test_pkt[5], &test_image[off], n);
+        CHECK (sim_usbd_out (TEST_HID_OUT, test_pkt, sizeof (test_pkt)));
+    }
+    CHECK (TEST_RUN_WHILE (sim_usbd_out_queued (TEST_HID_OUT) || (test_v1_replies < 2)));
+    off = sim_now + 10 * SIM_NS_PER_MS;
+    TEST_RUN_WHILE (sim_now < off);
+    sim_usbd_period (TEST_HID_OUT, SIM_USBD_HID_NS);
+    CHECK (test_v1_replies >= 2);
+    test_file_ok ("0:setup.ry", size);
+}
+
+static void test_body (void) {
+    USART_Printf_Init (115200);
+    ry_log_init();
+    fatfs_file_init();
+    ry_boot_check();
+    ry_event_register (RY_EVENT_LOG, ry_log_poll);
+    ry_event_register (RY_EVENT_TICK, ry_log_poll);
+    ry_event_tick_init();
+
+    sim_usbd_period (TEST_HID_OUT, SIM_USBD_HID_NS);
+    sim_usbd_period (0x81, SIM_USBD_HID_NS);
+    sim_usbd_host_in (test_host_in);
+    hid_custom_init (0, 0);
+    CHECK (TEST_RUN_WHILE (!sim_usbd_configured()));
+
+    test_ordered();
+    test_script();
+    test_coalesce();
+    test_lossy();
+    test_resume();
+    test_size();
+    test_v1();
+    ry_log_flush();
+    CHECK (strstr (sim_uart_text(), "upgrade result:0") != NULL);
+    CHECK (strstr (sim_uart_text(), "upgrade result:1") == NULL);
+    CHECK (strstr (sim_uart_text(), "bytes:150001/150001 time:") != NULL);  // 统计行不被其他日志拆开
+    CHECK (strstr (sim_uart_text(), "\r\ninstall program:") != NULL);
+    CHECK (strstr (sim_uart_text(), "log dropped") == NULL);
+}
+
+int main (void) {
+    return sim_test_run ("test_proto", test_body);
+}
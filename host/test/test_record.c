@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_test.h"
+#include "sim_w25q.h"
+#include "ry_record.h"
+#include <string.h>
+
+//--------------------------记录扇区------------------------------------
+// 1.连续追加多圈：每次追加后重新加载都得到最后一条记录，每次切换只擦除旧扇区一次
+// 2.模拟切换中途掉电（新扇区只有记录没有头、头不完整）：回退到旧扇区最后一条，
+//   下一次切换前擦除不空白的备用扇区，不在未擦除的位置编程
+// 3.模拟旧扇区擦除中途掉电：新扇区有效，旧扇区在下一次切换前擦除
+// 4.seq回绕：0比0xFFFFFFFF新
+//--------------------------------------------------------------------
+#define TEST_ADDR       (3 * 1024 * 1024)
+#define TEST_SLOTS      (FLASH_SECTOR_SIZE / sizeof (test_rec_t) - 1)  // 每个扇区的记录数
+
+typedef struct {
+    uint32_t value;
+    uint32_t pad[2];
+    uint32_t check;
+} test_rec_t;
+
+static uint8_t test_save[FLASH_SECTOR_SIZE];
+
+static ry_record_area test_area (void) {
+    ry_record_area area = {TEST_ADDR, sizeof (test_rec_t)};
+
+    return area;
+}
+
+/* 用新的area加载，模拟重新上电 */
+static uint32_t test_reload (void) {
+    ry_record_area area = test_area();
+    test_rec_t rec;
+
+    if (!ry_record_load (&area, &rec)) {
+        return 0;
+    }
+    return rec.value;
+}
+
+static void test_append (ry_record_area *area, uint32_t value) {
+    test_rec_t rec = {value};
+
+    CHECK_EQ (ry_record_append (area, &rec), HAL_OK);
+}
+
+static uint8_t *test_sector (uint8_t sector) {
+    return &sim_w25q_mem[TEST_ADDR + sector * FLASH_SECTOR_SIZE];
+}
+
+static void test_cycle (void) {
+    ry_record_area area = test_area();
+    test_rec_t rec;
+    uint32_t i, erases;
+
+    CHECK_EQ (ry_record_load (&area, &rec), 0);
+    CHECK_EQ (rec.value, 0);
+    erases = sim_w25q_stats.erase_4k;
+    for (i = 1; i <= 5 * TEST_SLOTS + 3; i++) {
+        test_append (&area, i);
+        CHECK_EQ (test_reload(), i);
+    }
+    // 第一次切换擦除初始的扇区1，之后每写满一个扇区擦除一次
+    CHECK_EQ (sim_w25q_stats.erase_4k - erases, 6);
+    CHECK_EQ (sim_w25q_stats.dirty_programs, 0);
+}
+
+/* 当前扇区写满，切换时在“掉电”处中止 */
+static void test_switch_fail (uint8_t head_bytes) {
+    ry_record_area area = test_area();
+    test_rec_t rec;
+    uint32_t last, i;
+    uint8_t spare;
+
+    ry_record_load (&area, &rec);
+    last = rec.value;
+    while (area.slot < FLASH_SECTOR_SIZE / sizeof (test_rec_t)) {
+        test_append (&area, ++last);
+    }
+    spare = area.sector ^ 1;
+    // 掉电前新扇区只写完了记录和head_bytes字节的头
+    memset (&rec, 0, sizeof (rec));
+    rec.value = last + 1;
+    rec.check = 0x12345678;
+    memcpy (test_sector (spare) + sizeof (test_rec_t), &rec, sizeof (rec));
+    {
+        uint32_t h[3] = {0x44524352, area.seq + 1, ~(area.seq + 1)};
+
+        memcpy (test_sector (spare), h, head_bytes);
+    }
+    CHECK_EQ (test_reload(), last);
+
+    area = test_area();
+    ry_record_load (&area, &rec);
+    CHECK (area.spare_dirty);
+    for (i = 1; i <= 3; i++) {
+        test_append (&area, last + i);
+        CHECK_EQ (test_reload(), last + i);
+    }
+    CHECK_EQ (sim_w25q_stats.dirty_programs, 0);
+}
+
+/* 切换完成，旧扇区擦除前掉电：旧扇区内容仍在 */
+static void test_erase_fail (void) {
+    ry_record_area area = test_area();
+    test_rec_t rec;
+    uint32_t last;
+    uint8_t old;
+
+    ry_record_load (&area, &rec);
+    last = rec.value;
+    while (area.slot < FLASH_SECTOR_SIZE / sizeof (test_rec_t)) {
+        test_append (&area, ++last);
+    }
+    old = area.sector;
+    memcpy (test_save, test_sector (old), FLASH_SECTOR_SIZE);
+    test_append (&area, ++last);
+    CHECK (area.sector != old);
+    while (sim_w25q_busy()) {
+        sim_advance (SIM_NS_PER_MS);
+    }
+    memcpy (test_sector (old), test_save, FLASH_SECTOR_SIZE);
+    CHECK_EQ (test_reload(), last);
+
+    area = test_area();
+    ry_record_load (&area, &rec);
+    CHECK (area.spare_dirty);
+    while (area.sector != old) {
+        test_append (&area, ++last);
+        CHECK_EQ (test_reload(), last);
+    }
+    CHECK_EQ (sim_w25q_stats.dirty_programs, 0);
+}
+
+static void test_seq_wrap (void) {
+    ry_record_area area = test_area();
+    test_rec_t rec;
+    uint32_t h[3];
+    uint32_t last;
+
+    ry_record_load (&area, &rec);
+    last = rec.value;
+    while (area.slot < FLASH_SECTOR_SIZE / sizeof (test_rec_t)) {
+        test_append (&area, ++last);
+    }
+    // 把当前扇区的seq改为0xFFFFFFFF（编程只能1->0，这里直接改仿真存储）
+    h[0] = 0x44524352;
+    h[1] = 0xFFFFFFFF;
+    h[2] = 0;
+    memcpy (test_sector (area.sector), h, sizeof (h));
+    area = test_area();
+    ry_record_load (&area, &rec);
+    CHECK_EQ (area.seq, 0xFFFFFFFF);
+    test_append (&area, ++last);
+    CHECK_EQ (area.seq, 0);
+    CHECK_EQ (test_reload(), last);
+}
+
+static void test_body (void) {
+    Flash_Init();
+    test_cycle();
+    test_switch_fail (0);
+    test_switch_fail (8);   // 头中没有~seq
+    test_switch_fail (12);  // 头完整：新扇区的记录校验错误，回退到旧扇区
+    test_erase_fail();
+    test_seq_wrap();
+}
+
+int main (void) {
+    return sim_test_run ("test_record", test_body);
+}
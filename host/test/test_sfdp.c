@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_test.h"
+#include "sim_w25q.h"
+#include "bsp_spi_flash.h"
+#include <string.h>
+
+//--------------------------SFDP解析------------------------------------
+// 三种板上用过的64Mbit芯片的SFDP区，按各自数据手册SFDP表整理（地址0起，未列出的字节为0xFF），
+// 以及不支持SFDP的老型号、BFPT不在第一个参数头、2^N形式容量的构造数据
+// 检查Flash_Info各字段、SPI3分频，以及切换到0x0B后读出的数据
+//--------------------------------------------------------------------
+typedef struct {
+    const char *name;
+    uint8_t id[3];
+    uint8_t sfdp[256];
+    uint32_t len;
+    uint8_t valid;
+    uint8_t lines;
+    uint32_t capacity;
+} test_chip_t;
+
+static const test_chip_t test_chips[] = {
+    {
+        "W25Q64JV", {0xEF, 0x40, 0x17},
+        {
+            0x53, 0x46, 0x44, 0x50, 0x05, 0x01, 0x00, 0xFF,  // SFDP 1.5，1个参数头
+            0x00, 0x05, 0x01, 0x10, 0x80, 0x00, 0x00, 0xFF,  // BFPT 1.5，16 DWORD @0x80
+            [0x10 ... 0x7F] = 0xFF,
+            0xE5, 0x20, 0xF9, 0xFF, 0xFF, 0xFF, 0xFF, 0x03, 0x44, 0xEB, 0x08, 0x6B, 0x08, 0x3B, 0x42, 0xBB,
+            0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0x40, 0xEB, 0x0C, 0x20, 0x0F, 0x52,
+            0x10, 0xD8, 0x00, 0x00, 0x36, 0x02, 0xA6, 0x00, 0x82, 0xEA, 0x14, 0xC4, 0xE9, 0x63, 0x76, 0x33,
+            0x7A, 0x75, 0x7A, 0x75, 0xF7, 0xA2, 0xD5, 0x5C, 0x19, 0xF7, 0x4D, 0xFF, 0xE9, 0x30, 0xF8, 0x80,
+        },
+        0xC0, 1, 4, 8 * 1024 * 1024,
+    },
+    {
+        "GD25Q64C", {0xC8, 0x40, 0x17},
+        {
+            0x53, 0x46, 0x44, 0x50, 0x00, 0x01, 0x01, 0xFF,  // SFDP 1.0，2个参数头
+            0x00, 0x00, 0x01, 0x09, 0x30, 0x00, 0x00, 0xFF,  // BFPT 1.0，9 DWORD @0x30
+            0xC8, 0x00, 0x01, 0x03, 0x60, 0x00, 0x00, 0xFF,  // 厂商参数表 @0x60
+            [0x18 ... 0x2F] = 0xFF,
+            0xE5, 0x20, 0xF1, 0xFF, 0xFF, 0xFF, 0xFF, 0x03, 0x44, 0xEB, 0x08, 0x6B, 0x08, 0x3B, 0x42, 0xBB,
+            0xEE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0xFF, 0x0C, 0x20, 0x0F, 0x52,
+            0x10, 0xD8, 0x00, 0xFF,
+            [0x54 ... 0x5F] = 0xFF,
+            0x00, 0x36, 0x00, 0x27, 0xF6, 0x9D, 0x00, 0x00, 0x81, 0x64, 0xCC, 0xFF,
+        },
+        0x6C, 1, 4, 8 * 1024 * 1024,
+    },
+    {
+        "XM25QH64C", {0x20, 0x40, 0x17},
+        {
+            0x53, 0x46, 0x44, 0x50, 0x00, 0x01, 0x01, 0xFF,
+            0x00, 0x00, 0x01, 0x09, 0x30, 0x00, 0x00, 0xFF,
+            0x20, 0x00, 0x01, 0x03, 0x60, 0x00, 0x00, 0xFF,
+            [0x18 ... 0x2F] = 0xFF,
+            0xE5, 0x20, 0xF1, 0xFF, 0xFF, 0xFF, 0xFF, 0x03, 0x44, 0xEB, 0x08, 0x6B, 0x08, 0x3B, 0x80, 0xBB,
+            0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0xFF, 0x44, 0xEB, 0x0C, 0x20, 0x0F, 0x52,
+            0x10, 0xD8, 0x00, 0xFF,
+            [0x54 ... 0x5F] = 0xFF,
+            0x00, 0x36, 0x00, 0x27, 0x9D, 0xF9, 0xC0, 0x64, 0x85, 0xCB, 0xFF, 0xFF,
+        },
+        0x6C, 1, 4, 8 * 1024 * 1024,
+    },
+    {
+        "no SFDP", {0xEF, 0x40, 0x17}, {0}, 0, 0, 1, 0,
+    },
+    {
+        /* 厂商参数头在前，BFPT只支持1-1-2，容量为2^N位形式（2^29位=64MB） */
+        "vendor first", {0xEF, 0x40, 0x19},
+        {
+            0x53, 0x46, 0x44, 0x50, 0x06, 0x01, 0x01, 0xFF,
+            0xEF, 0x00, 0x01, 0x02, 0x40, 0x00, 0x00, 0xFF,
+            0x00, 0x06, 0x01, 0x02, 0x50, 0x00, 0x00, 0xFF,
+            [0x18 ... 0x3F] = 0xFF,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            [0x48 ... 0x4F] = 0xFF,
+            0xE5, 0x20, 0x81, 0xFF, 0x1D, 0x00, 0x00, 0x80,
+        },
+        0x58, 1, 2, 64 * 1024 * 1024,
+    },
+    {
+        /* 签名正确但没有BFPT */
+        "no BFPT", {0xEF, 0x40, 0x17},
+        {
+            0x53, 0x46, 0x44, 0x50, 0x06, 0x01, 0x00, 0xFF,
+            0xEF, 0x00, 0x01, 0x02, 0x10, 0x00, 0x00, 0xFF,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        },
+        0x18, 0, 1, 0,
+    },
+};
+
+static uint8_t test_buf[4096];
+
+static void test_chip (const test_chip_t *chip) {
+    uint32_t i, prescaler;
+    const uint32_t addr = 0x123456;
+
+    sim_reset();
+    sim_w25q_id (chip->id[0], chip->id[1], chip->id[2]);
+    sim_w25q_sfdp (chip->sfdp, chip->len);
+    for (i = 0; i < sizeof (test_buf); i++) {
+        sim_w25q_mem[addr + i] = (uint8_t)(i * 31 + 7);
+    }
+    Flash_Info = (Flash_InfoTypeDef){0, W25X_ReadData, 0, 1, 0};
+
+    Flash_Init();
+    fprintf (stderr, "  %-12s valid %u cmd %02x dummy %u lines %u capacity %u\n", chip->name, Flash_Info.sfdp_valid,
+             Flash_Info.read_cmd, Flash_Info.read_dummy, Flash_Info.max_lines, (unsigned)Flash_Info.capacity);
+    CHECK_EQ (Flash_Info.sfdp_valid, chip->valid);
+    CHECK_EQ (Flash_Info.max_lines, chip->lines);
+    CHECK_EQ (Flash_Info.capacity, chip->capacity);
+    CHECK_EQ (Flash_Info.read_cmd, chip->valid ? W25X_FastReadData : W25X_ReadData);
+    CHECK_EQ (Flash_Info.read_dummy, chip->valid ? 1 : 0);
+
+    prescaler = SPI_FLASH_SPI->CTLR1 & SPI_BaudRatePrescaler_256;
+    CHECK_EQ (prescaler, chip->valid ? SPI_BaudRatePrescaler_2 : SPI_BaudRatePrescaler_4);
+    CHECK (SPI_FLASH_SPI->CTLR1 & 0x0040);  // SPE
+
+    /* 选定的读命令和空字节数与模型一致时数据才正确 */
+    memset (test_buf, 0, sizeof (test_buf));
+    CHECK_EQ (Flash_ReadData (addr, test_buf, sizeof (test_buf)), HAL_OK);
+    CHECK (memcmp (test_buf, &sim_w25q_mem[addr], sizeof (test_buf)) == 0);
+    CHECK_EQ (Flash_ReadData (addr + 3, test_buf, 5), HAL_OK);
+    CHECK (memcmp (test_buf, &sim_w25q_mem[addr + 3], 5) == 0);
+    CHECK_EQ (sim_stats.errors, 0);
+}
+
+static void test_body (void) {
+    uint32_t i;
+
+    for (i = 0; i < sizeof (test_chips) / sizeof (test_chips[0]); i++) {
+        test_chip (&test_chips[i]);
+    }
+}
+
+int main (void) {
+    return sim_test_run ("test_sfdp", test_body);
+}
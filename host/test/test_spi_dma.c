@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sim_test.h"
+#include "sim_w25q.h"
+#include "bsp_spi_flash.h"
+#include <string.h>
+
+//--------------------------SPI DMA分段和完成处理------------------------------------
+// 1.小于SPI_FLASH_DMA_MIN_SIZE轮询，其余按SPI_FLASH_DMA_MAX_CHUNK分段，
+//   分段数和数据都要正确（跨64KB边界的续传地址）
+// 2.Flash_ReadData_DMA()立即返回，传输期间再次启动返回HAL_BUSY，
+//   完成后中断拉高片选并清除忙标志
+// 3.DMA页编程写入的内容正确，模型没有发现擦除前写入或片选错误
+//--------------------------------------------------------------------
+#define TEST_BUF_SIZE   (200 * 1024)
+
+static uint8_t test_buf[TEST_BUF_SIZE + 16];
+static uint8_t test_pattern[4096];
+static uint32_t test_chunks (uint32_t size) {
+    if (size < SPI_FLASH_DMA_MIN_SIZE) {
+        return 0;
+    }
+    return (size + SPI_FLASH_DMA_MAX_CHUNK - 1) / SPI_FLASH_DMA_MAX_CHUNK;
+}
+
+static void test_read_sizes (void) {
+    static const uint32_t sizes[] = {1, 15, 16, 17, 256, 4096, 65534, 65535, 65536, 65537, 131070, 131071, TEST_BUF_SIZE};
+    uint32_t i, addr, chunks, dma_bytes;
+
+    for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+        addr = 0x12345 + i * 0x1000;
+        memset (test_buf, 0x5A, sizeof (test_buf));
+        chunks = sim_stats.spi_dma_chunks;
+        dma_bytes = sim_stats.spi_dma_bytes;
+
+        CHECK_EQ (Flash_ReadData (addr, test_buf, sizes[i]), HAL_OK);
+        CHECK (memcmp (test_buf, &sim_w25q_mem[addr], sizes[i]) == 0);
+        CHECK_EQ (test_buf[sizes[i]], 0x5A);  // 没有多写
+        CHECK_EQ (sim_stats.spi_dma_chunks - chunks, test_chunks (sizes[i]));
+        CHECK_EQ (sim_stats.spi_dma_bytes - dma_bytes, (sizes[i] < SPI_FLASH_DMA_MIN_SIZE) ? 0 : sizes[i]);
+        CHECK (!SPI_FLASH_DMA_Busy());
+        CHECK (GPIO_ReadOutputDataBit (SPI_FLASH_CS_PORT, SPI_FLASH_CS_PIN));
+    }
+}
+
+static void test_async (void) {
+    uint64_t start, byte_ns;
+    uint32_t size = 100000;
+
+    memset (test_buf, 0, sizeof (test_buf));
+    start = sim_now;
+    CHECK_EQ (Flash_ReadData_DMA (0x40000, test_buf, size), HAL_OK);
+    CHECK (SPI_FLASH_DMA_Busy());
+    CHECK (!GPIO_ReadOutputDataBit (SPI_FLASH_CS_PORT, SPI_FLASH_CS_PIN));
+    CHECK_EQ (Flash_ReadData_DMA (0x50000, test_buf, 32), HAL_BUSY);
+    CHECK_EQ (SPI_FLASH_DMA_Start (NULL, test_buf, 32), HAL_BUSY);
+
+    CHECK_EQ (SPI_FLASH_DMA_Wait(), HAL_OK);
+    CHECK (!SPI_FLASH_DMA_Busy());
+    CHECK (GPIO_ReadOutputDataBit (SPI_FLASH_CS_PORT, SPI_FLASH_CS_PIN));
+    CHECK (memcmp (test_buf, &sim_w25q_mem[0x40000], size) == 0);
+
+    /* 命令和地址轮询发送，数据阶段按SPI时钟连续传输 */
+    byte_ns = 8ULL * 4 * 1000000000ULL / (SystemCoreClock / 2);
+    CHECK (sim_now - start >= size * byte_ns);
+    CHECK (sim_now - start < size * byte_ns + 10 * SIM_NS_PER_US);
+}
+
+static void test_program (void) {
+    uint32_t i, addr = 0x80000;
+
+    for (i = 0; i < sizeof (test_pattern); i++) {
+        test_pattern[i] = (uint8_t)(i * 7 + 3);
+    }
+    CHECK_EQ (Flash_SectorErase (addr), HAL_OK);
+    FLASH_WriteData (addr + 5, test_pattern, 3000);  // 首页251字节，中间整页，末页不满
+    CHECK_EQ (Flash_WaitBusy(), HAL_OK);
+    CHECK (memcmp (&sim_w25q_mem[addr + 5], test_pattern, 3000) == 0);
+    CHECK_EQ (sim_w25q_mem[addr + 4], 0xFF);
+    CHECK_EQ (sim_w25q_mem[addr + 3005], 0xFF);
+    CHECK_EQ (sim_w25q_stats.page_programs, 12);
+    CHECK_EQ (sim_w25q_stats.dirty_programs, 0);
+    CHECK_EQ (sim_w25q_stats.busy_commands, 0);
+
+    /* 8字节的页编程走轮询路径 */
+    CHECK_EQ (Flash_PageProgram (addr + 3008, test_pattern, 8), HAL_OK);
+    CHECK_EQ (Flash_WaitBusy(), HAL_OK);
+    CHECK (memcmp (&sim_w25q_mem[addr + 3008], test_pattern, 8) == 0);
+}
+
+static void test_body (void) {
+    uint32_t i;
+
+    for (i = 0; i < 0x100000; i++) {
+        sim_w25q_mem[i] = (uint8_t)((i >> 8) ^ (i * 13));
+    }
+    Flash_Init();
+    CHECK_EQ (Flash_Info.sfdp_valid, 0);  // 模型默认没有SFDP，保持0x03读
+
+    test_read_sizes();
+    test_async();
+    test_program();
+}
+
+int main (void) {
+    return sim_test_run ("test_spi_dma", test_body);
+}
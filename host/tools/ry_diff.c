@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_diff.h"
+#include "ry_delta.h"
+#include "ry_proto.h"
+#include <string.h>
+
+#define RY_DIFF_HASH_BITS   16
+#define RY_DIFF_MIN_MATCH   4   // 哈希覆盖的字节数
+#define RY_DIFF_NONE        0xFFFFFFFF
+
+static uint8_t ry_diff_old[RY_DIFF_OLD_MAX];  // 按0xFF补齐的旧固件
+static uint32_t ry_diff_old_size;
+static uint32_t ry_diff_head[1 << RY_DIFF_HASH_BITS];
+static uint32_t ry_diff_prev[RY_DIFF_OLD_MAX];  // 同一哈希的前一个位置
+
+static uint32_t ry_diff_hash (const uint8_t *p) {
+    return ((p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24) * 2654435761u) >> (32 - RY_DIFF_HASH_BITS);
+}
+
+static void ry_diff_index (void) {
+    uint32_t i, h;
+
+    for (i = 0; i < (1 << RY_DIFF_HASH_BITS); i++) {
+        ry_diff_head[i] = RY_DIFF_NONE;
+    }
+    for (i = 0; i + RY_DIFF_MIN_MATCH <= ry_diff_old_size; i++) {
+        h = ry_diff_hash (&ry_diff_old[i]);
+        ry_diff_prev[i] = ry_diff_head[h];
+        ry_diff_head[h] = i;
+    }
+}
+
+/* 新固件scan处在旧固件中的最长匹配，*pos为旧固件中的位置 */
+static uint32_t ry_diff_search (const uint8_t *new_, uint32_t new_size, uint32_t scan, uint32_t *pos) {
+    uint32_t cand, n, best = 0, max = new_size - scan, chain = RY_DIFF_CHAIN;
+
+    if (max < RY_DIFF_MIN_MATCH) {
+        return 0;
+    }
+    for (cand = ry_diff_head[ry_diff_hash (&new_[scan])]; (cand != RY_DIFF_NONE) && chain--; cand = ry_diff_prev[cand]) {
+        for (n = 0; (n < max) && (cand + n < ry_diff_old_size) && (ry_diff_old[cand + n] == new_[scan + n]); n++) {
+        }
+        if (n > best) {
+            best = n;
+            *pos = cand;
+            if (n == max) {
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+/* 新固件i处与旧固件i + offset处相同 */
+static uint8_t ry_diff_same (const uint8_t *new_, uint32_t i, int64_t offset) {
+    int64_t j = (int64_t)i + offset;
+
+    return (j >= 0) && (j < ry_diff_old_size) && (ry_diff_old[j] == new_[i]);
+}
+
+static uint8_t *ry_diff_put32 (uint8_t *b, uint32_t v) {
+    b[0] = v;
+    b[1] = v >> 8;
+    b[2] = v >> 16;
+    b[3] = v >> 24;
+    return b + 4;
+}
+
+/**
+ * @brief  生成补丁
+ * @param  old_len，旧固件实际长度，补丁头中为补齐到4的倍数后的长度
+ * @param  out，补丁输出，out_max为其长度
+ * @retval 补丁长度，0：旧固件超过RY_DIFF_OLD_MAX、新固件为空或out不够
+ */
+uint32_t ry_diff_make (const uint8_t *old, uint32_t old_len, const uint8_t *new_, uint32_t new_size,
+                       uint8_t *out, uint32_t out_max) {
+    uint32_t scan = 0, len = 0, pos = 0, last_scan = 0, last_pos = 0, o, i;
+    uint32_t score, scsc, lenf, lenb, extra, overlap, lens;
+    int64_t last_offset = 0, s, best;
+    uint8_t *d;
+
+    ry_diff_old_size = (old_len + 3) & ~3u;
+    if ((ry_diff_old_size > RY_DIFF_OLD_MAX) || (new_size == 0) || (out_max < RY_DELTA_HEAD_SIZE)) {
+        return 0;
+    }
+    memcpy (ry_diff_old, old, old_len);
+    memset (&ry_diff_old[old_len], 0xFF, ry_diff_old_size - old_len);
+    ry_diff_index();
+
+    d = ry_diff_put32 (out, RY_DELTA_MAGIC);
+    d = ry_diff_put32 (d, ry_diff_old_size);
+    d = ry_diff_put32 (d, ry_proto_crc32 (ry_diff_old, ry_diff_old_size));
+    ry_diff_put32 (d, new_size);
+    o = RY_DELTA_HEAD_SIZE;
+
+    while (scan < new_size) {
+        // 找下一个明显好于当前对齐的匹配，score为当前对齐在匹配范围内的相同字节数
+        score = 0;
+        for (scsc = scan += len; scan < new_size; scan++) {
+            len = ry_diff_search (new_, new_size, scan, &pos);
+            for (; scsc < scan + len; scsc++) {
+                score += ry_diff_same (new_, scsc, last_offset);
+            }
+            if (((len == score) && (len != 0)) || (len > score + RY_DIFF_SLACK)) {
+                break;
+            }
+            if (ry_diff_same (new_, scan, last_offset)) {
+                score--;
+            }
+        }
+        if ((len == score) && (scan < new_size)) {
+            continue;  // 与当前对齐相同，继续沿用
+        }
+
+        // 上一条记录向前扩展：相同字节数*2 - 长度最大处
+        lenf = 0;
+        for (i = 0, s = 0, best = 0; (last_scan + i < scan) && (last_pos + i < ry_diff_old_size);) {
+            s += ry_diff_old[last_pos + i] == new_[last_scan + i];
+            i++;
+            if (s * 2 - i > best * 2 - lenf) {
+                best = s;
+                lenf = i;
+            }
+        }
+        // 本条记录向后扩展
+        lenb = 0;
+        if (scan < new_size) {
+            for (i = 1, s = 0, best = 0; (scan >= last_scan + i) && (pos >= i); i++) {
+                s += ry_diff_old[pos - i] == new_[scan - i];
+                if (s * 2 - i > best * 2 - lenb) {
+                    best = s;
+                    lenb = i;
+                }
+            }
+        } else {
+            pos = last_pos + lenf;  // 最后一条记录不再移动old_pos
+        }
+        // 两段重叠时在相同字节最多处分开
+        if (last_scan + lenf > scan - lenb) {
+            overlap = (last_scan + lenf) - (scan - lenb);
+            lens = 0;
+            for (i = 0, s = 0, best = 0; i < overlap; i++) {
+                s += new_[last_scan + lenf - overlap + i] == ry_diff_old[last_pos + lenf - overlap + i];
+                s -= new_[scan - lenb + i] == ry_diff_old[pos - lenb + i];
+                if (s > best) {
+                    best = s;
+                    lens = i + 1;
+                }
+            }
+            lenf += lens - overlap;
+            lenb -= lens;
+        }
+
+        extra = (scan - lenb) - (last_scan + lenf);
+        if (out_max - o < RY_DELTA_CTRL_SIZE + lenf + extra) {
+            return 0;
+        }
+        d = ry_diff_put32 (&out[o], lenf);
+        d = ry_diff_put32 (d, extra);
+        d = ry_diff_put32 (d, (uint32_t)((int64_t)(pos - lenb) - (int64_t)(last_pos + lenf)));
+        for (i = 0; i < lenf; i++) {
+            *d++ = new_[last_scan + i] - ry_diff_old[last_pos + i];
+        }
+        memcpy (d, &new_[last_scan + lenf], extra);
+        o += RY_DELTA_CTRL_SIZE + lenf + extra;
+
+        last_scan = scan - lenb;
+        last_pos = pos - lenb;
+        last_offset = (int64_t)pos - scan;
+    }
+    return o;
+}
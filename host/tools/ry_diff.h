@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_DIFF_H
+#define RY_DIFF_H
+
+#include <stdint.h>
+
+//--------------------------差分补丁生成端------------------------------------
+// 上位机一侧的差分，格式见User/ry_delta.h，输出用ry_delta_apply()应用
+// 1.旧固件按0xFF补齐到4的倍数（与APP区中擦除后的内容一致），补齐部分也参与匹配和CRC32
+// 2.按bsdiff的方法划分记录：新固件每个位置在旧固件中找最长完全匹配，
+//   比沿用上一条记录的对齐多出RY_DIFF_SLACK个相同字节以上时开始新记录；
+//   上一条记录向前、本条向后各自扩展为diff（相同字节多于一半的最长一段），中间为extra
+// 3.4字节哈希链查找旧固件中的候选位置，每个位置最多比较RY_DIFF_CHAIN个候选
+//--------------------------------------------------------------------
+#define RY_DIFF_OLD_MAX     (1024 * 1024)
+#define RY_DIFF_CHAIN       64
+#define RY_DIFF_SLACK       8
+
+uint32_t ry_diff_make(const uint8_t *old, uint32_t old_len, const uint8_t *new_, uint32_t new_size,
+                      uint8_t *out, uint32_t out_max);
+
+#endif /* RY_DIFF_H */
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_lzc.h"
+#include "ry_lz.h"
+
+#define RY_LZC_HASH_BITS    12
+#define RY_LZC_NONE         0xFFFFFFFF
+
+static uint32_t ry_lzc_head[1 << RY_LZC_HASH_BITS];
+static uint32_t ry_lzc_prev[RY_LZ_WINDOW];  // 同一哈希的前一个位置，按位置取模
+
+static uint32_t ry_lzc_hash (const uint8_t *p) {
+    return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - RY_LZC_HASH_BITS);
+}
+
+static void ry_lzc_insert (const uint8_t *in, uint32_t len, uint32_t i) {
+    uint32_t h;
+
+    if (i + RY_LZ_MIN_MATCH > len) {
+        return;
+    }
+    h = ry_lzc_hash (&in[i]);
+    ry_lzc_prev[i & (RY_LZ_WINDOW - 1)] = ry_lzc_head[h];
+    ry_lzc_head[h] = i;
+}
+
+/* 返回最长匹配长度，*dist为距离 */
+static uint32_t ry_lzc_match (const uint8_t *in, uint32_t len, uint32_t i, uint32_t *dist) {
+    uint32_t cand, next, n, best = 0, max = len - i, chain = RY_LZC_CHAIN;
+
+    if (max > RY_LZ_MAX_MATCH) {
+        max = RY_LZ_MAX_MATCH;
+    }
+    if (max < RY_LZ_MIN_MATCH) {
+        return 0;
+    }
+    cand = ry_lzc_head[ry_lzc_hash (&in[i])];
+    while ((cand != RY_LZC_NONE) && (i - cand <= RY_LZ_WINDOW) && chain--) {
+        for (n = 0; (n < max) && (in[cand + n] == in[i + n]); n++) {
+        }
+        if (n > best) {
+            best = n;
+            *dist = i - cand;
+            if (n == max) {
+                break;
+            }
+        }
+        next = ry_lzc_prev[cand & (RY_LZ_WINDOW - 1)];
+        if ((next == RY_LZC_NONE) || (next >= cand)) {
+            break;  // 槽位已被更新的位置覆盖
+        }
+        cand = next;
+    }
+    return best;
+}
+
+/**
+ * @brief  压缩一段数据
+ * @param  out，至少RY_LZC_BOUND(len)字节
+ * @retval 输出长度
+ */
+uint32_t ry_lzc_compress (const uint8_t *in, uint32_t len, uint8_t *out) {
+    uint32_t i = 0, o = 0, lit = 0, n, dist = 0, k;
+
+    for (k = 0; k < (1 << RY_LZC_HASH_BITS); k++) {
+        ry_lzc_head[k] = RY_LZC_NONE;
+    }
+    while (i < len) {
+        n = ry_lzc_match (in, len, i, &dist);
+        if (n < RY_LZ_MIN_MATCH) {
+            ry_lzc_insert (in, len, i);
+            i++;
+            lit++;
+            if ((lit == RY_LZ_MAX_LITERAL) || (i == len)) {
+                out[o++] = lit - 1;
+                for (k = i - lit; k < i; k++) {
+                    out[o++] = in[k];
+                }
+                lit = 0;
+            }
+            continue;
+        }
+        if (lit) {
+            out[o++] = lit - 1;
+            for (k = i - lit; k < i; k++) {
+                out[o++] = in[k];
+            }
+            lit = 0;
+        }
+        out[o++] = 0x80 | ((n - RY_LZ_MIN_MATCH) << 3) | ((dist - 1) >> 8);
+        out[o++] = (dist - 1) & 0xFF;
+        for (k = 0; k < n; k++) {
+            ry_lzc_insert (in, len, i + k);
+        }
+        i += n;
+    }
+    return o;
+}
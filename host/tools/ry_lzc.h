@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_LZC_H
+#define RY_LZC_H
+
+#include <stdint.h>
+
+//--------------------------LZ压缩端------------------------------------
+// 上位机一侧的压缩，格式见User/ry_lz.h，输出用ry_lz_decode()解码
+// 贪心：每个位置取窗口内最长匹配（相同长度取最近的），长度>=3时输出复制，否则并入字面量
+// 3字节哈希链查找候选位置，每个位置最多比较RY_LZC_CHAIN个候选
+//--------------------------------------------------------------------
+#define RY_LZC_CHAIN        256
+
+/* 最坏情况（没有匹配）的输出长度：每128字节字面量一个控制字节 */
+#define RY_LZC_BOUND(len)   ((len) + ((len) + 127) / 128)
+
+uint32_t ry_lzc_compress(const uint8_t *in, uint32_t len, uint8_t *out);
+
+#endif /* RY_LZC_H */
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ry_proto.h"
+#include <string.h>
+
+/**
+ * @brief  与ry_crc.h相同的CRC32：按小端32位字输入，不足一个字时补0xFF
+ */
+uint32_t ry_proto_crc32 (const uint8_t *data, uint32_t len) {
+    uint32_t crc = 0xFFFFFFFF, w, i;
+    int b;
+
+    for (i = 0; i < len; i += 4) {
+        w = 0xFFFFFFFF;
+        memcpy (&w, &data[i], (len - i < 4) ? len - i : 4);
+        crc ^= w;
+        for (b = 0; b < 32; b++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* SOF中有效数据前的CRC32、长度和镜像ID */
+static uint32_t ry_proto_prefix (const ry_proto_t *p) {
+    return ((p->flags & RY_PROTO_FLAG_CRC) ? 4 : 0) + ((p->flags & RY_PROTO_FLAG_SIZE) ? 4 : 0) +
+           ((p->flags & RY_PROTO_FLAG_RESUME) ? 4 : 0);
+}
+
+/* SOF之后第一个数据包的起点：续传时SOF不含数据 */
+static uint32_t ry_proto_base (const ry_proto_t *p) {
+    uint32_t first = RY_PROTO_PAYLOAD_MAX - ry_proto_prefix (p);
+
+    if (p->flags & RY_PROTO_FLAG_RESUME) {
+        return p->offset;
+    }
+    return (p->size < first) ? p->size : first;
+}
+
+static void ry_proto_total (ry_proto_t *p) {
+    uint32_t rest = p->size - ry_proto_base (p);
+
+    p->total = 1 + (rest + RY_PROTO_PAYLOAD_MAX - 1) / RY_PROTO_PAYLOAD_MAX;
+    if ((p->flags & RY_PROTO_FLAG_RESUME) && (rest == 0)) {
+        p->total = 2;  // 续传的数据包中才有EOF
+    }
+}
+
+static uint8_t *ry_proto_put32 (uint8_t *b, uint32_t v) {
+    b[0] = v;
+    b[1] = v >> 8;
+    b[2] = v >> 16;
+    b[3] = v >> 24;
+    return b + 4;
+}
+
+/**
+ * @brief  准备一次传输
+ * @param  flags，RY_PROTO_FLAG_LZ/RESUME/CRC/SIZE；CRC和镜像ID默认都是data的CRC32，长度默认为size，
+ *         续传使用其他ID、压缩数据使用解压后的CRC和长度时在begin之后修改p->id/crc/length
+ * @param  seq0，SOF的序号，主机每次传输可以从任意值开始
+ */
+void ry_proto_begin (ry_proto_t *p, uint16_t type, const uint8_t *data, uint32_t size, uint8_t flags, uint16_t seq0) {
+    memset (p, 0, sizeof (*p));
+    p->data = data;
+    p->size = size;
+    p->type = type;
+    p->flags = flags & (RY_PROTO_FLAG_LZ | RY_PROTO_FLAG_RESUME | RY_PROTO_FLAG_CRC | RY_PROTO_FLAG_SIZE);
+    p->seq0 = seq0;
+    p->window = 1;
+    p->crc = ry_proto_crc32 (data, size);
+    p->length = size;
+    p->id = p->crc;
+    ry_proto_total (p);
+}
+
+/**
+ * @brief  取下一个要发送的包
+ * @param  pkt，RY_PROTO_PACKET_SIZE字节
+ * @retval 0:没有可发送的包
+ */
+uint8_t ry_proto_next (ry_proto_t *p, uint8_t *pkt) {
+    uint32_t k = p->next, start, n;
+    uint8_t flags = 0, *d = &pkt[10];
+
+    if ((p->state != RY_PROTO_RUN) || (k >= p->total) || ((p->acked == 0) && (k > 0)) ||
+        (k - p->acked >= p->window)) {
+        return 0;
+    }
+    memset (pkt, 0, RY_PROTO_PACKET_SIZE);
+    if (k == 0) {
+        flags = RY_PROTO_FLAG_SOF | p->flags;
+        if (p->flags & RY_PROTO_FLAG_CRC) {
+            d = ry_proto_put32 (d, p->crc);
+        }
+        if (p->flags & RY_PROTO_FLAG_SIZE) {
+            d = ry_proto_put32 (d, p->length);
+        }
+        if (p->flags & RY_PROTO_FLAG_RESUME) {
+            d = ry_proto_put32 (d, p->id);
+        }
+        start = 0;
+        n = (p->flags & RY_PROTO_FLAG_RESUME) ? 0 : ry_proto_base (p);
+    } else {
+        start = ry_proto_base (p) + (k - 1) * RY_PROTO_PAYLOAD_MAX;
+        n = p->size - start;
+        if (n > RY_PROTO_PAYLOAD_MAX) {
+            n = RY_PROTO_PAYLOAD_MAX;
+        }
+    }
+    memcpy (d, &p->data[start], n);
+    n += d - &pkt[10];
+    if (k == p->total - 1) {
+        flags |= RY_PROTO_FLAG_EOF;
+    }
+
+    pkt[0] = RY_PROTO_REPORT_OUT;
+    pkt[1] = RY_PROTO_V2 >> 8;
+    pkt[2] = RY_PROTO_V2 & 0xFF;
+    pkt[3] = p->type >> 8;
+    pkt[4] = p->type;
+    pkt[5] = flags;
+    pkt[6] = (uint16_t)(p->seq0 + k) >> 8;
+    pkt[7] = (uint16_t)(p->seq0 + k);
+    pkt[8] = n >> 8;
+    pkt[9] = n;
+
+    p->stats.packets++;
+    if (k < p->sent) {
+        p->stats.retransmits++;
+    } else {
+        p->sent = k + 1;
+    }
+    p->next++;
+    return 1;
+}
+
+/**
+ * @brief  处理设备回复的ACK报告（报告ID 0x03）
+ */
+void ry_proto_ack (ry_proto_t *p, const uint8_t *report, uint32_t len) {
+    uint16_t d;
+
+    if ((len < 10) || (report[0] != RY_PROTO_REPORT_ACK) || (p->state != RY_PROTO_RUN)) {
+        return;
+    }
+    p->stats.acks++;
+    p->status = report[2];
+    if ((p->status == RY_PROTO_ACK_STATE) || (p->status == RY_PROTO_ACK_ERROR)) {
+        p->state = RY_PROTO_FAIL;
+        return;
+    }
+    if (p->status == RY_PROTO_ACK_DONE) {
+        p->acked = p->total;
+        p->next = p->total;
+        p->state = RY_PROTO_DONE;
+        return;
+    }
+    p->window = report[3] ? report[3] : 1;
+    d = ((report[4] << 8) | report[5]) - (uint16_t)(p->seq0 + p->acked);
+    if (d > p->sent - p->acked) {
+        return;  // 早于当前确认位置
+    }
+    if ((p->acked == 0) && d && (p->flags & RY_PROTO_FLAG_RESUME)) {
+        p->offset = report[6] << 24 | report[7] << 16 | report[8] << 8 | report[9];
+        if (p->offset > p->size) {
+            p->state = RY_PROTO_FAIL;
+            return;
+        }
+        ry_proto_total (p);
+    }
+
+    if (d) {
+        p->acked += d;
+        p->nak_rewound = 0;
+        if (d > p->stats.max_jump) {
+            p->stats.max_jump = d;
+        }
+        if (p->next < p->acked) {
+            p->next = p->acked;
+        }
+    }
+    if (p->status == RY_PROTO_ACK_NAK) {
+        p->stats.naks++;
+        if (!p->nak_rewound) {
+            p->next = p->acked;  // 回退N：从设备期望的序号重发
+            p->nak_rewound = 1;
+        }
+    } else if (d == 0) {
+        p->stats.dup_acks++;
+    }
+}
+
+/**
+ * @brief  超时没有收到ACK，从最早未确认的包重发
+ */
+void ry_proto_timeout (ry_proto_t *p) {
+    if (p->state != RY_PROTO_RUN) {
+        return;
+    }
+    p->stats.timeouts++;
+    p->next = p->acked;
+    p->nak_rewound = 0;
+}
+
+/**
+ * @brief  等待设备较长时间的处理：全部包已发出（设备可能在校验、安装），
+ *         或带长度的SOF已发出（设备在预擦除文件）
+ */
+uint8_t ry_proto_draining (const ry_proto_t *p) {
+    if (p->state != RY_PROTO_RUN) {
+        return 0;
+    }
+    if (p->acked == 0) {
+        return (p->next > 0) && (p->flags & RY_PROTO_FLAG_SIZE);
+    }
+    return p->next >= p->total;
+}
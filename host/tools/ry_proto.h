@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025, hugh-rymcu
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef RY_PROTO_H
+#define RY_PROTO_H
+
+#include <stdint.h>
+
+//--------------------------V2协议发送端------------------------------------
+// 上位机一侧的V2协议（格式见hid_custom.c），与传输方式无关（hidapi/WinUSB/仿真）：
+// 1.ry_proto_begin()准备一次传输，SOF发出后等待设备确认再发送数据包，
+//   SOF丢失或乱序时设备不会把后续包当作上一次传输的数据
+// 2.ry_proto_next()在窗口内取下一个要发送的包，窗口已满或等待确认时返回0
+// 3.收到的ACK报告交给ry_proto_ack()：累计确认推进窗口；NAK从设备期望的序号重发（回退N），
+//   同一位置的多个NAK只回退一次；DONE/ERROR/STATE结束传输
+// 4.调用者超过超时时间没有收到ACK时调用ry_proto_timeout()，从最早未确认的包重发；
+//   ry_proto_draining()为1时（全部包已发出后设备在安装固件，或带长度的SOF之后设备在预擦除）
+//   调用者应使用更长的超时
+// 5.续传：SOF只有镜像ID，设备回复的已接收字节数为续传起点，之后的数据包从该位置开始
+//--------------------------------------------------------------------
+#define RY_PROTO_PACKET_SIZE    1024
+#define RY_PROTO_PAYLOAD_MAX    1014
+#define RY_PROTO_V2             0x5202
+#define RY_PROTO_REPORT_OUT     0x01
+#define RY_PROTO_REPORT_ACK     0x03
+
+#define RY_PROTO_FLAG_SOF       0x01
+#define RY_PROTO_FLAG_EOF       0x02
+#define RY_PROTO_FLAG_LZ        0x04
+#define RY_PROTO_FLAG_RESUME    0x08
+#define RY_PROTO_FLAG_CRC       0x10
+#define RY_PROTO_FLAG_SIZE      0x20
+
+#define RY_PROTO_ACK_OK         0x00
+#define RY_PROTO_ACK_NAK        0x01
+#define RY_PROTO_ACK_STATE      0x02
+#define RY_PROTO_ACK_ERROR      0x03
+#define RY_PROTO_ACK_DONE       0x04
+
+typedef enum {
+    RY_PROTO_RUN = 0,
+    RY_PROTO_DONE,
+    RY_PROTO_FAIL
+} ry_proto_state;
+
+typedef struct {
+    uint32_t packets;       // 发送的包数（含重发）
+    uint32_t retransmits;
+    uint32_t acks;
+    uint32_t naks;
+    uint32_t dup_acks;      // 没有推进窗口的OK，设备收到重复包时回复
+    uint32_t timeouts;
+    uint32_t max_jump;      // 一次ACK确认的最多包数，IN端点忙时多个ACK合并
+} ry_proto_stats_t;
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t size;
+    uint32_t offset;        // 数据包的起点，续传时由设备回复
+    uint32_t crc;
+    uint32_t length;        // SIZE中的最终长度
+    uint32_t id;
+    uint16_t type;
+    uint16_t seq0;          // SOF的序号
+    uint8_t flags;          // LZ/RESUME/CRC/SIZE
+    uint8_t window;
+    uint8_t state;
+    uint8_t status;         // 最后一个ACK的状态
+    uint8_t nak_rewound;    // 当前确认位置已按NAK回退
+    uint32_t total;         // 包数（含SOF），续传时SOF确认后确定
+    uint32_t next;          // 下一个要发送的包
+    uint32_t sent;          // 发出过的包数，next小于它时为重发
+    uint32_t acked;         // 已确认的包数
+    ry_proto_stats_t stats;
+} ry_proto_t;
+
+void ry_proto_begin(ry_proto_t *p, uint16_t type, const uint8_t *data, uint32_t size, uint8_t flags, uint16_t seq0);
+uint8_t ry_proto_next(ry_proto_t *p, uint8_t *pkt);
+void ry_proto_ack(ry_proto_t *p, const uint8_t *report, uint32_t len);
+void ry_proto_timeout(ry_proto_t *p);
+uint8_t ry_proto_draining(const ry_proto_t *p);
+uint32_t ry_proto_crc32(const uint8_t *data, uint32_t len);
+
+#endif /* RY_PROTO_H */